@@ -0,0 +1,226 @@
+#include <my_malloc.h>
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 256U))
+
+// the blocks are allocated in batches, the batch is freed outside of the measurement, it is smaller
+// for large sizes, so that all threads fit into the fixed pool of my_malloc.c
+#define MAX_BATCH_SIZE 1024U
+
+#if defined(_ALLOCATOR_NOT_MT_SAVE)
+#define MAX_THREADS 1
+#else
+#define MAX_THREADS 8
+#endif
+
+static uint32_t batch_size(uint64_t size) {
+	return (uint32_t)std::clamp<uint64_t>(POOL_SIZE / 4 / MAX_THREADS / (size + 64), 16,
+	                                      MAX_BATCH_SIZE);
+}
+
+static void free_all(std::vector<void*>& blocks) {
+	for(void*& block : blocks) {
+		if(block != nullptr) {
+			my_free(block);
+			block = nullptr;
+		}
+	}
+}
+
+// allocates every block, returns false, if the allocator is out of memory
+static bool allocate_all(benchmark::State& state, std::vector<void*>& blocks, uint64_t size) {
+	for(void*& block : blocks) {
+		block = my_malloc(size);
+		if(block == nullptr) {
+			state.SkipWithError("the allocator is out of memory");
+			return false;
+		}
+	}
+
+	return true;
+}
+
+// malloc of one size class
+static void BM_Malloc(benchmark::State& state) {
+	const uint64_t size = state.range(0);
+	std::vector<void*> blocks(batch_size(size), nullptr);
+	size_t next = 0;
+
+	for(auto _ : state) {
+		void* block = my_malloc(size);
+		if(block == nullptr) {
+			state.SkipWithError("the allocator is out of memory");
+			break;
+		}
+		benchmark::DoNotOptimize(block);
+		blocks[next++] = block;
+
+		if(next == blocks.size()) {
+			state.PauseTiming();
+			free_all(blocks);
+			next = 0;
+			state.ResumeTiming();
+		}
+	}
+
+	free_all(blocks);
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_Malloc)
+    ->RangeMultiplier(8)
+    ->Range(16, 64 << 10)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+
+// malloc and free of one block, the common case of short lived objects
+static void BM_MallocFree(benchmark::State& state) {
+	const uint64_t size = state.range(0);
+
+	for(auto _ : state) {
+		void* block = my_malloc(size);
+		if(block == nullptr) {
+			state.SkipWithError("the allocator is out of memory");
+			break;
+		}
+		benchmark::DoNotOptimize(block);
+		my_free(block);
+	}
+
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK(BM_MallocFree)
+    ->RangeMultiplier(8)
+    ->Range(16, 64 << 10)
+    ->ThreadRange(1, MAX_THREADS)
+    ->UseRealTime();
+
+// free of blocks, that are allocated in a row, the even blocks are measured, with coalesce, the odd
+// blocks are freed before, so every measured free merges the block with both neighbours, without
+// it, both neighbours are still allocated. This relies on the blocks of one batch being adjacent,
+// so it is only run on one thread
+static void BM_Free(benchmark::State& state, bool coalesce) {
+	const uint64_t size = state.range(0);
+	std::vector<void*> blocks(2 * (size_t)batch_size(size) + 1, nullptr);
+	// the first and the last block have only one neighbour, so they aren't measured
+	size_t next = blocks.size() - 1;
+
+	for(auto _ : state) {
+		if(next == blocks.size() - 1) {
+			state.PauseTiming();
+			free_all(blocks);
+			if(!allocate_all(state, blocks, size)) {
+				break;
+			}
+			if(coalesce) {
+				for(size_t i = 1; i < blocks.size(); i += 2) {
+					my_free(blocks[i]);
+					blocks[i] = nullptr;
+				}
+			}
+			next = 2;
+			state.ResumeTiming();
+		}
+
+		my_free(blocks[next]);
+		blocks[next] = nullptr;
+		next += 2;
+	}
+
+	free_all(blocks);
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_Free, without_coalescing, false)->RangeMultiplier(8)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_Free, with_coalescing, true)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+#ifdef _WITH_REALLOC
+
+// realloc to the double size, every block is followed by a block of the same size, with in_place
+// that one is freed before, so the block can grow into it, otherwise it stays allocated, so the
+// block has to be moved
+static void BM_ReallocGrow(benchmark::State& state, bool in_place) {
+	const uint64_t size = state.range(0);
+	std::vector<void*> blocks(2 * (size_t)batch_size(2 * size), nullptr);
+	size_t next = blocks.size();
+
+	for(auto _ : state) {
+		if(next == blocks.size()) {
+			state.PauseTiming();
+			free_all(blocks);
+			if(!allocate_all(state, blocks, size)) {
+				break;
+			}
+			if(in_place) {
+				for(size_t i = 1; i < blocks.size(); i += 2) {
+					my_free(blocks[i]);
+					blocks[i] = nullptr;
+				}
+			}
+			next = 0;
+			state.ResumeTiming();
+		}
+
+		void* block = my_realloc(blocks[next], 2 * size);
+		if(block == nullptr) {
+			state.SkipWithError("the allocator is out of memory");
+			break;
+		}
+		blocks[next] = block;
+		next += 2;
+	}
+
+	free_all(blocks);
+	state.SetItemsProcessed(state.iterations());
+}
+
+BENCHMARK_CAPTURE(BM_ReallocGrow, in_place, true)->RangeMultiplier(8)->Range(16, 64 << 10);
+BENCHMARK_CAPTURE(BM_ReallocGrow, move, false)->RangeMultiplier(8)->Range(16, 64 << 10);
+
+#endif
+
+// the first malloc after my_allocator_init, the argument is force_alloc, without it, the first
+// malloc maps the memory (my_malloc.c always maps it in the init)
+static void BM_FirstMallocAfterInit(benchmark::State& state) {
+	const bool force_alloc = state.range(0) != 0;
+
+	for(auto _ : state) {
+		state.PauseTiming();
+		my_allocator_destroy();
+		my_allocator_init(POOL_SIZE, force_alloc);
+		state.ResumeTiming();
+
+		void* block = my_malloc(64);
+		benchmark::DoNotOptimize(block);
+
+		state.PauseTiming();
+		my_free(block);
+		state.ResumeTiming();
+	}
+
+	// the following benchmarks use an initialized allocator again
+	my_allocator_destroy();
+	my_allocator_init(POOL_SIZE, true);
+}
+
+BENCHMARK(BM_FirstMallocAfterInit)->ArgName("force_alloc")->Arg(1)->Arg(0);
+
+int main(int argc, char** argv) {
+	my_allocator_init(POOL_SIZE, true);
+
+	benchmark::Initialize(&argc, argv);
+	if(benchmark::ReportUnrecognizedArguments(argc, argv)) {
+		return 1;
+	}
+	benchmark::RunSpecifiedBenchmarks();
+	benchmark::Shutdown();
+
+	my_allocator_destroy();
+	return 0;
+}
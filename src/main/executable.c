@@ -13,7 +13,9 @@ Author: Totto16
 
 // prints the usage, if argc is not the right amount!
 void printUsage(const char* programName) {
-	printf("usage: %s --<mode>\n\t mode: test, bench, realloc, all\n", programName);
+	printf("usage: %s --<mode> [options]\n\t mode: test, bench, bench=<scenario>, realloc, all\n",
+	       programName);
+	print_membench_usage();
 }
 
 // this main executes the tests and the membench, it has to be linked with the three .c files it
@@ -21,19 +23,24 @@ void printUsage(const char* programName) {
 // you can choose which mode to run with the command line parameter
 int main(int argc, char const* argv[]) {
 
-	if(argc != 2) {
+	if(argc < 2) {
 		printUsage(argv[0]);
 		exit(EXIT_FAILURE);
 	}
 
 	const char* mode = argv[1];
 	unsigned char modeMap = 0;
+	membench_options options;
+	membench_default_options(&options);
 
 	if(strcmp(mode, "--test") == 0) {
 		modeMap = 1; // 0b001
 
 	} else if(strcmp(mode, "--bench") == 0) {
 		modeMap = 2; // 0b010
+	} else if(strncmp(mode, "--bench=", 8) == 0) {
+		modeMap = 2; // 0b010
+		options.scenario = mode + 8;
 	} else if(strcmp(mode, "--realloc") == 0) {
 		modeMap = 4; // 0b100
 	} else if(strcmp(mode, "--all") == 0) {
@@ -43,6 +50,14 @@ int main(int argc, char const* argv[]) {
 		exit(EXIT_FAILURE);
 	}
 
+	// the remaining arguments are options of the benchmark
+	for(int i = 2; i < argc; ++i) {
+		if(!parse_membench_option(argv[i], &options)) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
+	}
+
 	if(modeMap & 1) { // 0b001
 		printf("Now testing the free list allocator:\n");
 		test_best_fit_allocator();
@@ -56,13 +71,28 @@ int main(int argc, char const* argv[]) {
 #endif
 
 	if(modeMap & 2) { // 0b010
-		printf("Now running the memory benchmark:\n");
+		if(options.format == MEMBENCH_FORMAT_TEXT) {
+			printf("Now running the memory benchmark:\n");
+		}
+
+		const bool success = run_membench(my_allocator_init, my_allocator_destroy, my_malloc,
+		                                  my_free,
+#ifdef _WITH_REALLOC
+		                                  my_realloc,
+#else
+		                                  NULL,
+#endif
 #if defined(_PER_THREAD_ALLOCATOR) && _PER_THREAD_ALLOCATOR == 1
-		run_membench_thread_local
+		                                  true,
 #else
-		run_membench_global
+		                                  false,
 #endif
-		    (my_allocator_init, my_allocator_destroy, my_malloc, my_free);
+		                                  &options);
+
+		if(!success) {
+			printUsage(argv[0]);
+			exit(EXIT_FAILURE);
+		}
 	}
 
 	return EXIT_SUCCESS;
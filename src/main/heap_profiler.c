@@ -0,0 +1,466 @@
+/*
+Author: Totto16
+*/
+
+// a sampling heap profiler, roughly every sample rate allocated bytes (the distance between two
+// samples is exponentially distributed, so that every byte has the same chance to be sampled) the
+// backtrace of the allocation is recorded, the output is the legacy text format of gperftools
+// ("heap_v2"), that pprof can read, e.g.: pprof --text ./program heap.prof
+
+#include <execinfo.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils.h>
+
+#include "heap_profiler.h"
+#include "my_malloc.h"
+
+// the maximum number of frames of a recorded backtrace
+#define PROFILE_MAX_DEPTH 32
+
+// the number of different backtraces and of live samples, that can be recorded, both are hash
+// tables with open addressing, so these have to be powers of two, if they are full, samples are
+// dropped
+#define PROFILE_STACK_SLOTS ((uint64_t)4096)
+#define PROFILE_SAMPLE_SLOTS ((uint64_t)65536)
+
+// the ptr of a removed sample, so that the probing doesn't stop there
+#define PROFILE_REMOVED_SAMPLE ((void*)1)
+
+// a unique backtrace, with the live and the cumulative (since the start) sampled allocations
+typedef struct {
+	uint64_t hash; // 0 if this slot is empty
+	uint32_t depth;
+	void* frames[PROFILE_MAX_DEPTH];
+	uint64_t liveCount;
+	uint64_t liveBytes;
+	uint64_t totalCount;
+	uint64_t totalBytes;
+} ProfileStack;
+
+typedef struct {
+	void* ptr; // NULL if this slot is empty
+	uint64_t size;
+	uint64_t stack;
+} ProfileSample;
+
+_Atomic uint64_t __my_malloc_profileSampleRate = 0;
+
+// the tables are mapped directly, so that the profiler never calls the allocator, that it profiles,
+// they are only accessed with this mutex locked
+static ProfileStack* __my_malloc_profileStacks = NULL;
+static ProfileSample* __my_malloc_profileSamples = NULL;
+static pthread_mutex_t __my_malloc_profileMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// the sample rate of the last run, it isn't reset by stopping, so that a dump after that has the
+// rate of the samples in its header, it is only accessed with the mutex locked
+static uint64_t __my_malloc_profileLastRate = 0;
+
+// every thread counts down the bytes until its next sample, the random state is 0, until the
+// thread allocated the first time with a running profiler
+static _Thread_local int64_t __my_malloc_profileBytesUntilSample = 0;
+static _Thread_local uint64_t __my_malloc_profileRandomState = 0;
+
+// backtrace may allocate itself, these allocations are never sampled
+static _Thread_local bool __my_malloc_profileInside = false;
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * xorshift64*, that is enough for sampling
+ */
+static uint64_t __my_malloc_profile_random(void) {
+	uint64_t state = __my_malloc_profileRandomState;
+	state ^= state >> 12;
+	state ^= state << 25;
+	state ^= state >> 27;
+	__my_malloc_profileRandomState = state;
+	return state * 0x2545F4914F6CDD1DULL;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the next distance between two samples, that is -ln(u) * rate for an uniform u in
+ * (0, 1], the logarithm is approximated from the exponent and the mantissa of the double, so that
+ * libm isn't needed, the error is below 1%
+ */
+static int64_t __my_malloc_profile_next_distance(uint64_t rate) {
+
+	// 53 random bits, + 1 so that it is never 0
+	const double uniform = (double)((__my_malloc_profile_random() >> 11) + 1) / 9007199254740992.0;
+
+	uint64_t bits;
+	memcpy(&bits, &uniform, sizeof(bits));
+
+	const int64_t exponent = (int64_t)((bits >> 52) & 0x7FF) - 1023;
+
+	bits = (bits & 0x000FFFFFFFFFFFFFULL) | 0x3FF0000000000000ULL;
+	double mantissa;
+	memcpy(&mantissa, &bits, sizeof(mantissa));
+
+	// log2 of the mantissa in [1, 2) with a quadratic approximation
+	const double fraction = mantissa - 1.0;
+	const double log2Value = (double)exponent + fraction * (1.3465553 - 0.3465553 * fraction);
+
+	const double distance = -log2Value * 0.6931471805599453 * (double)rate;
+
+	return distance < 1.0 ? 1 : (int64_t)distance;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the slot of the backtrace, inserts it, if it isn't in there, UINT64_MAX if the table is
+ * full
+ *
+ * @note Needs to be called with the mutex locked
+ */
+static uint64_t __my_malloc_profile_stack_slot(void** frames, uint32_t depth) {
+
+	// FNV-1a over the frames, never 0, since that marks an empty slot
+	uint64_t hash = 0xCBF29CE484222325ULL;
+	for(uint32_t i = 0; i < depth; ++i) {
+		hash = (hash ^ (uint64_t)(uintptr_t)frames[i]) * 0x100000001B3ULL;
+	}
+	hash |= 1;
+
+	for(uint64_t probe = 0; probe < PROFILE_STACK_SLOTS; ++probe) {
+		const uint64_t slot = (hash + probe) & (PROFILE_STACK_SLOTS - 1);
+		ProfileStack* stack = &__my_malloc_profileStacks[slot];
+
+		if(stack->hash == 0) {
+			stack->hash = hash;
+			stack->depth = depth;
+			memcpy(stack->frames, frames, depth * sizeof(void*));
+			return slot;
+		}
+
+		if(stack->hash == hash && stack->depth == depth &&
+		   memcmp(stack->frames, frames, depth * sizeof(void*)) == 0) {
+			return slot;
+		}
+	}
+
+	return UINT64_MAX;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the first slot, that has to be probed for the pointer
+ */
+static inline uint64_t __my_malloc_profile_sample_hash(void* ptr) {
+	return (((uint64_t)(uintptr_t)ptr >> 4) * 0x9E3779B97F4A7C15ULL) >> 16;
+}
+
+bool __my_malloc_profile_allocation(void* ptr, uint64_t size) {
+
+	const uint64_t rate =
+	    atomic_load_explicit(&__my_malloc_profileSampleRate, memory_order_relaxed);
+
+	if(__my_malloc_profileInside || rate == 0 || ptr == NULL) {
+		return false;
+	}
+
+	if(__my_malloc_profileRandomState == 0) {
+		struct timespec now;
+		clock_gettime(CLOCK_MONOTONIC, &now);
+		__my_malloc_profileRandomState =
+		    ((uint64_t)(uintptr_t)&__my_malloc_profileRandomState ^ (uint64_t)now.tv_nsec) | 1;
+		__my_malloc_profileBytesUntilSample = __my_malloc_profile_next_distance(rate);
+	}
+
+	__my_malloc_profileBytesUntilSample -= (int64_t)size;
+
+	if(__my_malloc_profileBytesUntilSample > 0) {
+		return false;
+	}
+
+	__my_malloc_profileBytesUntilSample = __my_malloc_profile_next_distance(rate);
+
+	__my_malloc_profileInside = true;
+
+	// the first frame is this function, it is skipped
+	void* frames[PROFILE_MAX_DEPTH + 1];
+	const int depth = backtrace(frames, PROFILE_MAX_DEPTH + 1);
+
+	__my_malloc_profileInside = false;
+
+	if(depth <= 1) {
+		return false;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the heap profiler");
+
+	bool recorded = false;
+
+	const uint64_t stackSlot = __my_malloc_profile_stack_slot(frames + 1, (uint32_t)(depth - 1));
+
+	if(stackSlot != UINT64_MAX) {
+		const uint64_t hash = __my_malloc_profile_sample_hash(ptr);
+
+		for(uint64_t probe = 0; probe < PROFILE_SAMPLE_SLOTS; ++probe) {
+			ProfileSample* sample =
+			    &__my_malloc_profileSamples[(hash + probe) & (PROFILE_SAMPLE_SLOTS - 1)];
+
+			if(sample->ptr == NULL || sample->ptr == PROFILE_REMOVED_SAMPLE) {
+				sample->ptr = ptr;
+				sample->size = size;
+				sample->stack = stackSlot;
+				recorded = true;
+				break;
+			}
+		}
+	}
+
+	// if one of the tables is full, the sample is dropped
+	if(recorded) {
+		ProfileStack* stack = &__my_malloc_profileStacks[stackSlot];
+		stack->liveCount++;
+		stack->liveBytes += size;
+		stack->totalCount++;
+		stack->totalBytes += size;
+	}
+
+	result = pthread_mutex_unlock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the heap profiler");
+
+	return recorded;
+}
+
+void __my_malloc_profile_free(void* ptr) {
+
+	int result = pthread_mutex_lock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the heap profiler");
+
+	const uint64_t hash = __my_malloc_profile_sample_hash(ptr);
+
+	for(uint64_t probe = 0; probe < PROFILE_SAMPLE_SLOTS; ++probe) {
+		ProfileSample* sample =
+		    &__my_malloc_profileSamples[(hash + probe) & (PROFILE_SAMPLE_SLOTS - 1)];
+
+		if(sample->ptr == NULL) {
+			break;
+		}
+
+		if(sample->ptr == ptr) {
+			ProfileStack* stack = &__my_malloc_profileStacks[sample->stack];
+			stack->liveCount--;
+			stack->liveBytes -= sample->size;
+
+			sample->ptr = PROFILE_REMOVED_SAMPLE;
+			break;
+		}
+	}
+
+	result = pthread_mutex_unlock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the heap profiler");
+}
+
+void __my_malloc_profile_fork_prepare(void) {
+	int result = pthread_mutex_lock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the heap profiler");
+}
+
+void __my_malloc_profile_fork_parent(void) {
+	int result = pthread_mutex_unlock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the heap profiler");
+}
+
+void __my_malloc_profile_fork_child(void) {
+	int result = pthread_mutex_init(&__my_malloc_profileMutex, NULL);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to initialize the mutex of the heap profiler");
+}
+
+/**
+ * @brief starts sampling roughly every sample_rate allocated bytes, 0 stops it. The recorded
+ * samples are kept, if the profiler is stopped and started again. If the tables can't be mapped,
+ * the program crashes
+ *
+ * @note MT-safe
+ */
+void my_heap_profile_start(uint64_t sample_rate) {
+
+	if(sample_rate == 0) {
+		my_heap_profile_stop();
+		return;
+	}
+
+	// the first call of backtrace loads libgcc, that allocates, so it isn't done the first time in
+	// the middle of a sample
+	void* frames[1];
+	backtrace(frames, 1);
+
+	int result = pthread_mutex_lock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the heap profiler");
+
+	if(__my_malloc_profileStacks == NULL) {
+		void* stacks = mmap(NULL, PROFILE_STACK_SLOTS * sizeof(ProfileStack),
+		                    PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+		void* samples = mmap(NULL, PROFILE_SAMPLE_SLOTS * sizeof(ProfileSample),
+		                     PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+		if(stacks == MAP_FAILED || samples == MAP_FAILED) {
+			printErrorAndExit("ERROR: Failed to allocate memory for the heap profiler: %s\n",
+			                  strerror(errno));
+		}
+
+		__my_malloc_profileStacks = (ProfileStack*)stacks;
+		__my_malloc_profileSamples = (ProfileSample*)samples;
+	}
+
+	__my_malloc_profileLastRate = sample_rate;
+	atomic_store_explicit(&__my_malloc_profileSampleRate, sample_rate, memory_order_relaxed);
+
+	result = pthread_mutex_unlock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the heap profiler");
+}
+
+/**
+ * @brief stops sampling, blocks, that were sampled before, are still removed from the profile, when
+ * they are freed
+ *
+ * @note MT-safe
+ */
+void my_heap_profile_stop(void) {
+	atomic_store_explicit(&__my_malloc_profileSampleRate, 0, memory_order_relaxed);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * writes everything, returns false on an error
+ */
+static bool __my_malloc_profile_write(int fd, const char* buffer, size_t length) {
+	while(length > 0) {
+		const ssize_t written = write(fd, buffer, length);
+
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
+
+		buffer += written;
+		length -= (size_t)written;
+	}
+
+	return true;
+}
+
+/**
+ * @brief writes the live (in use) and the cumulative sampled allocations to path, in the legacy
+ * heap profile format of gperftools, that pprof understands, the values aren't scaled, pprof does
+ * that with the sample rate in the header. Returns 0 on success, otherwise -1 and errno is set
+ *
+ * @note MT-safe, it doesn't allocate, so it can be called at any time
+ */
+int my_heap_profile_dump(const char* path) {
+
+	const int fd = open(path, O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if(fd < 0) {
+		return -1;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the heap profiler");
+
+	uint64_t liveCount = 0;
+	uint64_t liveBytes = 0;
+	uint64_t totalCount = 0;
+	uint64_t totalBytes = 0;
+
+	for(uint64_t i = 0; __my_malloc_profileStacks != NULL && i < PROFILE_STACK_SLOTS; ++i) {
+		liveCount += __my_malloc_profileStacks[i].liveCount;
+		liveBytes += __my_malloc_profileStacks[i].liveBytes;
+		totalCount += __my_malloc_profileStacks[i].totalCount;
+		totalBytes += __my_malloc_profileStacks[i].totalBytes;
+	}
+
+	// the rate of the last run, the samples of earlier runs with another rate are scaled wrong
+	const uint64_t rate = __my_malloc_profileLastRate;
+
+	char buffer[128 + (PROFILE_MAX_DEPTH * 24)];
+
+	int length = snprintf(buffer, sizeof(buffer),
+	                      "heap profile: %lu: %lu [%lu: %lu] @ heap_v2/%lu\n", liveCount, liveBytes,
+	                      totalCount, totalBytes, rate == 0 ? 1 : rate);
+
+	bool success = __my_malloc_profile_write(fd, buffer, (size_t)length);
+
+	for(uint64_t i = 0; success && __my_malloc_profileStacks != NULL && i < PROFILE_STACK_SLOTS;
+	    ++i) {
+		const ProfileStack* stack = &__my_malloc_profileStacks[i];
+
+		if(stack->hash == 0) {
+			continue;
+		}
+
+		length = snprintf(buffer, sizeof(buffer), "%lu: %lu [%lu: %lu] @", stack->liveCount,
+		                  stack->liveBytes, stack->totalCount, stack->totalBytes);
+
+		for(uint32_t frame = 0; frame < stack->depth; ++frame) {
+			length += snprintf(buffer + length, sizeof(buffer) - (size_t)length, " %p",
+			                   stack->frames[frame]);
+		}
+
+		length += snprintf(buffer + length, sizeof(buffer) - (size_t)length, "\n");
+
+		success = __my_malloc_profile_write(fd, buffer, (size_t)length);
+	}
+
+	result = pthread_mutex_unlock(&__my_malloc_profileMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the heap profiler");
+
+	// pprof needs the mappings, to symbolize the addresses
+	const char* mappedLibraries = "\nMAPPED_LIBRARIES:\n";
+	success = success && __my_malloc_profile_write(fd, mappedLibraries, strlen(mappedLibraries));
+
+	const int mapsFd = open("/proc/self/maps", O_RDONLY | O_CLOEXEC);
+
+	if(mapsFd >= 0) {
+		char mapsBuffer[4096];
+		ssize_t readBytes;
+
+		while(success && (readBytes = read(mapsFd, mapsBuffer, sizeof(mapsBuffer))) > 0) {
+			success = __my_malloc_profile_write(fd, mapsBuffer, (size_t)readBytes);
+		}
+
+		close(mapsFd);
+	}
+
+	const int savedErrno = errno;
+	close(fd);
+
+	if(!success) {
+		errno = savedErrno;
+		return -1;
+	}
+
+	return 0;
+}
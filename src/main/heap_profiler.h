@@ -0,0 +1,48 @@
+// header guard
+#ifndef _MY_MALLOC_HEAP_PROFILER_H_
+#define _MY_MALLOC_HEAP_PROFILER_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+// the internal interface between the allocator and the sampling heap profiler, the public functions
+// (my_heap_profile_start, my_heap_profile_stop, my_heap_profile_dump) are declared in my_malloc.h
+
+// the average number of bytes between two samples, 0 if the profiler is stopped
+extern _Atomic uint64_t __my_malloc_profileSampleRate;
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * this is the only thing, that is done on every allocation, if the profiler is stopped
+ */
+static inline bool __my_malloc_profile_enabled(void) {
+	return __builtin_expect(
+	    atomic_load_explicit(&__my_malloc_profileSampleRate, memory_order_relaxed) != 0, 0);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * counts the allocation, and records it with a backtrace, if it is sampled, returns true in that
+ * case, then the allocator has to mark the block, so that __my_malloc_profile_free is called, when
+ * it is freed
+ *
+ * @note has to be called without the mutex of the allocator locked, since backtrace may allocate
+ */
+bool __my_malloc_profile_allocation(void* ptr, uint64_t size);
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * removes a sampled block from the live allocations of the profile
+ */
+void __my_malloc_profile_free(void* ptr);
+
+// the profiler has its own mutex, these are called by the fork handlers of the allocator
+void __my_malloc_profile_fork_prepare(void);
+void __my_malloc_profile_fork_parent(void);
+void __my_malloc_profile_fork_child(void);
+
+#endif
@@ -2,15 +2,26 @@
 Author: Totto16
 */
 
+// memfd_create
+#define _GNU_SOURCE
+
 #include <errno.h>
+#include <fcntl.h>
 #include <pthread.h>
+#include <stdatomic.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdlib.h>
+#include <sys/file.h>
 #include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
 
 #include <utils.h>
 
+#include "my_persistent_heap.h"
+#include "my_shm_heap.h"
+
 // some possible configurations, these can be done with defines during compilation
 #if !defined(_USE_BIFIELDS)
 #define _USE_BIFIELDS 1
@@ -79,9 +90,37 @@ typedef struct {
 
 #endif
 
+// the region of the blocks, they only know their sizes, so the same blocks can be used, wherever
+// the region is mapped, that is what makes the shared heaps possible
 typedef struct {
 	void* data;
 	uint64_t dataSize;
+} PoolInformation;
+
+// the start of a file, that my_allocator_open_file maps, its blocks begin at MY_FILE_DATA_OFFSET,
+// everything in it is relative, so the file can be mapped at any address
+typedef struct {
+	// set last, after the first block, a file, that was only truncated, isn't a heap
+	uint64_t magic;
+	// of the whole file
+	uint64_t size;
+	// a file can only be opened with the same layout of the blocks (_USE_BIFIELDS)
+	uint64_t blockInformationSize;
+	// of the root block from the start of the file, 0 if there is none
+	uint64_t root;
+} PersistentHeapHeader;
+
+// "my_file1"
+#define MY_FILE_MAGIC ((uint64_t)0x31656c69665f796dULL)
+
+#define MY_FILE_DATA_OFFSET (((sizeof(PersistentHeapHeader) + 63U) / 64U) * 64U)
+
+typedef struct {
+	PoolInformation pool;
+	// NULL, if the pool isn't a file, that was opened with my_allocator_open_file
+	PersistentHeapHeader* file;
+	// the file stays open, so that its lock keeps other processes from opening it
+	int fileDescriptor;
 	pthread_mutex_t mutex;
 } GlobalObject;
 
@@ -102,15 +141,14 @@ static _Thread_local GlobalObject __my_malloc_globalObject;
 // checks wether a block can really be one, not that reliable, but the behavior of the programm is
 // undefined, if not passing valid adresses into the malloc functions, so that is just a little
 // security mechanims
-static bool __my_malloc_isValidBlock(void* blockPointer) {
+static bool __my_malloc_isValidBlock(const PoolInformation* pool, void* blockPointer) {
 	if(blockPointer == NULL) {
 		return false;
 	}
 
 	BlockInformation* blockInformation = ((BlockInformation*)blockPointer);
 	bool hasValidStatus = blockInformation->status == FREE || blockInformation->status == ALLOCED;
-	bool nextIsInRange =
-	    __my_malloc_globalObject.dataSize - sizeof(BlockInformation) >= blockInformation->size;
+	bool nextIsInRange = pool->dataSize - sizeof(BlockInformation) >= blockInformation->size;
 	return nextIsInRange && hasValidStatus;
 }
 
@@ -118,11 +156,12 @@ static bool __my_malloc_isValidBlock(void* blockPointer) {
 
 // some helpers to get the nextBlock, this has to be done, since this implementation is done without
 // pointers, but with sizes, it also can return NUll if it has no next block
-static BlockInformation* __my_malloc_nextBlock(BlockInformation* currentBlock) {
+static BlockInformation* __my_malloc_nextBlock(const PoolInformation* pool,
+                                               BlockInformation* currentBlock) {
 
-	if(((pseudoByte*)currentBlock) - (pseudoByte*)__my_malloc_globalObject.data +
-	       currentBlock->size + sizeof(BlockInformation) ==
-	   __my_malloc_globalObject.dataSize) {
+	if(((pseudoByte*)currentBlock) - (pseudoByte*)pool->data + currentBlock->size +
+	       sizeof(BlockInformation) ==
+	   pool->dataSize) {
 		return NULL;
 	}
 
@@ -134,16 +173,17 @@ static BlockInformation* __my_malloc_nextBlock(BlockInformation* currentBlock) {
 }
 
 // this is incredibly slow, but it has to be done like that without previous Pointer!
-static BlockInformation* __my_malloc_previousBlock(BlockInformation* currentBlock) {
+static BlockInformation* __my_malloc_previousBlock(const PoolInformation* pool,
+                                                   BlockInformation* currentBlock) {
 
-	if((pseudoByte*)currentBlock == (pseudoByte*)__my_malloc_globalObject.data) {
+	if((pseudoByte*)currentBlock == (pseudoByte*)pool->data) {
 		return NULL;
 	}
 
-	BlockInformation* previousFreeBlock = (BlockInformation*)__my_malloc_globalObject.data;
-	BlockInformation* nextFreeBlock = __my_malloc_nextBlock(previousFreeBlock);
+	BlockInformation* previousFreeBlock = (BlockInformation*)pool->data;
+	BlockInformation* nextFreeBlock = __my_malloc_nextBlock(pool, previousFreeBlock);
 	while(nextFreeBlock != NULL) {
-		nextFreeBlock = __my_malloc_nextBlock(previousFreeBlock);
+		nextFreeBlock = __my_malloc_nextBlock(pool, previousFreeBlock);
 		if((pseudoByte*)nextFreeBlock == (pseudoByte*)currentBlock) {
 			return previousFreeBlock;
 		}
@@ -173,41 +213,25 @@ static bool __my_malloc_block_fitsBetter(BlockInformation* toCompare,
 		return true;
 	}
 
-	// if no BlockInformation can fit in there, but also the block isn't exactly the right size it
-	// doesn't fit, e.g if there are 7 bytes between the size to search the no structure can fit in,
-	// but also the next one can't be used (alias just be leaved unmodified and used as next, this
-	// can be solved by using next pointers  to the next BlockInformation, which consumes another 8
-	// bytes :( but also since the size is only 8 bytes this shouldn't occur that often!)
-
-	// this can make an allocation impossible, or just use another block
-	if(blockSize - size < sizeof(BlockInformation)) {
-		// this warning is not the best, but shouldn't occur when normally using this!
-		printf("INTERNAL: WARNING: could be solved (better) with more memory hungry "
-		       "BlockInformation!\n");
-
-		return false;
-	}
+	// if no BlockInformation can fit in the rest, e.g if there are 7 bytes between the size to
+	// search and the size of the block, the block can't be split, __my_malloc_pool_malloc hands it
+	// out as a whole then, so it fits like every other block, that is big enough
 	uint64_t currentSize = currentBlock->size;
 
 	return blockSize - size < currentSize - size;
 }
 
-// alloc a certain size,  if no space was in the global data struct a NULL pointer is
-// returned, rather then allocating more memory, this malloc can't grow it's internal buffer
-// dynamically!
-
-void* my_malloc(uint64_t size) {
-	// lock mutex, so it's thread safe!
-	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
-	// mutex errors are better when being asserted, since no real errors can occur, only when the
-	// system is already malfunctioning
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
-
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * allocates a block of size in the pool, returns NULL if no free block is big enough
+ * @note Needs to be called with the mutex of the pool locked, the block headers are only changed
+ * by single stores, a process, that dies in the middle of it, leaves valid blocks behind
+ */
+static void* __my_malloc_pool_malloc(const PoolInformation* pool, uint64_t size) {
 	// iterating over all blocks and saving the best fit, has shorthand computation, meaning that if
 	// a block fits exactly it takes that block immediately!
-	BlockInformation* bestFit = (BlockInformation*)__my_malloc_globalObject.data;
-	BlockInformation* nextFreeBlock = __my_malloc_nextBlock(bestFit);
+	BlockInformation* bestFit = (BlockInformation*)pool->data;
+	BlockInformation* nextFreeBlock = __my_malloc_nextBlock(pool, bestFit);
 
 	while(nextFreeBlock != NULL) {
 
@@ -218,23 +242,21 @@ void* my_malloc(uint64_t size) {
 				break;
 			}
 		}
-		nextFreeBlock = __my_malloc_nextBlock(nextFreeBlock);
+		nextFreeBlock = __my_malloc_nextBlock(pool, nextFreeBlock);
 	}
 	// if the one that fit the best is not big enough, it means no block is big enough, or if that
 	// block isn't free, so that means teh same
 	if(bestFit->size < size || bestFit->status != FREE) {
-		// unlocking mutex before returning
-		result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-		checkResultForThreadErrorAndExit(
-		    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
-
 		return NULL;
 	};
 
 	// now either making a new block or just setting the old to status ALLOCED, this depends on the
 	// size that has to be malloced
 
-	if(bestFit->size == size) {
+	// a rest, that is too small for a BlockInformation, stays part of the block, the first block is
+	// never passed to __my_malloc_block_fitsBetter, so this has to be checked here, a new block
+	// there would overwrite the next one
+	if(bestFit->size - size < sizeof(BlockInformation)) {
 		bestFit->status = ALLOCED;
 	} else {
 		// caluclate the position of teh new block, then store there the necessary infromation
@@ -242,37 +264,31 @@ void* my_malloc(uint64_t size) {
 		BlockInformation* newBlock = (BlockInformation*)((pseudoByte*)bestFit + blockSize);
 		newBlock->status = FREE;
 		newBlock->size = bestFit->size - blockSize;
+		// the new block has to be complete, before bestFit is shrunk, in case the process dies in
+		// between, with the mutex of a shared heap locked
+		atomic_signal_fence(memory_order_release);
 
 		bestFit->status = ALLOCED;
 		bestFit->size = size;
 	}
 
-	void* returnValue = (pseudoByte*)bestFit + sizeof(BlockInformation);
-
-	// unlocking mutex before returning
-	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
-
 	// returning the area that is designed to store the data ( it has an offset of
 	// sizeof(BlockInformation))
-	return returnValue;
+	return (pseudoByte*)bestFit + sizeof(BlockInformation);
 }
 
-void my_free(void* ptr) {
-	// lock mutex, so it's thread safe!
-	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
-	// mutex errors are better when being asserted, since no real errors can occur, only when the
-	// system is already malfunctioning
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
-
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * frees the block of ptr and merges it with its free neighbours
+ * @note Needs to be called with the mutex of the pool locked
+ */
+static void __my_malloc_pool_free(const PoolInformation* pool, void* ptr) {
 	// get the 	BlockInformation*  where the status is stored, here some security checks are done,
 	// the system malloc doesn't do that, but I do it nevertheless
 	BlockInformation* information =
 	    (BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation));
 #if _VALIDATE_BLOCKS == 1
-	if(!__my_malloc_isValidBlock(information)) {
+	if(!__my_malloc_isValidBlock(pool, information)) {
 		printErrorAndExit("INTERNAL: you tried to free a invalid Block at address: %p\n", ptr);
 	}
 #endif
@@ -283,8 +299,8 @@ void my_free(void* ptr) {
 	information->status = FREE;
 
 	// now checking if some  free blocks can be merged
-	BlockInformation* nextBlock = __my_malloc_nextBlock(information);
-	BlockInformation* previousBlock = __my_malloc_previousBlock(information);
+	BlockInformation* nextBlock = __my_malloc_nextBlock(pool, information);
+	BlockInformation* previousBlock = __my_malloc_previousBlock(pool, information);
 	if(previousBlock != NULL && previousBlock->status == FREE) {
 		if(nextBlock != NULL && nextBlock->status == FREE) {
 			previousBlock->size = previousBlock->size + information->size + nextBlock->size +
@@ -296,6 +312,74 @@ void my_free(void* ptr) {
 	} else if(nextBlock != NULL && nextBlock->status == FREE) {
 		information->size = information->size + nextBlock->size + sizeof(BlockInformation);
 	}
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * checks, that the blocks of the pool end exactly at its end, before a pool, that someone else
+ * changed, is used
+ */
+static bool __my_malloc_pool_isConsistent(const PoolInformation* pool) {
+	uint64_t offset = 0;
+
+	while(pool->dataSize - offset >= sizeof(BlockInformation)) {
+		BlockInformation* block = (BlockInformation*)((pseudoByte*)pool->data + offset);
+		if(block->status != FREE && block->status != ALLOCED) {
+			return false;
+		}
+
+		uint64_t remaining = pool->dataSize - offset - sizeof(BlockInformation);
+		if(block->size > remaining) {
+			return false;
+		}
+
+		if(block->size == remaining) {
+			return true;
+		}
+
+		offset += sizeof(BlockInformation) + block->size;
+	}
+
+	return false;
+}
+
+// alloc a certain size,  if no space was in the global data struct a NULL pointer is
+// returned, rather then allocating more memory, this malloc can't grow it's internal buffer
+// dynamically!
+
+void* my_malloc(uint64_t size) {
+	// lock mutex, so it's thread safe!
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	void* returnValue = __my_malloc_pool_malloc(&__my_malloc_globalObject.pool, size);
+
+	// unlocking mutex before returning
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	return returnValue;
+}
+
+void my_free(void* ptr) {
+	// lock mutex, so it's thread safe!
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	// the root is reset first, so it never refers to a free block, that a later malloc reuses
+	if(__my_malloc_globalObject.file != NULL && __my_malloc_globalObject.file->root != 0 &&
+	   ptr == (pseudoByte*)__my_malloc_globalObject.file + __my_malloc_globalObject.file->root) {
+		__my_malloc_globalObject.file->root = 0;
+	}
+
+	__my_malloc_pool_free(&__my_malloc_globalObject.pool, ptr);
 
 	// unlocking mutex before returning
 	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
@@ -304,7 +388,8 @@ void my_free(void* ptr) {
 }
 
 void my_allocator_init(uint64_t size, bool force_alloc) {
-	__my_malloc_globalObject.dataSize = size;
+	__my_malloc_globalObject.pool.dataSize = size;
+	__my_malloc_globalObject.file = NULL;
 
 	// DOES NOTHING
 	(void)force_alloc;
@@ -316,15 +401,15 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
 	//  argument should be zero." ~ man page
 
 	// this memory region is initalized with 0s
-	__my_malloc_globalObject.data =
+	__my_malloc_globalObject.pool.data =
 	    mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
-	if(__my_malloc_globalObject.data == MAP_FAILED) {
+	if(__my_malloc_globalObject.pool.data == MAP_FAILED) {
 		printErrorAndExit("INTERNAL: Failed to mmap for the allocator: %s\n", strerror(errno));
 	}
 	// FREE is set with the 0 initialized region automatically (only here the block is initialzed
 	// with 0, not after freeing!)
 
-	((BlockInformation*)__my_malloc_globalObject.data)->size = size - sizeof(BlockInformation);
+	((BlockInformation*)__my_malloc_globalObject.pool.data)->size = size - sizeof(BlockInformation);
 
 	// initialize the mutex, use default as attr
 	int result = pthread_mutex_init(&__my_malloc_globalObject.mutex, NULL);
@@ -333,12 +418,455 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
 }
 
 void my_allocator_destroy(void) {
-	// un,mapping the mapped memory and destroy the mutex
-	int result = munmap(__my_malloc_globalObject.data, __my_malloc_globalObject.dataSize);
+	// un,mapping the mapped memory and destroy the mutex, a file is written back by the kernel
+	// later, only my_allocator_checkpoint waits for that
+	int result = __my_malloc_globalObject.file == NULL
+	                 ? munmap(__my_malloc_globalObject.pool.data,
+	                          __my_malloc_globalObject.pool.dataSize)
+	                 : munmap(__my_malloc_globalObject.file,
+	                          __my_malloc_globalObject.pool.dataSize + MY_FILE_DATA_OFFSET);
 	checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
 
+	// the lock of the file is released with it
+	if(__my_malloc_globalObject.file != NULL) {
+		result = close(__my_malloc_globalObject.fileDescriptor);
+		checkResultForThreadErrorAndExit("INTERNAL: Failed to close the file of the allocator:");
+	}
+
+	__my_malloc_globalObject.file = NULL;
+
 	result = pthread_mutex_destroy(&__my_malloc_globalObject.mutex);
 	checkResultForThreadErrorAndExit(
 	    "INTERNAL: An Error occurred while trying to destroy the internal mutex "
 	    "in cleaning up for the allocator");
 }
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * checks, that root is 0 or the offset of an allocated block in the pool of the file
+ * @note Needs to be called with the blocks checked by __my_malloc_pool_isConsistent
+ */
+static bool __my_malloc_file_isValidRoot(const PersistentHeapHeader* file,
+                                         const PoolInformation* pool, uint64_t root) {
+	if(root == 0) {
+		return true;
+	}
+
+	BlockInformation* block = (BlockInformation*)pool->data;
+	while(block != NULL) {
+		uint64_t offset =
+		    (uint64_t)((pseudoByte*)block - (pseudoByte*)file) + sizeof(BlockInformation);
+		if(offset == root) {
+			return block->status == ALLOCED;
+		}
+		block = __my_malloc_nextBlock(pool, block);
+	}
+
+	return false;
+}
+
+int my_allocator_open_file(const char* path, uint64_t size) {
+	int fd = open(path, O_RDWR | O_CREAT | O_CLOEXEC, 0600);
+	if(fd < 0) {
+		return -1;
+	}
+
+	// the blocks aren't locked between processes, so only one may use the file, flock sets errno
+	// to EWOULDBLOCK, if another one has it open
+	if(flock(fd, LOCK_EX | LOCK_NB) != 0) {
+		int lockError = errno;
+		close(fd);
+		errno = lockError;
+		return -1;
+	}
+
+	struct stat status;
+	if(fstat(fd, &status) != 0) {
+		int statError = errno;
+		close(fd);
+		errno = statError;
+		return -1;
+	}
+
+	// an empty file is a new heap, every other one has to be one already
+	bool created = status.st_size == 0;
+	if(!created) {
+		if(size != 0 && size != (uint64_t)status.st_size) {
+			close(fd);
+			errno = EINVAL;
+			return -1;
+		}
+		size = (uint64_t)status.st_size;
+	}
+
+	if(size < MY_FILE_DATA_OFFSET + sizeof(BlockInformation) || size > (uint64_t)INT64_MAX) {
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	}
+
+	// the new part of the file is filled with 0s, so the first block is FREE already
+	if(created && ftruncate(fd, (off_t)size) != 0) {
+		int truncateError = errno;
+		close(fd);
+		errno = truncateError;
+		return -1;
+	}
+
+	void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(base == MAP_FAILED) {
+		int mmapError = errno;
+		close(fd);
+		errno = mmapError;
+		return -1;
+	}
+
+	PersistentHeapHeader* file = (PersistentHeapHeader*)base;
+	PoolInformation pool = { .data = (pseudoByte*)base + MY_FILE_DATA_OFFSET,
+		                     .dataSize = size - MY_FILE_DATA_OFFSET };
+
+	if(created) {
+		((BlockInformation*)pool.data)->size = pool.dataSize - sizeof(BlockInformation);
+		file->size = size;
+		file->blockInformationSize = sizeof(BlockInformation);
+		file->root = 0;
+		atomic_signal_fence(memory_order_release);
+		file->magic = MY_FILE_MAGIC;
+	} else if(file->magic != MY_FILE_MAGIC || file->size != size ||
+	          file->blockInformationSize != sizeof(BlockInformation) ||
+	          !__my_malloc_pool_isConsistent(&pool)) {
+		// the blocks are used as they are, so a file, that isn't exactly a heap, is never changed
+		munmap(base, size);
+		close(fd);
+		errno = EINVAL;
+		return -1;
+	} else if(!__my_malloc_file_isValidRoot(file, &pool, file->root)) {
+		// the blocks are fine, only the root isn't one of them anymore, e.g. if the process died
+		// between freeing it and resetting it, so the heap is usable without a root
+		file->root = 0;
+	}
+
+	__my_malloc_globalObject.pool = pool;
+	__my_malloc_globalObject.file = file;
+	__my_malloc_globalObject.fileDescriptor = fd;
+
+	// initialize the mutex, use default as attr
+	int result = pthread_mutex_init(&__my_malloc_globalObject.mutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+
+	return 0;
+}
+
+void my_allocator_set_root(void* ptr) {
+	if(__my_malloc_globalObject.file == NULL) {
+		printSingleErrorAndExit("ERROR: Only a heap, that was opened with my_allocator_open_file, "
+		                        "has a root\n");
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	uint64_t root =
+	    ptr == NULL ? 0
+	                : (uint64_t)((pseudoByte*)ptr - (pseudoByte*)__my_malloc_globalObject.file);
+	if(!__my_malloc_file_isValidRoot(__my_malloc_globalObject.file,
+	                                 &__my_malloc_globalObject.pool, root)) {
+		printErrorAndExit("ERROR: The root has to be an allocated block of the heap: %p\n", ptr);
+	}
+
+	__my_malloc_globalObject.file->root = root;
+
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
+
+void* my_allocator_get_root(void) {
+	if(__my_malloc_globalObject.file == NULL || __my_malloc_globalObject.file->root == 0) {
+		return NULL;
+	}
+
+	return (pseudoByte*)__my_malloc_globalObject.file + __my_malloc_globalObject.file->root;
+}
+
+int my_allocator_checkpoint(void) {
+	if(__my_malloc_globalObject.file == NULL) {
+		printSingleErrorAndExit("ERROR: Only a heap, that was opened with my_allocator_open_file, "
+		                        "can be checkpointed\n");
+	}
+
+	// with the mutex locked, no block is changed in the middle of writing them
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	int syncResult = msync(__my_malloc_globalObject.file,
+	                       __my_malloc_globalObject.pool.dataSize + MY_FILE_DATA_OFFSET, MS_SYNC);
+	int syncError = errno;
+
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	errno = syncError;
+	return syncResult;
+}
+
+// the start of every shared heap, its blocks begin at MY_SHM_DATA_OFFSET, so the header doesn't
+// share a cache line with them
+typedef struct {
+	// set last by my_shm_create, so a heap, that is still being created, isn't attached to
+	_Atomic uint64_t magic;
+	// of the whole mapping
+	uint64_t size;
+	// the processes have to agree on the layout of the blocks (_USE_BIFIELDS)
+	uint64_t blockInformationSize;
+	// process shared and robust, so a process, that dies with it locked, doesn't block the others
+	pthread_mutex_t mutex;
+} SharedHeapHeader;
+
+// "my_shm01"
+#define MY_SHM_MAGIC ((uint64_t)0x31306d68735f796dULL)
+
+#define MY_SHM_DATA_OFFSET (((sizeof(SharedHeapHeader) + 63U) / 64U) * 64U)
+
+// the block headers stay aligned to that, every change of them is a single store then
+#define MY_SHM_ALIGNMENT 8U
+
+struct my_shm_heap {
+	SharedHeapHeader* header;
+	// where the blocks are mapped in this process
+	PoolInformation pool;
+	int fd;
+};
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * maps size bytes of fd and creates the handle for it, the fd belongs to the handle then, on
+ * failure it is closed, NULL is returned and errno is set
+ */
+static struct my_shm_heap* __my_shm_map(int fd, uint64_t size) {
+	struct my_shm_heap* heap = (struct my_shm_heap*)malloc(sizeof(struct my_shm_heap));
+	if(heap == NULL) {
+		close(fd);
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	void* base = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+	if(base == MAP_FAILED) {
+		int mmapError = errno;
+		free(heap);
+		close(fd);
+		errno = mmapError;
+		return NULL;
+	}
+
+	heap->header = (SharedHeapHeader*)base;
+	heap->pool.data = (pseudoByte*)base + MY_SHM_DATA_OFFSET;
+	heap->pool.dataSize = size - MY_SHM_DATA_OFFSET;
+	heap->fd = fd;
+	return heap;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * locks the mutex of the heap, if its last owner died, the blocks are checked before they are
+ * used again
+ */
+static void __my_shm_lock(struct my_shm_heap* heap) {
+	int result = pthread_mutex_lock(&heap->header->mutex);
+	if(result == EOWNERDEAD) {
+		// every change of the blocks leaves a valid chain of them behind, at most the block, that
+		// was being allocated, is lost, everything else means, that the heap was overwritten
+		if(!__my_malloc_pool_isConsistent(&heap->pool)) {
+			printSingleErrorAndExit(
+			    "ERROR: The shared heap is corrupted, a process died while changing it\n");
+		}
+		result = pthread_mutex_consistent(&heap->header->mutex);
+	}
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the shared heap");
+}
+
+static void __my_shm_unlock(struct my_shm_heap* heap) {
+	int result = pthread_mutex_unlock(&heap->header->mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the shared heap");
+}
+
+struct my_shm_heap* my_shm_create(const char* name, uint64_t size) {
+	if(size < MY_SHM_DATA_OFFSET + sizeof(BlockInformation) || size > (uint64_t)INT64_MAX) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	int fd = name == NULL ? memfd_create("my_shm_heap", MFD_CLOEXEC)
+	                      : shm_open(name, O_RDWR | O_CREAT | O_EXCL, 0600);
+	if(fd < 0) {
+		return NULL;
+	}
+
+	// the new object is filled with 0s, so the first block is FREE already, like in
+	// my_allocator_init
+	if(ftruncate(fd, (off_t)size) != 0) {
+		int truncateError = errno;
+		close(fd);
+		if(name != NULL) {
+			shm_unlink(name);
+		}
+		errno = truncateError;
+		return NULL;
+	}
+
+	struct my_shm_heap* heap = __my_shm_map(fd, size);
+	if(heap == NULL) {
+		if(name != NULL) {
+			int mapError = errno;
+			shm_unlink(name);
+			errno = mapError;
+		}
+		return NULL;
+	}
+
+	((BlockInformation*)heap->pool.data)->size = heap->pool.dataSize - sizeof(BlockInformation);
+
+	heap->header->size = size;
+	heap->header->blockInformationSize = sizeof(BlockInformation);
+
+	pthread_mutexattr_t attributes;
+	int result = pthread_mutexattr_init(&attributes);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to initialize the mutex attributes");
+
+	result = pthread_mutexattr_setpshared(&attributes, PTHREAD_PROCESS_SHARED);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to make the mutex process shared");
+
+	result = pthread_mutexattr_setrobust(&attributes, PTHREAD_MUTEX_ROBUST);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to make the mutex robust");
+
+	result = pthread_mutex_init(&heap->header->mutex, &attributes);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "mutex of the shared heap");
+
+	result = pthread_mutexattr_destroy(&attributes);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to destroy the mutex attributes");
+
+	atomic_store_explicit(&heap->header->magic, MY_SHM_MAGIC, memory_order_release);
+
+	return heap;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ * maps the heap in fd and checks, that it is one, the fd belongs to the heap then, on failure it
+ * is closed
+ */
+static struct my_shm_heap* __my_shm_attach(int fd) {
+	struct stat status;
+	if(fstat(fd, &status) != 0) {
+		int statError = errno;
+		close(fd);
+		errno = statError;
+		return NULL;
+	}
+
+	uint64_t size = (uint64_t)status.st_size;
+	if(size < MY_SHM_DATA_OFFSET + sizeof(BlockInformation)) {
+		close(fd);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	struct my_shm_heap* heap = __my_shm_map(fd, size);
+	if(heap == NULL) {
+		return NULL;
+	}
+
+	if(atomic_load_explicit(&heap->header->magic, memory_order_acquire) != MY_SHM_MAGIC ||
+	   heap->header->size != size ||
+	   heap->header->blockInformationSize != sizeof(BlockInformation)) {
+		my_shm_detach(heap);
+		errno = EINVAL;
+		return NULL;
+	}
+
+	return heap;
+}
+
+struct my_shm_heap* my_shm_attach(const char* name) {
+	int fd = shm_open(name, O_RDWR, 0);
+	if(fd < 0) {
+		return NULL;
+	}
+
+	return __my_shm_attach(fd);
+}
+
+struct my_shm_heap* my_shm_attach_fd(int fd) {
+	int ownFd = fcntl(fd, F_DUPFD_CLOEXEC, 0);
+	if(ownFd < 0) {
+		return NULL;
+	}
+
+	return __my_shm_attach(ownFd);
+}
+
+void my_shm_detach(struct my_shm_heap* heap) {
+	int result = munmap(heap->header, heap->pool.dataSize + MY_SHM_DATA_OFFSET);
+	checkResultForErrorAndExit("INTERNAL: Failed to munmap the shared heap");
+
+	result = close(heap->fd);
+	checkResultForErrorAndExit("INTERNAL: Failed to close the shared heap");
+
+	free(heap);
+}
+
+int my_shm_fd(const struct my_shm_heap* heap) {
+	return heap->fd;
+}
+
+my_shm_offset_t my_shm_malloc(struct my_shm_heap* heap, uint64_t size) {
+	if(size > heap->pool.dataSize) {
+		return 0;
+	}
+
+	uint64_t alignedSize = (size + MY_SHM_ALIGNMENT - 1U) & ~(uint64_t)(MY_SHM_ALIGNMENT - 1U);
+
+	__my_shm_lock(heap);
+	void* ptr = __my_malloc_pool_malloc(&heap->pool, alignedSize);
+	__my_shm_unlock(heap);
+
+	return ptr == NULL ? 0 : my_shm_offset(heap, ptr);
+}
+
+void my_shm_free(struct my_shm_heap* heap, my_shm_offset_t offset) {
+	if(offset == 0) {
+		return;
+	}
+
+	__my_shm_lock(heap);
+	__my_malloc_pool_free(&heap->pool, my_shm_pointer(heap, offset));
+	__my_shm_unlock(heap);
+}
+
+void* my_shm_pointer(const struct my_shm_heap* heap, my_shm_offset_t offset) {
+	if(offset == 0) {
+		return NULL;
+	}
+
+	return (pseudoByte*)heap->header + offset;
+}
+
+my_shm_offset_t my_shm_offset(const struct my_shm_heap* heap, const void* ptr) {
+	if(ptr == NULL) {
+		return 0;
+	}
+
+	return (my_shm_offset_t)((const pseudoByte*)ptr - (const pseudoByte*)heap->header);
+}
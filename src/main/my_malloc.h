@@ -10,13 +10,112 @@
 extern "C" {
 #endif
 
+struct my_malloc_stats {
+	// counters, in the thread local variant these are summed up over all threads
+	uint64_t mapped_bytes;
+	uint64_t memory_blocks;
+	uint64_t mmap_calls;
+	uint64_t munmap_calls;
+	uint64_t used_bytes;
+	uint64_t used_blocks;
+
+	// computed from the block lists, in the thread local variant only the ones of the calling
+	// thread and of exited threads
+	uint64_t free_bytes;
+	uint64_t free_blocks;
+	uint64_t largest_free_block;
+
+	// 1 - largest_free_block / free_bytes, 0 if all free memory is in one block (or there is none)
+	double fragmentation;
+};
+
+// one block, as seen by my_heap_walk, the headers are part of the memory block, but not of the size
+struct my_heap_block_info {
+	// the memory block (chunk), that contains this block, and its number
+	void* memory_block;
+	uint64_t memory_block_size;
+	uint32_t memory_block_number;
+
+	// the start of the header of the block, and the pointer, that my_malloc returned for it, so the
+	// memory block header is header - memory_block for the first block, the block header is
+	// data - header
+	void* header;
+	void* data;
+	uint64_t size;
+	bool free;
+};
+
+typedef void (*my_heap_walk_fn)(const struct my_heap_block_info* info, void* ctx);
+
+// how malloc chooses the free block, that it splits, if more than one is big enough
+enum my_malloc_fit {
+	// the smallest block, a block of exactly the size ends the search, the default
+	MY_MALLOC_FIT_BEST = 0,
+	// the first block in address order (of every memory block)
+	MY_MALLOC_FIT_FIRST,
+	// the first block after the one, that was allocated last, it wraps around at the end
+	MY_MALLOC_FIT_NEXT,
+	// like best fit, but the search ends at the first block, that wastes at most
+	// good_enough_percent of the size
+	MY_MALLOC_FIT_GOOD_ENOUGH,
+};
+
+// the settings of my_allocator_init_ex, my_allocator_init uses best fit
+struct my_allocator_options {
+	uint64_t memory_block_size;
+	bool force_alloc;
+	enum my_malloc_fit fit;
+	uint32_t good_enough_percent;
+	// if not 0, a background thread merges the small freed blocks and releases empty memory blocks
+	// every that many milliseconds, and when a free empties a memory block, so that the frees
+	// don't do that, only the variant with one mutex has that thread, the others ignore this
+	uint32_t background_interval_ms;
+	// if not 0, every new memory block is that many percent bigger than the one before, up to
+	// max_memory_block_size, every released memory block shrinks the next one by one step again,
+	// requests, that are bigger, still get their own size
+	uint32_t growth_percent;
+	// memory blocks, that are mapped next to each other, are merged up to this size, unless
+	// separate_memory_blocks is set, 0 means 64 times memory_block_size
+	uint64_t max_memory_block_size;
+	bool separate_memory_blocks;
+};
+
 void* my_malloc(uint64_t size);
 void my_free(void* ptr);
 void* my_realloc(void* ptr, uint64_t size);
+void* my_memalign(uint64_t alignment, uint64_t size);
+uint64_t my_malloc_usable_size(void* ptr);
+// true, if ptr points into memory of the allocator, without a lock
+bool my_allocator_owns(const void* ptr);
 
 void my_allocator_init(uint64_t size, bool force_alloc);
+void my_allocator_init_ex(const struct my_allocator_options* options);
 void my_allocator_destroy(void);
 
+// merges the small freed blocks, that are kept for reuse, and releases the empty memory blocks,
+// returns true, if one was released
+bool my_allocator_trim(void);
+
+// handlers for pthread_atfork, so that a fork in a MT program leaves the allocator usable
+void my_allocator_fork_prepare(void);
+void my_allocator_fork_parent(void);
+void my_allocator_fork_child(void);
+
+void my_allocator_stats(struct my_malloc_stats* stats);
+
+// introspection of the block lists, the callback must not use the allocator
+void my_heap_walk(my_heap_walk_fn callback, void* ctx);
+int my_heap_dump_map(int fd);
+
+// sampling heap profiler, the dump can be read with pprof
+void my_heap_profile_start(uint64_t sample_rate);
+void my_heap_profile_stop(void);
+int my_heap_profile_dump(const char* path);
+
+// binary trace of every allocator call, the format is described in trace_format.h
+int my_malloc_trace_start(const char* path);
+void my_malloc_trace_stop(void);
+
 #ifdef __cplusplus
 }
 #endif
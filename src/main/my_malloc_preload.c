@@ -0,0 +1,278 @@
+/*
+Author: Totto16
+*/
+
+// this file exports the POSIX malloc family, so that the shared library built from this and
+// my_malloc_with_pointers.c can be used with LD_PRELOAD to replace the allocator of any program,
+// e.g.: LD_PRELOAD=./libmy_malloc_preload.so ./program
+
+#include <errno.h>
+#include <pthread.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include <utils.h>
+
+#include "my_malloc.h"
+
+// the size of every memory block, that the allocator maps, can be overwritten with the environment
+// variable MY_MALLOC_MEMORY_BLOCK_SIZE (in bytes), bigger allocations get their own memory block
+#define PRELOAD_DEFAULT_MEMORY_BLOCK_SIZE ((uint64_t)(1024U * 1024U * 64U))
+
+#define PRELOAD_MEMORY_BLOCK_SIZE_ENV "MY_MALLOC_MEMORY_BLOCK_SIZE"
+
+#define PRELOAD_PAGE_SIZE ((size_t)4096)
+
+// if MY_MALLOC_HEAP_PROFILE is set to a path, the heap profiler is started, with a sample rate of
+// MY_MALLOC_HEAP_PROFILE_RATE bytes (default 512 KiB), and the profile is written there at exit
+#define PRELOAD_HEAP_PROFILE_ENV "MY_MALLOC_HEAP_PROFILE"
+
+#define PRELOAD_HEAP_PROFILE_RATE_ENV "MY_MALLOC_HEAP_PROFILE_RATE"
+
+#define PRELOAD_DEFAULT_HEAP_PROFILE_RATE ((uint64_t)(1024U * 512U))
+
+// if MY_MALLOC_TRACE is set to a path, every allocator call is recorded there, a "%p" in it is
+// replaced by the pid, so that child processes with the same environment don't overwrite it
+#define PRELOAD_TRACE_ENV "MY_MALLOC_TRACE"
+
+static pthread_once_t __my_malloc_preload_once = PTHREAD_ONCE_INIT;
+
+static const char* __my_malloc_preload_profilePath = NULL;
+
+// this can't use parseLongSafely, since that exits on errors, and this runs before main, so
+// invalid values just use the default, getenv and strtoull don't allocate, so that is safe here
+static void __my_malloc_preload_initialize(void) {
+
+	uint64_t memoryBlockSize = PRELOAD_DEFAULT_MEMORY_BLOCK_SIZE;
+
+	const char* environmentValue = getenv(PRELOAD_MEMORY_BLOCK_SIZE_ENV);
+
+	if(environmentValue != NULL) {
+		char* endpointer;
+		errno = 0;
+		const unsigned long long parsedValue = strtoull(environmentValue, &endpointer, 10);
+
+		if(errno == 0 && *endpointer == '\0' && parsedValue >= PRELOAD_PAGE_SIZE) {
+			memoryBlockSize = parsedValue;
+		}
+	}
+
+	my_allocator_init(memoryBlockSize, false);
+}
+
+// the first call of any function initializes the allocator, pthread_once makes that thread safe
+// and doesn't allocate itself, after the first call this is just one load and compare
+static inline void __my_malloc_preload_ensure_initialized(void) {
+	int result = pthread_once(&__my_malloc_preload_once, __my_malloc_preload_initialize);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to initialize the preloaded allocator");
+}
+
+static void __my_malloc_preload_dump_profile(void) {
+	if(my_heap_profile_dump(__my_malloc_preload_profilePath) != 0) {
+		fprintf(stderr, "ERROR: Couldn't write the heap profile to '%s': %s\n",
+		        __my_malloc_preload_profilePath, strerror(errno));
+	}
+}
+
+// the trace is started after the fork handlers are registered, since it uses mutexes and files,
+// that have to be handled at a fork
+static void __my_malloc_preload_start_trace(void) {
+	const char* tracePath = getenv(PRELOAD_TRACE_ENV);
+
+	if(tracePath == NULL) {
+		return;
+	}
+
+	char path[4096];
+	size_t length = 0;
+
+	for(const char* current = tracePath; *current != '\0' && length < sizeof(path) - 32;
+	    ++current) {
+		if(current[0] == '%' && current[1] == 'p') {
+			length += (size_t)snprintf(path + length, sizeof(path) - length, "%d", (int)getpid());
+			++current;
+		} else {
+			path[length++] = *current;
+		}
+	}
+
+	path[length] = '\0';
+
+	if(my_malloc_trace_start(path) != 0) {
+		fprintf(stderr, "ERROR: Couldn't start the allocation trace '%s': %s\n", path,
+		        strerror(errno));
+	}
+}
+
+// pthread_atfork may allocate itself, so it can't be called in the initializer above, that would
+// deadlock in pthread_once, so it is registered in a constructor, every allocation before that
+// initializes the allocator lazily, the same is true for starting the heap profiler
+__attribute__((constructor)) static void __my_malloc_preload_register_fork_handlers(void) {
+	__my_malloc_preload_ensure_initialized();
+
+	int result = pthread_atfork(my_allocator_fork_prepare, my_allocator_fork_parent,
+	                            my_allocator_fork_child);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to register the fork handlers of the allocator");
+
+	__my_malloc_preload_start_trace();
+
+	__my_malloc_preload_profilePath = getenv(PRELOAD_HEAP_PROFILE_ENV);
+
+	if(__my_malloc_preload_profilePath == NULL) {
+		return;
+	}
+
+	uint64_t sampleRate = PRELOAD_DEFAULT_HEAP_PROFILE_RATE;
+
+	const char* rateValue = getenv(PRELOAD_HEAP_PROFILE_RATE_ENV);
+
+	if(rateValue != NULL) {
+		char* endpointer;
+		errno = 0;
+		const unsigned long long parsedValue = strtoull(rateValue, &endpointer, 10);
+
+		if(errno == 0 && *endpointer == '\0' && parsedValue > 0) {
+			sampleRate = parsedValue;
+		}
+	}
+
+	my_heap_profile_start(sampleRate);
+
+	result = atexit(__my_malloc_preload_dump_profile);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to register the atexit function");
+}
+
+void* malloc(size_t size) {
+	__my_malloc_preload_ensure_initialized();
+
+	void* result = my_malloc(size);
+
+	if(result == NULL) {
+		errno = ENOMEM;
+	}
+
+	return result;
+}
+
+void free(void* ptr) {
+	if(ptr == NULL) {
+		return;
+	}
+
+	__my_malloc_preload_ensure_initialized();
+	my_free(ptr);
+}
+
+void* calloc(size_t nmemb, size_t size) {
+	__my_malloc_preload_ensure_initialized();
+
+	size_t totalSize;
+	if(__builtin_mul_overflow(nmemb, size, &totalSize)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	void* result = my_malloc(totalSize);
+
+	if(result == NULL) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	// reused blocks aren't zeroed, only freshly mapped memory is
+	return memset(result, 0, totalSize);
+}
+
+void* realloc(void* ptr, size_t size) {
+	__my_malloc_preload_ensure_initialized();
+
+	void* result = my_realloc(ptr, size);
+
+	if(result == NULL && size != 0) {
+		errno = ENOMEM;
+	}
+
+	return result;
+}
+
+void* reallocarray(void* ptr, size_t nmemb, size_t size) {
+	size_t totalSize;
+	if(__builtin_mul_overflow(nmemb, size, &totalSize)) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return realloc(ptr, totalSize);
+}
+
+void* memalign(size_t alignment, size_t size) {
+	__my_malloc_preload_ensure_initialized();
+
+	void* result = my_memalign(alignment, size);
+
+	if(result == NULL && errno != EINVAL) {
+		errno = ENOMEM;
+	}
+
+	return result;
+}
+
+int posix_memalign(void** memptr, size_t alignment, size_t size) {
+	// the alignment has to be a power of two multiple of sizeof(void*)
+	if(alignment % sizeof(void*) != 0 || (alignment & (alignment - 1)) != 0 || alignment == 0) {
+		return EINVAL;
+	}
+
+	__my_malloc_preload_ensure_initialized();
+
+	void* result = my_memalign(alignment, size);
+
+	if(result == NULL) {
+		return ENOMEM;
+	}
+
+	*memptr = result;
+	return 0;
+}
+
+void* aligned_alloc(size_t alignment, size_t size) {
+	return memalign(alignment, size);
+}
+
+void* valloc(size_t size) {
+	return memalign(PRELOAD_PAGE_SIZE, size);
+}
+
+void* pvalloc(size_t size) {
+	if(size > SIZE_MAX - PRELOAD_PAGE_SIZE) {
+		errno = ENOMEM;
+		return NULL;
+	}
+
+	return memalign(PRELOAD_PAGE_SIZE, (size + PRELOAD_PAGE_SIZE - 1) & ~(PRELOAD_PAGE_SIZE - 1));
+}
+
+size_t malloc_usable_size(void* ptr) {
+	if(ptr == NULL) {
+		return 0;
+	}
+
+	__my_malloc_preload_ensure_initialized();
+	return my_malloc_usable_size(ptr);
+}
+
+// the padding is ignored, only empty memory blocks are released
+int malloc_trim(size_t pad) {
+	(void)pad;
+
+	__my_malloc_preload_ensure_initialized();
+	return my_allocator_trim() ? 1 : 0;
+}
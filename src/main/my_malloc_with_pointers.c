@@ -7,17 +7,25 @@ extern "C" {
 #endif
 
 #include <errno.h>
+#include <inttypes.h>
 #include <limits.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
+#include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 #include <sys/mman.h>
+#include <unistd.h>
 
 #include <utils.h>
 
+#include "heap_profiler.h"
 #include "my_malloc.h"
+#include "trace_recorder.h"
 
 #if !defined(_PER_THREAD_ALLOCATOR)
 #define _PER_THREAD_ALLOCATOR 0
@@ -51,15 +59,26 @@ enum __my_malloc_alloc_status {
 	ALLOCED = 1,
 };
 
+// flags of allocated blocks, they are set, when the block is returned, so they don't have to be
+// cleared, when blocks are split or merged
+enum __my_malloc_block_flags {
+	SAMPLED = 1,    // recorded by the heap profiler
+	IN_FASTBIN = 2, // freed, but still ALLOCED, so that it isn't merged, see the fastbins below
+};
+
 typedef struct {
 	void* nextBlock;
 	void* previousBlock;
 	status_t status;
+	status_t flags; // this uses the padding, so the size stays the same
 	block_number_t blockNumber;
 } BlockInformation;
 
 // every MemoryBlock starts with this
 // [ MemoryBlock | BlockInformation | .....  ]
+// the blocks of every memory block form their own double linked list, the first one has no
+// previousBlock and the last one no nextBlock, so that memory blocks can be moved between different
+// GlobalObjects, the memory blocks itself form a single linked list
 
 typedef struct {
 	uint64_t size;
@@ -67,14 +86,166 @@ typedef struct {
 	block_number_t number;
 } MemoryBlockinformation;
 
+// every returned pointer is aligned to this, POSIX requires malloc to return memory, that is
+// suitably aligned for every fundamental type, and that is 16 on x86_64 (alignof(max_align_t))
+#define MY_MALLOC_ALIGNMENT ((uint64_t)16)
+
+// the first block starts after the MemoryBlockinformation, so that its data is aligned, every
+// BlockInformation has to start at an address, that is 16 - sizeof(BlockInformation) % 16 aligned,
+// so every split point (block + sizeof(BlockInformation) + size) has to keep that, this is done by
+// rounding the sizes up, see __my_malloc_aligned_size
+_Static_assert((sizeof(MemoryBlockinformation) + sizeof(BlockInformation)) % MY_MALLOC_ALIGNMENT ==
+                   0,
+               "the first block in a memory block has to be aligned");
+
+// mmap works in pages, so the memory blocks get rounded up to that, so that no memory is wasted
+#define MY_MALLOC_PAGE_SIZE ((uint64_t)4096)
+
+// freed blocks of the smallest sizes aren't merged with their neighbours, they are put into a LIFO
+// list per size (a fastbin), so that the next malloc of the same size gets them back, without
+// searching and splitting, they are only merged in bulk, see __my_malloc_consolidate, every aligned
+// size is its own bin, so the largest one is 120 bytes
+#define MY_MALLOC_FASTBIN_COUNT 8
+
+#define MY_MALLOC_FASTBIN_MAX_SIZE \
+	((MY_MALLOC_FASTBIN_COUNT + 1) * MY_MALLOC_ALIGNMENT - sizeof(BlockInformation))
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * rounds the size up, so that sizeof(BlockInformation) + size is a multiple of the alignment, so
+ * that the next block (and therefore also its data) is aligned again, returns 0 if that would
+ * overflow
+ */
+static inline uint64_t __my_malloc_aligned_size(uint64_t size) {
+	if(size > UINT64_MAX - (2 * MY_MALLOC_PAGE_SIZE)) {
+		return 0;
+	}
+
+	const uint64_t total = (size + sizeof(BlockInformation) + (MY_MALLOC_ALIGNMENT - 1)) &
+	                       ~(MY_MALLOC_ALIGNMENT - 1);
+	return total - sizeof(BlockInformation);
+}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+// in the thread local case other threads read the counters of a thread, while it updates them, so
+// they have to be atomic, but only the owning thread (or the holder of the orphan mutex) writes
+// them, so a relaxed load and store is enough, that doesn't need a locked instruction
+typedef _Atomic uint64_t counter_t;
+
+#define __my_malloc_counter_add(counter, value) \
+	atomic_store_explicit(&(counter), \
+	                      atomic_load_explicit(&(counter), memory_order_relaxed) + (value), \
+	                      memory_order_relaxed)
+
+#define __my_malloc_counter_get(counter) atomic_load_explicit(&(counter), memory_order_relaxed)
+#else
+// otherwise they are only accessed with the mutex locked, or not MT-safe at all
+typedef uint64_t counter_t;
+
+#define __my_malloc_counter_add(counter, value) ((counter) += (value))
+
+#define __my_malloc_counter_get(counter) (counter)
+#endif
+
+// these are cheap counters, that are updated on every mmap and munmap, and on every allocation
+// and free, a memory block may be mapped by one GlobalObject and unmapped by another one, and a
+// block of an exited thread is freed by the orphan object, so a single counter may underflow, but
+// the sum of all of them is always correct, since unsigned integers wrap around
+typedef struct {
+	counter_t mappedBytes;
+	counter_t memoryBlocks;
+	counter_t mmapCalls;
+	counter_t munmapCalls;
+	// the allocated blocks and their sizes, a block in a fastbin is free, in the global case the
+	// frees are counted per stripe, see __my_malloc_count_freed
+	counter_t usedBytes;
+	counter_t usedBlocks;
+} AllocatorCounters;
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+// in the global case my_free only locks the memory block of the pointer, so frees in different
+// memory blocks push to the fastbins and move the rover at the same time, the fastbins are only
+// popped with the mutex locked, so there is only one thread, that pops, and the push and pop with
+// a compare exchange can't see a block twice
+typedef _Atomic(BlockInformation*) block_pointer_t;
+#else
+typedef BlockInformation* block_pointer_t;
+#endif
+
 typedef struct {
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	// protects the list of memory blocks, the fastbins and the counters, the blocks in a memory
+	// block are protected by its stripe, see __my_malloc_stripe
 	pthread_mutex_t mutex;
 #endif
 	MemoryBlockinformation* block;
 	uint64_t defaultMemoryBlockSize;
+	// how often the size of new memory blocks grew, see __my_malloc_growth_size, every new memory
+	// block increases it, every released one decreases it
+	uint32_t growthSteps;
+	AllocatorCounters counters;
+	// the block, that was allocated last, next fit starts its search there, it is moved to the
+	// block, that absorbs it, when it is merged, and reset, when its memory block is released
+	block_pointer_t rover;
+	// the last freed block of every small size, the next one is stored in the data of the block
+	block_pointer_t fastbins[MY_MALLOC_FASTBIN_COUNT];
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	// my_malloc, my_realloc and my_memalign map new memory blocks without the mutex: with
+	// deferMapping set, a search, that needs one, only reserves its address and size and fails,
+	// then the memory block is mapped and put into reserved, the next search takes it from there
+	bool deferMapping;
+	void* reservedAddress;
+	uint64_t reservedSize;
+	MemoryBlockinformation* reserved;
+	// the memory blocks, that were released with the mutex locked, linked with next, they are
+	// unmapped after it is unlocked, see __my_malloc_unlock
+	MemoryBlockinformation* unmapList;
+#endif
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	// every thread registers its GlobalObject in a single linked list, so that my_allocator_stats
+	// can read the counters of every thread
+	bool registered;
+	void* nextThread;
+#endif
 } GlobalObject;
 
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * updates the counters after a memory block was mapped (positive) or unmapped (negative)
+ */
+static inline void __my_malloc_count_mapping(AllocatorCounters* counters, uint64_t size,
+                                             bool mapped) {
+	if(mapped) {
+		__my_malloc_counter_add(counters->mappedBytes, size);
+		__my_malloc_counter_add(counters->memoryBlocks, 1);
+		__my_malloc_counter_add(counters->mmapCalls, 1);
+	} else {
+		__my_malloc_counter_add(counters->mappedBytes, -size);
+		__my_malloc_counter_add(counters->memoryBlocks, -(uint64_t)1);
+		__my_malloc_counter_add(counters->munmapCalls, 1);
+	}
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * adds the counters of source to destination
+ */
+static inline void __my_malloc_merge_counters(AllocatorCounters* destination,
+                                              AllocatorCounters* source) {
+	__my_malloc_counter_add(destination->mappedBytes,
+	                        __my_malloc_counter_get(source->mappedBytes));
+	__my_malloc_counter_add(destination->memoryBlocks,
+	                        __my_malloc_counter_get(source->memoryBlocks));
+	__my_malloc_counter_add(destination->mmapCalls, __my_malloc_counter_get(source->mmapCalls));
+	__my_malloc_counter_add(destination->munmapCalls,
+	                        __my_malloc_counter_get(source->munmapCalls));
+	__my_malloc_counter_add(destination->usedBytes, __my_malloc_counter_get(source->usedBytes));
+	__my_malloc_counter_add(destination->usedBlocks, __my_malloc_counter_get(source->usedBlocks));
+}
+
 #if _PER_THREAD_ALLOCATOR == 0 || defined(_ALLOCATOR_NOT_MT_SAVE)
 static GlobalObject __my_malloc_globalObject = { .defaultMemoryBlockSize = 0 };
 #else
@@ -82,589 +253,3112 @@ static GlobalObject __my_malloc_globalObject = { .defaultMemoryBlockSize = 0 };
 // keyword "_Thread_local" (underscore Uppercase, and double underscore  + any case are reserved
 // words for the c standard, so this was introduced in c11, there exists a typedef thread_local for
 // that, but I rather use the Keyword directly )
-// ATTENTION: each Thread also has to call my_allocator_init, otherwise this is NULL and I DON'T
-// check if it's NULL ANYWHERE, meaning it will crash rather instantly trying to read from or store
-// to address 0!! from the data entry in the struct, that is 0 initialized!)
+// every thread initializes it lazily on its first allocation, with the size, that was given to
+// my_allocator_init (by any thread), at the exit of the thread the memory blocks are unmapped, or
+// if they still have allocated blocks in them, given to the orphan object
 static _Thread_local GlobalObject __my_malloc_globalObject = { .defaultMemoryBlockSize = 0 };
 #endif
 
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+// the default memory block size, that my_allocator_init set, every thread reads that, when
+// initializing its own GlobalObject
+static _Atomic uint64_t __my_malloc_defaultMemoryBlockSize = 0;
+
+// the memory blocks of exited threads, that still have allocated blocks in them, get adopted by
+// this, every thread can free these blocks, so this is protected by its own mutex
+static GlobalObject __my_malloc_orphanObject = { .defaultMemoryBlockSize = 0 };
+static pthread_mutex_t __my_malloc_orphanMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// the value of this key is the GlobalObject of the thread, it's only used for the destructor, that
+// is run at the exit of every thread, that allocated something
+static pthread_key_t __my_malloc_threadKey;
+static pthread_once_t __my_malloc_threadKeyOnce = PTHREAD_ONCE_INIT;
+
+// the list of the GlobalObjects of all running threads, that allocated something, the counters of
+// exited threads are added to the retired counters, both are protected by the stats mutex
+static GlobalObject* __my_malloc_threadList = NULL;
+static AllocatorCounters __my_malloc_retiredCounters;
+static pthread_mutex_t __my_malloc_statsMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
+
+// the fit policy and its threshold, they are set by my_allocator_init_ex, before the allocator is
+// used, and only read afterwards, so every GlobalObject (of every thread) uses the same
+static enum my_malloc_fit __my_malloc_fit = MY_MALLOC_FIT_BEST;
+static uint32_t __my_malloc_goodEnoughPercent = 0;
+
+// the geometric growth of the memory blocks, set the same way, a growth of 0 percent keeps every
+// memory block at the default size, the maximum size caps the growth, and neighbouring memory
+// blocks are only merged up to it, so that a big heap still uses many stripes
+static uint32_t __my_malloc_growthPercent = 0;
+static uint64_t __my_malloc_maxMemoryBlockSize = 0;
+static bool __my_malloc_mergeMemoryBlocks = true;
+
+// the maximum size, if my_allocator_options doesn't set one, as a multiple of the default size
+#define MY_MALLOC_DEFAULT_MAX_FACTOR 64U
+
 /**
  * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * @note Needs to be called with the mutex locked, in order to be thread safe!
- *
+ * the size of a new memory block after that many growth steps, it is the default size, that grew
+ * by __my_malloc_growthPercent in every step, rounded up to whole pages and capped at
+ * __my_malloc_maxMemoryBlockSize
  */
-INTERNAL_FUNCTION MemoryBlockinformation* get_memory_block_by_number(block_number_t number) {
+static inline uint64_t __my_malloc_growth_size(uint64_t defaultMemoryBlockSize, uint32_t steps) {
+	if(__my_malloc_growthPercent == 0) {
+		return defaultMemoryBlockSize;
+	}
 
-	MemoryBlockinformation* nextMemoryBlock =
-	    (MemoryBlockinformation*)__my_malloc_globalObject.block; // may be NULL
+	uint64_t size = defaultMemoryBlockSize;
 
-	while(nextMemoryBlock != NULL) {
+	for(uint32_t i = 0; i < steps && size < __my_malloc_maxMemoryBlockSize; ++i) {
+		size += (size / 100) * __my_malloc_growthPercent;
+		size = (size + (MY_MALLOC_PAGE_SIZE - 1)) & ~(MY_MALLOC_PAGE_SIZE - 1);
+	}
 
-		if(nextMemoryBlock->number == number) {
-			return nextMemoryBlock;
-		}
+	return size < __my_malloc_maxMemoryBlockSize ? size : __my_malloc_maxMemoryBlockSize;
+}
 
-		nextMemoryBlock = nextMemoryBlock->next;
-	};
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the first block of a memory block is directly after the MemoryBlockinformation
+ */
+static inline BlockInformation* get_first_block(MemoryBlockinformation* memoryBlock) {
+	return (BlockInformation*)(((pseudoByte*)memoryBlock) + sizeof(MemoryBlockinformation));
+}
 
-	return NULL;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the fastbin of an aligned size, that is at most MY_MALLOC_FASTBIN_MAX_SIZE, the smallest block
+ * with its header is two alignments big
+ */
+static inline block_pointer_t* __my_malloc_fastbin(GlobalObject* globalObject, uint64_t size) {
+	return &globalObject->fastbins[(size + sizeof(BlockInformation)) / MY_MALLOC_ALIGNMENT - 2];
 }
 
 /**
  * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * @note Needs to be called with the mutex locked, in order to be thread safe!
+ * the next block in the same fastbin, it is stored in the data of the block
+ */
+static inline BlockInformation** __my_malloc_fastbin_next(BlockInformation* block) {
+	return (BlockInformation**)((pseudoByte*)block + sizeof(BlockInformation));
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
  *
+ * puts the block on top of the fastbin
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
  */
-INTERNAL_FUNCTION MemoryBlockinformation* get_last_memory_block() {
+static inline void __my_malloc_fastbin_push(block_pointer_t* fastbin, BlockInformation* block) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	BlockInformation* top = atomic_load_explicit(fastbin, memory_order_relaxed);
 
-	MemoryBlockinformation* nextMemoryBlock =
-	    (MemoryBlockinformation*)__my_malloc_globalObject.block; // may be NULL
+	do {
+		*__my_malloc_fastbin_next(block) = top;
+	} while(!atomic_compare_exchange_weak_explicit(fastbin, &top, block, memory_order_release,
+	                                               memory_order_relaxed));
+#else
+	*__my_malloc_fastbin_next(block) = *fastbin;
+	*fastbin = block;
+#endif
+}
 
-	while(nextMemoryBlock != NULL) {
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * takes the block on top of the fastbin, returns NULL, if it is empty
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ */
+static inline BlockInformation* __my_malloc_fastbin_pop(block_pointer_t* fastbin) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	BlockInformation* top = atomic_load_explicit(fastbin, memory_order_acquire);
 
-		if(nextMemoryBlock->next == NULL) {
-			return nextMemoryBlock;
-		}
+	while(top != NULL &&
+	      !atomic_compare_exchange_weak_explicit(fastbin, &top, *__my_malloc_fastbin_next(top),
+	                                             memory_order_acquire, memory_order_acquire)) {
+	}
 
-		nextMemoryBlock = nextMemoryBlock->next;
-	};
+	return top;
+#else
+	BlockInformation* top = *fastbin;
 
-	return NULL;
+	if(top != NULL) {
+		*fastbin = *__my_malloc_fastbin_next(top);
+	}
+
+	return top;
+#endif
 }
 
 /**
  * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * @note Needs to be called with the mutex locked, in order to be thread safe!
+ * empties the fastbins, without merging the blocks in there, so this is only for GlobalObjects,
+ * whose memory blocks are unmapped, or adopted by another GlobalObject
+ */
+static inline void __my_malloc_fastbins_reset(GlobalObject* globalObject) {
+	for(size_t i = 0; i < MY_MALLOC_FASTBIN_COUNT; ++i) {
+		globalObject->fastbins[i] = NULL;
+	}
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
  *
+ * has to be called, when the header of a block is removed, by merging it into the survivor (which
+ * may be NULL), so that the rover never points to a removed header
  */
-INTERNAL_FUNCTION block_number_t get_next_free_memory_number() {
+static inline void __my_malloc_block_removed(GlobalObject* globalObject, BlockInformation* removed,
+                                             BlockInformation* survivor) {
+	if(globalObject->rover == removed) {
+		globalObject->rover = survivor;
+	}
+}
 
-	block_number_t start = 0;
+// every memory block, that a GlobalObject (of any thread) uses, is in this registry, sorted by its
+// address, with the GlobalObject, that owns it, so that free and realloc can check a pointer with a
+// binary search, before they read its header, and my_allocator_owns can answer without a lock.
+// The array is never changed, while it is published, a writer writes a changed copy into a second
+// buffer and publishes that, the old one is the second buffer of the next change, after every
+// reader of it is done, for that the readers count themselves in the counter of the current epoch,
+// and the writer flips the epoch and waits until the counter of the old one is 0, so the readers
+// never wait
+typedef struct {
+	uintptr_t start;
+	uintptr_t end;
+	const GlobalObject* owner;
+} RegistryEntry;
+
+typedef struct {
+	uint64_t count;
+	// the number of entries, that fit into the mapping
+	uint64_t capacity;
+	uint64_t mappedSize;
+	RegistryEntry entries[];
+} ChunkRegistry;
+
+static _Atomic(ChunkRegistry*) __my_malloc_registry = NULL;
+// the buffer, that isn't published, the two only grow, so a change only maps, if it doesn't fit
+static ChunkRegistry* __my_malloc_registrySpare = NULL;
+static _Atomic uint64_t __my_malloc_registryEpoch = 0;
+static _Atomic uint64_t __my_malloc_registryReaders[2];
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+// the writers are serialized by this, so only one epoch is flipped at a time
+static pthread_mutex_t __my_malloc_registryMutex = PTHREAD_MUTEX_INITIALIZER;
+#endif
 
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the current registry (may be NULL), it stays valid until __my_malloc_registry_leave is
+ * called with the epoch, this must not wait for anything in between
+ */
+static inline const ChunkRegistry* __my_malloc_registry_enter(uint64_t* epoch) {
 	while(true) {
+		*epoch = atomic_load(&__my_malloc_registryEpoch);
+		atomic_fetch_add(&__my_malloc_registryReaders[*epoch % 2], 1);
 
-		// we need to cover some potential strange pattern:
-		// e.g. 0 1 3 4 5 2 needs to say 6
-		// but 0 1 3 4 5 6 needs to say 2
-		bool needsRestart = false;
+		// if the epoch was flipped in between, the writer may not have seen this reader
+		if(atomic_load(&__my_malloc_registryEpoch) == *epoch) {
+			return atomic_load(&__my_malloc_registry);
+		}
 
-		const block_number_t oldStart = start;
+		atomic_fetch_sub(&__my_malloc_registryReaders[*epoch % 2], 1);
+	}
+}
 
-		MemoryBlockinformation* nextMemoryBlock =
-		    (MemoryBlockinformation*)__my_malloc_globalObject.block;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the end of the read, that __my_malloc_registry_enter started
+ */
+static inline void __my_malloc_registry_leave(uint64_t epoch) {
+	atomic_fetch_sub(&__my_malloc_registryReaders[epoch % 2], 1);
+}
 
-		while(nextMemoryBlock != NULL) {
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the binary search for the entry, that contains the address, returns NULL, if there is none
+ */
+static const RegistryEntry* __my_malloc_registry_find(const ChunkRegistry* registry,
+                                                      const void* address) {
+	if(registry == NULL) {
+		return NULL;
+	}
 
-			if(nextMemoryBlock->number == start) {
-				start = nextMemoryBlock->number + 1;
-			} else if(nextMemoryBlock->number > start) {
-				needsRestart = true;
-			}
+	uint64_t low = 0;
+	uint64_t high = registry->count;
 
-			nextMemoryBlock = nextMemoryBlock->next;
-		};
+	// the first entry, that ends after the address
+	while(low < high) {
+		const uint64_t middle = low + (high - low) / 2;
 
-		// no rerun needed => start is settled, if the rerun didn't change anything, it is settled
-		if(!needsRestart || (needsRestart && start == oldStart)) {
-			break;
+		if(registry->entries[middle].end <= (uintptr_t)address) {
+			low = middle + 1;
+		} else {
+			high = middle;
 		}
 	}
 
-	return start;
+	if(low < registry->count && registry->entries[low].start <= (uintptr_t)address) {
+		return &registry->entries[low];
+	}
+
+	return NULL;
 }
 
 /**
  * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * @note Needs to be called with the mutex locked, in order to be thread safe!
+ * returns the buffer, that isn't published, for count entries, that aren't set yet, it is mapped
+ * again, with twice the entries, if they don't fit, no reader reads it, so it can be unmapped
  *
+ * @note Needs to be called with the registry mutex locked, in order to be thread safe!
  */
-INTERNAL_FUNCTION uint64_t size_of_double_pointer_block(BlockInformation* block) {
-	if(block == NULL) {
-		printSingleErrorAndExit(
-		    "INTERNAL: This is an allocator ERROR, this shouldn't occur: block is NULL\n");
-	} else if(block->nextBlock == NULL) {
-		const MemoryBlockinformation* currentMemoryBlock =
-		    get_memory_block_by_number(block->blockNumber);
-		if(currentMemoryBlock == NULL) {
-			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-			                        "currentMemoryBlock is NULL\n");
-		}
-
-		return (((pseudoByte*)currentMemoryBlock + currentMemoryBlock->size) - (pseudoByte*)block) -
-		       sizeof(BlockInformation);
-	} else if(block->blockNumber == ((BlockInformation*)block->nextBlock)->blockNumber) {
-		return ((pseudoByte*)block->nextBlock - (pseudoByte*)block) - sizeof(BlockInformation);
-	} else {
-		const MemoryBlockinformation* currentMemoryBlock =
-		    get_memory_block_by_number(block->blockNumber);
-
-		if(currentMemoryBlock == NULL) {
-			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-			                        "currentMemoryBlock is NULL\n");
-		}
+static ChunkRegistry* __my_malloc_registry_allocate(uint64_t count) {
+	ChunkRegistry* registry = __my_malloc_registrySpare;
 
-		// in this case the memory is the same, as if the nextBlock was NULL, since the contigious
-		// block ends here, we assert a bunch of stuff regarding the position of the next block, it
-		// HAS to be the first of the new memoryBlock, the number there doesn't have to be one
-		// larger, it just has to be not the same. It is mostly one larger, but don't rely on that!
-		// Also there must be a nextMemoryBlock, if the next Pointer is not NULL
+	if(registry == NULL || registry->capacity < count) {
+		const uint64_t capacity =
+		    registry == NULL || registry->capacity * 2 < count ? count : registry->capacity * 2;
 
-		const MemoryBlockinformation* nextMemoryBlock =
-		    (MemoryBlockinformation*)currentMemoryBlock->next;
+		const uint64_t mappedSize =
+		    (sizeof(ChunkRegistry) + capacity * sizeof(RegistryEntry) + (MY_MALLOC_PAGE_SIZE - 1)) &
+		    ~(MY_MALLOC_PAGE_SIZE - 1);
 
-		if(nextMemoryBlock->next == NULL) {
-			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-			                        "nextMemoryBlock is NULL\n");
+		if(registry != NULL) {
+			int result = munmap(registry, registry->mappedSize);
+			checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
 		}
 
-		if(currentMemoryBlock->number == nextMemoryBlock->number) {
-			printSingleErrorAndExit(
-			    "INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-			    "currentMemoryBlock and nextMemoryBlock have the same number\n");
-		}
+		registry =
+		    mmap(NULL, mappedSize, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
 
-		if((pseudoByte*)nextMemoryBlock !=
-		   ((pseudoByte*)block->nextBlock) - sizeof(MemoryBlockinformation)) {
-			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-			                        "nextBlock in another memory block isn't the first block\n");
+		if(registry == MAP_FAILED) {
+			printErrorAndExit("INTERNAL: Failed to mmap the registry of the allocator: %s\n",
+			                  strerror(errno));
 		}
 
-		return (((pseudoByte*)currentMemoryBlock + currentMemoryBlock->size) - (pseudoByte*)block) -
-		       sizeof(BlockInformation);
+		registry->capacity = (mappedSize - sizeof(ChunkRegistry)) / sizeof(RegistryEntry);
+		registry->mappedSize = mappedSize;
+		__my_malloc_registrySpare = registry;
 	}
+
+	registry->count = count;
+
+	return registry;
 }
 
 /**
- * @brief INTERNAL FUNCTION; DO NOT USE
+ * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * @note Needs to be called with the mutex locked, in order to be thread safe!
+ * replaces the old registry (may be NULL) with the new one, the old one is the buffer of the next
+ * change, after every reader of it is done
  *
+ * @note Needs to be called with the registry mutex locked, in order to be thread safe!
  */
-INTERNAL_FUNCTION bool __my_malloc_block_fitsBetter(BlockInformation* toCompare,
-                                                    BlockInformation* currentBlock, uint64_t size) {
+static void __my_malloc_registry_publish(ChunkRegistry* oldRegistry, ChunkRegistry* registry) {
 
-	if(toCompare->status != FREE) {
-		return false;
-	}
+	atomic_store(&__my_malloc_registry, registry);
 
-	if(currentBlock->status != FREE) {
-		return true;
+	// the readers, that started after this, read the new registry
+	const uint64_t oldEpoch = atomic_fetch_add(&__my_malloc_registryEpoch, 1);
+
+	while(atomic_load(&__my_malloc_registryReaders[oldEpoch % 2]) != 0) {
+		sched_yield();
 	}
 
-	const uint64_t blockSize = size_of_double_pointer_block(toCompare);
+	__my_malloc_registrySpare = oldRegistry;
+}
 
-	// if a new block has to be "allocated" then there has to be space for that!
-	if(toCompare->nextBlock == NULL) {
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * adds the memory block to the registry, for the GlobalObject owner, or removes it, if owner is
+ * NULL, it has to be added, after it is initialized, and removed, before it is given away
+ */
+static void __my_malloc_registry_update(MemoryBlockinformation* memoryBlock,
+                                        const GlobalObject* owner) {
 
-		if(blockSize == size) {
-			return true;
-		}
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_lock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+#endif
 
-		if(blockSize < sizeof(BlockInformation) + size) {
-			return false;
+	ChunkRegistry* oldRegistry = atomic_load(&__my_malloc_registry);
+	const uint64_t oldCount = oldRegistry == NULL ? 0 : oldRegistry->count;
+	const bool add = owner != NULL;
+	const uint64_t count = add ? oldCount + 1 : oldCount - 1;
+
+	const uintptr_t start = (uintptr_t)memoryBlock;
+	ChunkRegistry* registry = __my_malloc_registry_allocate(count);
+
+	uint64_t index = 0;
+
+	for(uint64_t i = 0; i < oldCount; ++i) {
+		const RegistryEntry entry = oldRegistry->entries[i];
+
+		if(add && index == i && entry.start > start) {
+			registry->entries[index++] =
+			    (RegistryEntry){ .start = start, .end = start + memoryBlock->size, .owner = owner };
 		}
 
-		if(blockSize == sizeof(BlockInformation) + size) {
-			return true;
+		if((!add && entry.start == start) || index == count) {
+			continue;
 		}
-	}
 
-	if(blockSize < size) {
-		return false;
+		registry->entries[index++] = entry;
 	}
 
-	if(blockSize == size) {
-		return true;
+	if(index < count) {
+		registry->entries[index] =
+		    (RegistryEntry){ .start = start, .end = start + memoryBlock->size, .owner = owner };
 	}
 
-	const uint64_t currentSize = size_of_double_pointer_block(currentBlock);
+	__my_malloc_registry_publish(oldRegistry, registry);
 
-	if(currentSize > size + sizeof(BlockInformation)) {
-		if(blockSize <= size + sizeof(BlockInformation)) {
-			return false;
-		}
-	}
-	return (blockSize - size) < (currentSize - size);
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	result = pthread_mutex_unlock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#endif
 }
 
 /**
- * @brief internal malloc, used by realloc and malloc, but doesn't lock mutexes, that is done by the
- * parent functions, DO NOT us outside of the internals of this file!
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * replaces the entry of the memory block, that started at oldStart, with the memory block, after a
+ * region was merged into it, in front of it or after it, if that region was registered on its own
+ * (merged isn't NULL), its entry is removed in the same step, so that no reader misses a block of
+ * either
  */
-INTERNAL_FUNCTION void* __internal__my_malloc(uint64_t size, BlockInformation* fixedBlock) {
+static void __my_malloc_registry_merge(MemoryBlockinformation* memoryBlock, const void* oldStart,
+                                       const void* merged) {
 
-	// calling my_malloc without initializing the allocator doesn't work, if that is the case,
-	// likely the uninitialized mutex access before this will crash the program, but that is here
-	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
-	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
-		fprintf(stderr, "Calling malloc before initializing the allocator is prohibited!\n");
-		exit(1);
-	}
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_lock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+#endif
 
-	BlockInformation* bestFit = fixedBlock;
-	if(bestFit == NULL && __my_malloc_globalObject.block != NULL) {
+	ChunkRegistry* oldRegistry = atomic_load(&__my_malloc_registry);
+	ChunkRegistry* registry =
+	    __my_malloc_registry_allocate(merged == NULL ? oldRegistry->count : oldRegistry->count - 1);
 
-		bestFit = (BlockInformation*)(((pseudoByte*)__my_malloc_globalObject.block) +
-		                              sizeof(MemoryBlockinformation));
-		BlockInformation* nextFreeBlock = (BlockInformation*)bestFit->nextBlock;
+	const uintptr_t start = (uintptr_t)memoryBlock;
+	uint64_t index = 0;
 
-		while(nextFreeBlock != NULL) {
-			if(__my_malloc_block_fitsBetter(nextFreeBlock, bestFit, size)) {
-				bestFit = nextFreeBlock;
-				// shorthand evaluation, so if it fits perfectly don't look for a better one
-				const uint64_t blockSize = size_of_double_pointer_block(bestFit);
-				if(blockSize == size) {
-					break;
-				}
-			}
-			nextFreeBlock = nextFreeBlock->nextBlock;
+	// the merged region is next to the memory block, so the order stays the same
+	for(uint64_t i = 0; i < oldRegistry->count; ++i) {
+		RegistryEntry entry = oldRegistry->entries[i];
+
+		if(entry.start == (uintptr_t)merged) {
+			continue;
 		}
-	}
 
-	const uint64_t blockSize =
-	    __my_malloc_globalObject.block == NULL ? 0 : size_of_double_pointer_block(bestFit);
+		if(entry.start == (uintptr_t)oldStart) {
+			entry = (RegistryEntry){
+				.start = start, .end = start + memoryBlock->size, .owner = entry.owner
+			};
+		}
 
-	// if the one that fit the best is not big enough, it means no block is big enough! If it's not
-	// free, than there was no free block
-	if(__my_malloc_globalObject.block == NULL || bestFit == NULL || bestFit->status != FREE ||
-	   blockSize < size) {
+		registry->entries[index++] = entry;
+	}
 
-		//  allocate a new memory block, if the size is bigger than pool size, just request a bigger
-		//  one, we can do that here, try first to get a
-		// continuos block, if that works, increase the size of the current one, otherwise just make
-		// a new MemoryBlockInfo structure.
+	__my_malloc_registry_publish(oldRegistry, registry);
 
-		MemoryBlockinformation* lastMemoryBlock = get_last_memory_block(); // may be NULL
-		void* preferredAddress =
-		    lastMemoryBlock == NULL ? NULL : ((pseudoByte*)lastMemoryBlock) + lastMemoryBlock->size;
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	result = pthread_mutex_unlock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#endif
+}
 
-		uint64_t preferredSize = __my_malloc_globalObject.defaultMemoryBlockSize;
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
 
-		if(preferredSize - sizeof(MemoryBlockinformation) - sizeof(BlockInformation) < size) {
-			preferredSize = size + sizeof(MemoryBlockinformation) - sizeof(BlockInformation);
-		}
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * gives every memory block of the owner to the new owner, in one step
+ */
+static void __my_malloc_registry_adopt(const GlobalObject* owner, const GlobalObject* newOwner) {
+
+	int result = pthread_mutex_lock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 
-		void* newRegion = mmap(preferredAddress, preferredSize, PROT_READ | PROT_WRITE,
-		                       MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+	ChunkRegistry* oldRegistry = atomic_load(&__my_malloc_registry);
 
-		if(newRegion == MAP_FAILED) {
-			// don't fail, just return NULL ,indicating Out of memory
-			return NULL;
+	if(oldRegistry != NULL) {
+		ChunkRegistry* registry = __my_malloc_registry_allocate(oldRegistry->count);
+
+		for(uint64_t i = 0; i < oldRegistry->count; ++i) {
+			registry->entries[i] = oldRegistry->entries[i];
+
+			if(registry->entries[i].owner == owner) {
+				registry->entries[i].owner = newOwner;
+			}
 		}
 
-		MEMCHECK_REMOVE_INTERNAL_USE(newRegion, preferredSize);
+		__my_malloc_registry_publish(oldRegistry, registry);
+	}
 
-		MemoryBlockinformation* newMemoryBlock = (MemoryBlockinformation*)newRegion;
+	result = pthread_mutex_unlock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
 
-		MEMCHECK_DEFINE_INTERNAL_USE(newMemoryBlock, sizeof(MemoryBlockinformation));
+#endif
 
-		newMemoryBlock->next = NULL;
-		newMemoryBlock->size = preferredSize;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the header of the block of ptr, if ptr is a block in a memory block of globalObject in
+ * the registry, and its neighbours point to it, otherwise the program is crashed with an error, so
+ * that a foreign or interior pointer, or a block of another running thread, doesn't corrupt the
+ * blocks
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_checked_block(GlobalObject* globalObject, void* ptr,
+                                                              const char* operation) {
 
-		block_number_t blockNumber = get_next_free_memory_number();
-		newMemoryBlock->number = blockNumber;
+	uint64_t epoch = 0;
+	const RegistryEntry* entry = __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr);
 
-		if(lastMemoryBlock == NULL) {
-			__my_malloc_globalObject.block = newMemoryBlock;
-		} else {
-			lastMemoryBlock->next = newMemoryBlock;
-		}
+	const uintptr_t start = entry == NULL ? 0 : entry->start;
+	const uintptr_t end = entry == NULL ? 0 : entry->end;
+	const GlobalObject* owner = entry == NULL ? NULL : entry->owner;
 
-		BlockInformation* newBlock =
-		    (BlockInformation*)((pseudoByte*)newRegion + sizeof(MemoryBlockinformation));
+	__my_malloc_registry_leave(epoch);
 
-		// no adding the BlockInformation to the memoryBlock
-		MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+	BlockInformation* block = (BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation));
+	MemoryBlockinformation* memoryBlock = (MemoryBlockinformation*)start;
 
-		newBlock->nextBlock = NULL;
-		newBlock->status = FREE;
-		newBlock->blockNumber = blockNumber;
+	// the header has to be in the memory block and aligned, like every header
+	bool valid = entry != NULL && (uintptr_t)ptr % MY_MALLOC_ALIGNMENT == 0 &&
+	             (uintptr_t)block >= (uintptr_t)get_first_block(memoryBlock);
 
-		// FIND previous block, to set the nextBlock there to the newBlock and set the previousBlock
-		// on the newBlock, if there is a previous block (not possible, if there where 0 blocks)
+	// one registry holds the memory blocks of every thread, so a block of another running thread
+	// passes the other checks, but it mustn't be put into the free lists of this one
+	valid = valid && owner == globalObject;
 
-		if(lastMemoryBlock != NULL) {
+	// the memory block belongs to the caller, so the header and its neighbours can be read
+	if(valid) {
+		BlockInformation* firstBlock = get_first_block(memoryBlock);
+		BlockInformation* nextBlock = (BlockInformation*)block->nextBlock;
+		BlockInformation* previousBlock = (BlockInformation*)block->previousBlock;
 
-			BlockInformation* lastBlockOfLastMemBlock =
-			    (BlockInformation*)(((pseudoByte*)lastMemoryBlock) +
-			                        sizeof(MemoryBlockinformation));
+		valid = (block->status == FREE || block->status == ALLOCED) &&
+		        block->blockNumber == memoryBlock->number;
 
-			while(lastBlockOfLastMemBlock->nextBlock != NULL) {
-				lastBlockOfLastMemBlock = (BlockInformation*)lastBlockOfLastMemBlock->nextBlock;
-			}
+		// the header of an interior pointer is some data, so its neighbours don't point to it
+		if(valid && previousBlock == NULL) {
+			valid = block == firstBlock;
+		} else if(valid) {
+			valid = (uintptr_t)previousBlock >= (uintptr_t)firstBlock &&
+			        (uintptr_t)previousBlock < (uintptr_t)block &&
+			        previousBlock->nextBlock == block;
+		}
 
-			newBlock->previousBlock = lastBlockOfLastMemBlock;
-			lastBlockOfLastMemBlock->nextBlock = newBlock;
+		if(valid && nextBlock != NULL) {
+			valid = (uintptr_t)nextBlock > (uintptr_t)block &&
+			        (uintptr_t)nextBlock + sizeof(BlockInformation) <= end &&
+			        nextBlock->previousBlock == block;
 		}
+	}
 
-		// Now call internal malloc with the new block as hint, to use it, without duplicating code
-		// and searching for it, if we already have it
+	if(!valid) {
+		printErrorAndExit("ERROR: You tried to %s a pointer, that isn't a block of the allocator: "
+		                  "%p\n",
+		                  operation, ptr);
+	}
 
-		return __internal__my_malloc(size, newBlock);
-	};
+	return block;
+}
 
-	if(blockSize - size <= (sizeof(BlockInformation))) {
-		// block size and size needed for allocation is the same, only need to set the status to
-		// allocated
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the size of the block, the same as size_of_double_pointer_block, but the end of the
+ * memory block of the last block is read from the registry, instead of searching the list of memory
+ * blocks, that free can't read with only the stripe locked
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
+ */
+static uint64_t __my_malloc_registered_block_size(BlockInformation* block) {
+	if(block->nextBlock != NULL) {
+		return ((pseudoByte*)block->nextBlock - (pseudoByte*)block) - sizeof(BlockInformation);
+	}
 
-		// OR
+	uint64_t epoch = 0;
+	const RegistryEntry* entry =
+	    __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), block);
+	const uintptr_t end = entry == NULL ? 0 : entry->end;
+	__my_malloc_registry_leave(epoch);
 
-		// block size and size needed for allocation is nearly the same, but can't allocate a new
-		// block at the end, since it hasn't enough space for another BlockInformation, so only need
-		// to set the status to allocated, but some size is wasted, it can create a gap of 1 or
-		// more, that is fine, but gaps of 0 or less just "waste" that memory -- this handling
-		// implicates, that no position of previous or next block may be calculated by using the
-		// size!!
+	if(end == 0) {
+		printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: the "
+		                        "block isn't in a registered memory block\n");
+	}
 
-		bestFit->status = ALLOCED;
+	return (end - (uintptr_t)block) - sizeof(BlockInformation);
+}
 
-	} else {
-		BlockInformation* newBlock =
-		    (BlockInformation*)(((pseudoByte*)bestFit + sizeof(BlockInformation)) + size);
-		MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
 
-		// the new gap is at least 1 byte big, see above!
+// the number of locks, that the memory blocks share, a set of them has to fit into an uint64_t
+#define MY_MALLOC_STRIPES 64
 
-		newBlock->status = FREE;
-		newBlock->nextBlock = bestFit->nextBlock; // can be NULL
-		newBlock->previousBlock = bestFit;
-		newBlock->blockNumber = bestFit->blockNumber;
+// the blocks of a memory block are protected by the stripe of its number, a lock in the
+// MemoryBlockinformation would change the alignment of the first block. free only locks the stripe
+// of its block, so frees in different memory blocks run in parallel, everything else locks the
+// mutex and then the stripes of every memory block in the list, only the owner of the mutex locks
+// more than one stripe, so they can't deadlock
+static pthread_mutex_t __my_malloc_stripes[MY_MALLOC_STRIPES];
 
-		bestFit->status = ALLOCED;
-		bestFit->nextBlock = newBlock;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the stripe of the memory block with that number
+ */
+static inline pthread_mutex_t* __my_malloc_stripe(block_number_t number) {
+	return &__my_malloc_stripes[number % MY_MALLOC_STRIPES];
+}
 
-		if(newBlock->nextBlock != NULL) {
-			((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
-		}
-	}
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * locks the stripes of every memory block of the GlobalObject, in order, and returns the set of
+ * them, for __my_malloc_unlock_stripes, memory blocks, that are mapped after this, don't need
+ * theirs, since no other thread has a block in them
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ */
+static uint64_t __my_malloc_lock_stripes(GlobalObject* globalObject) {
+	uint64_t stripes = 0;
 
-	void* returnValue = (pseudoByte*)bestFit + sizeof(BlockInformation);
+	for(MemoryBlockinformation* memoryBlock = globalObject->block; memoryBlock != NULL;
+	    memoryBlock = memoryBlock->next) {
+		stripes |= (uint64_t)1 << (memoryBlock->number % MY_MALLOC_STRIPES);
+	}
 
-	MEMCHECK_DEFINE_INTERNAL_USE(bestFit, sizeof(BlockInformation));
-	VALGRIND_ALLOC(returnValue, size, 0, false);
+	for(uint64_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		if((stripes & ((uint64_t)1 << i)) != 0) {
+			int result = pthread_mutex_lock(&__my_malloc_stripes[i]);
+			checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to lock the "
+			                                 "mutex in the internal allocator");
+		}
+	}
 
-	return returnValue;
+	return stripes;
 }
 
 /**
- * @note MT-safe - with thread_local storage, this only accesses that, otherwise a mutex is
- * used, if this is called without initializing the underlying allocator beforehand, it is
- * undefined behaviour, however this function crashes the program in that case
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * unlocks the stripes, that __my_malloc_lock_stripes locked
  */
-void* my_malloc(uint64_t size) {
-
-#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
-
-	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
-		fprintf(stderr, "Calling malloc before initializing the allocator is prohibited!\n");
-		exit(1);
+static void __my_malloc_unlock_stripes(uint64_t stripes) {
+	for(uint64_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		if((stripes & ((uint64_t)1 << i)) != 0) {
+			int result = pthread_mutex_unlock(&__my_malloc_stripes[i]);
+			checkResultForThreadErrorAndExit(
+			    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+		}
 	}
+}
+
+// free only locks the stripe of its block, so the freed bytes and blocks are counted per stripe,
+// only usedBytes and usedBlocks of these are used, they are protected like the blocks
+static AllocatorCounters __my_malloc_stripeCounters[MY_MALLOC_STRIPES];
 
-	// mutex errors are better when being asserted, since no real errors can occur, only when the
-	// system is already malfunctioning
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 #endif
 
-	void* returnValue = __internal__my_malloc(size, NULL);
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * updates the used counters, after a block was allocated (one block), or resized in place (no
+ * block, the difference of the sizes), the sizes are the ones of the blocks, not the requested ones
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ */
+static inline void __my_malloc_count_used(GlobalObject* globalObject, uint64_t bytes,
+                                          uint64_t blocks) {
+	__my_malloc_counter_add(globalObject->counters.usedBytes, bytes);
+	__my_malloc_counter_add(globalObject->counters.usedBlocks, blocks);
+}
 
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * updates the used counters, after the block of that size was freed, in the global case the
+ * counters of its stripe are used, since free doesn't lock the mutex
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
+ */
+static inline void __my_malloc_count_freed(GlobalObject* globalObject,
+                                           const BlockInformation* block, uint64_t size) {
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+	(void)globalObject;
+	AllocatorCounters* counters =
+	    &__my_malloc_stripeCounters[block->blockNumber % MY_MALLOC_STRIPES];
+#else
+	(void)block;
+	AllocatorCounters* counters = &globalObject->counters;
 #endif
 
-	return returnValue;
+	__my_malloc_counter_add(counters->usedBytes, -size);
+	__my_malloc_counter_add(counters->usedBlocks, -(uint64_t)1);
 }
 
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+
+// the number of empty memory blocks, that the global pool can hold, if it is full, they are
+// unmapped
+#define MY_MALLOC_CHUNK_POOL_SLOTS 64
+
+// memory blocks, that are bigger than this multiple of the default size, are never pooled, these
+// only hold one big allocation, and are rarely reused with the same size
+#define MY_MALLOC_CHUNK_POOL_MAX_FACTOR 4
+
+// the free memory watermark of a thread, as a multiple of the default size, empty memory blocks are
+// only given to the pool, if the thread has more free memory than this
+#define MY_MALLOC_FREE_WATERMARK_FACTOR 2
+
+// the global pool of empty memory blocks, that is shared between all threads, it is lock free,
+// every slot is either NULL or holds an empty memory block, a slot is taken with an atomic
+// exchange, so only one thread can get it, the sizes are only hints, to not take memory blocks,
+// that are too small, the real size is checked after taking it, since only the owner may read the
+// memory block
+static _Atomic(MemoryBlockinformation*) __my_malloc_chunkPool[MY_MALLOC_CHUNK_POOL_SLOTS];
+static _Atomic uint64_t __my_malloc_chunkPoolSizes[MY_MALLOC_CHUNK_POOL_SLOTS];
+
 /**
- * @brief internal free, used by realloc and free, but doesn't lock mutexes, that is done by the
- * parent functions, DO NOT us outside of the internals of this file!
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * puts the empty memory block into the global pool, returns false, if it wasn't pooled, then the
+ * caller still owns it
  */
-INTERNAL_FUNCTION void __internal__my_free(void* ptr) {
+static bool __my_malloc_chunk_pool_donate(MemoryBlockinformation* memoryBlock) {
 
-	// calling my_free without initializing the allocator doesn't work, if that is the case,
-	// likely the uninitialized mutex access before this will crash the program, but that is here
-	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
-	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
-		fprintf(stderr, "Calling free before initializing the allocator is prohibited!\n");
-		exit(1);
+	const uint64_t memoryBlockSize = memoryBlock->size;
+
+	if(memoryBlockSize > MY_MALLOC_CHUNK_POOL_MAX_FACTOR *
+	                         atomic_load_explicit(&__my_malloc_defaultMemoryBlockSize,
+	                                              memory_order_relaxed)) {
+		return false;
 	}
 
-	BlockInformation* currentBlock =
-	    (BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation));
+	for(size_t i = 0; i < MY_MALLOC_CHUNK_POOL_SLOTS; ++i) {
+		MemoryBlockinformation* expected = NULL;
 
-	if(__my_malloc_globalObject.block == NULL) {
-		// no block is not free, since we have no block anymore xD
-		printErrorAndExit("ERROR: You tried to free a already freed Block: %p\n", ptr);
-	}
+		if(atomic_load_explicit(&__my_malloc_chunkPool[i], memory_order_relaxed) != NULL) {
+			continue;
+		}
 
-	if(currentBlock->status == FREE) {
-		printErrorAndExit("ERROR: You tried to free a already freed Block: %p\n", ptr);
+		// the release order publishes the content of the memory block to the thread, that takes it
+		if(atomic_compare_exchange_strong_explicit(&__my_malloc_chunkPool[i], &expected,
+		                                           memoryBlock, memory_order_release,
+		                                           memory_order_relaxed)) {
+			atomic_store_explicit(&__my_malloc_chunkPoolSizes[i], memoryBlockSize,
+			                      memory_order_relaxed);
+			return true;
+		}
 	}
 
-	currentBlock->status = FREE;
-	VALGRIND_FREE(ptr, 0);
+	return false;
+}
 
-	BlockInformation* nextBlock = (BlockInformation*)currentBlock->nextBlock;
-	BlockInformation* previousBlock = (BlockInformation*)currentBlock->previousBlock;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * takes an empty memory block out of the global pool, that is at least size big, but not more than
+ * twice that, returns NULL, if there is none
+ */
+static MemoryBlockinformation* __my_malloc_chunk_pool_take(GlobalObject* globalObject,
+                                                           uint64_t size) {
 
-	bool currentWasRemoved = false;
+	for(size_t i = 0; i < MY_MALLOC_CHUNK_POOL_SLOTS; ++i) {
 
-	// merge with previous free block, if in 5the same memory block!
-	if(previousBlock != NULL && previousBlock->status == FREE &&
-	   previousBlock->blockNumber == currentBlock->blockNumber) {
+		const uint64_t hint =
+		    atomic_load_explicit(&__my_malloc_chunkPoolSizes[i], memory_order_relaxed);
 
-		// MERGE three free blocks into one: layout Previous | Current | Next => New Free one
-		if(nextBlock != NULL && nextBlock->status == FREE &&
-		   nextBlock->blockNumber == currentBlock->blockNumber) {
-			previousBlock->nextBlock = nextBlock->nextBlock; // Can be NULL
+		if(hint < size || hint / 2 > size ||
+		   atomic_load_explicit(&__my_malloc_chunkPool[i], memory_order_relaxed) == NULL) {
+			continue;
+		}
 
-			if(nextBlock->nextBlock != NULL) {
-				((BlockInformation*)nextBlock->nextBlock)->previousBlock = previousBlock;
-			}
-			// merge previous free block with current one
-		} else {
+		MemoryBlockinformation* memoryBlock =
+		    atomic_exchange_explicit(&__my_malloc_chunkPool[i], NULL, memory_order_acquire);
 
-			previousBlock->nextBlock = nextBlock; // can be NULL
-			if(nextBlock != NULL) {
-				nextBlock->previousBlock = previousBlock;
-			}
+		if(memoryBlock == NULL) {
+			continue;
 		}
 
-		MEMCHECK_REMOVE_INTERNAL_USE(currentBlock, sizeof(BlockInformation));
-		currentWasRemoved = true;
+		// the hint may be from another memory block, that was in this slot before
+		if(memoryBlock->size >= size && memoryBlock->size / 2 <= size) {
+			return memoryBlock;
+		}
 
-		// merge next free block with current one, if in the same memory block
-	} else if(nextBlock != NULL && nextBlock->status == FREE &&
-	          nextBlock->blockNumber == currentBlock->blockNumber) {
-		currentBlock->nextBlock = nextBlock->nextBlock; // can be NULL
+		if(!__my_malloc_chunk_pool_donate(memoryBlock)) {
+			const uint64_t memoryBlockSize = memoryBlock->size;
 
-		if(nextBlock->nextBlock != NULL) {
-			((BlockInformation*)nextBlock->nextBlock)->previousBlock = currentBlock;
-		}
+			int result = munmap(memoryBlock, memoryBlockSize);
+			checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
 
-		MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
+			MEMCHECK_REMOVE_INTERNAL_USE(memoryBlock, memoryBlockSize);
+			__my_malloc_count_mapping(&globalObject->counters, memoryBlockSize, false);
+		}
 	}
 
-	// if a new EMPTY memory block was created munmap it!
+	return NULL;
+}
 
-	// step 1: get the potential start block of a memory block, this can't be the next, since that
-	// would have deleted the memory block on his free, if it was totally free
-	BlockInformation* potentialFirstBlock = currentBlock;
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * unmaps every memory block in the global pool, a memory block, that another thread donates in
+ * between, stays in there
+ */
+static void __my_malloc_chunk_pool_drain(GlobalObject* globalObject) {
 
-	// Case 1, previous was free and is in the same memory block
-	if(previousBlock != NULL && previousBlock->status == FREE &&
-	   (currentWasRemoved || previousBlock->blockNumber == currentBlock->blockNumber)) {
-		potentialFirstBlock = previousBlock;
-	}
+	for(size_t i = 0; i < MY_MALLOC_CHUNK_POOL_SLOTS; ++i) {
 
-	// case 2, current is the potential start (do nothing, as potentialFirstBlock is already
-	// correct)
+		MemoryBlockinformation* memoryBlock =
+		    atomic_exchange_explicit(&__my_malloc_chunkPool[i], NULL, memory_order_acquire);
 
-	// step 2: get the start of the current block
-	MemoryBlockinformation* currentMemoryBlock =
-	    get_memory_block_by_number(potentialFirstBlock->blockNumber);
+		if(memoryBlock == NULL) {
+			continue;
+		}
 
-	if(currentMemoryBlock == NULL) {
-		printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
-		                        "currentMemoryBlock is NULL\n");
-	}
+		const uint64_t memoryBlockSize = memoryBlock->size;
 
-	// step 3: test if the potentialFirstBlock is the first block, and it also spans the whole block
-	// (and is free, but that is already assured)
-	if((pseudoByte*)currentMemoryBlock + sizeof(MemoryBlockinformation) ==
-	       (pseudoByte*)potentialFirstBlock &&
-	   (potentialFirstBlock->nextBlock == NULL ||
-	    (pseudoByte*)potentialFirstBlock->nextBlock >
-	        ((pseudoByte*)currentMemoryBlock + currentMemoryBlock->size) ||
-	    (pseudoByte*)potentialFirstBlock->nextBlock < ((pseudoByte*)currentMemoryBlock))) {
+		int result = munmap(memoryBlock, memoryBlockSize);
+		checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
 
-		// now remove this block with munmap, pay attention to the last one, we have to adjust the
-		// global value there!
+		MEMCHECK_REMOVE_INTERNAL_USE(memoryBlock, memoryBlockSize);
+		__my_malloc_count_mapping(&globalObject->counters, memoryBlockSize, false);
+	}
+}
 
-		// since we have no double pointers, the linked list has to be traversed, and the previous
-		// (if there is one) block has to be found and the next pointer has to be adjusted, it has
-		// to be checked, if the global object (the first list header) is the holder and than adjust
-		// that pointer too, also don't delete the last memory block, so at least one has to remain
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the free bytes of the memory blocks of the GlobalObject, the headers are counted as free,
+ * this walks the memory blocks, not the blocks, the used bytes are counted
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ */
+static uint64_t __my_malloc_free_bytes(GlobalObject* globalObject) {
 
-		if(__my_malloc_globalObject.block == currentMemoryBlock) {
-			if(currentMemoryBlock->next == NULL) {
-				// the last memory block can be deleted
-				__my_malloc_globalObject.block = NULL;
+	uint64_t mappedBytes = 0;
 
-			} else {
-				__my_malloc_globalObject.block = currentMemoryBlock->next; // may be NULL
-			}
+	for(MemoryBlockinformation* memoryBlock = globalObject->block; memoryBlock != NULL;
+	    memoryBlock = memoryBlock->next) {
+		mappedBytes += memoryBlock->size;
+	}
 
-		} else {
+	const uint64_t usedBytes = __my_malloc_counter_get(globalObject->counters.usedBytes);
 
-			// not special case, the block is somewhere in the middle of this single linked list
-			MemoryBlockinformation* previousMemoryBlock = NULL;
+	return usedBytes >= mappedBytes ? 0 : mappedBytes - usedBytes;
+}
 
-			{
-				MemoryBlockinformation* nextMemoryBlock =
-				    (MemoryBlockinformation*)__my_malloc_globalObject.block;
+#endif
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * unmaps the memory block, it has to be removed from the registry before
+ */
+static void __my_malloc_unmap_memory_block(MemoryBlockinformation* memoryBlock) {
+
+	const uint64_t memoryBlockSize = memoryBlock->size;
+
+	int result = munmap(memoryBlock, memoryBlockSize);
+	checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
+
+	MEMCHECK_REMOVE_INTERNAL_USE(memoryBlock, memoryBlockSize);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * gives an empty memory block back, in the thread local case it is put into the global pool, so
+ * that other threads can reuse it, otherwise, or if the pool is full, it is unmapped, in the
+ * global case only after the mutex is unlocked, so that the other threads don't wait for munmap
+ */
+static void __my_malloc_release_memory_block(GlobalObject* globalObject,
+                                             MemoryBlockinformation* memoryBlock) {
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	memoryBlock->next = globalObject->unmapList;
+	globalObject->unmapList = memoryBlock;
+
+	__my_malloc_count_mapping(&globalObject->counters, memoryBlock->size, false);
+#else
+	__my_malloc_registry_update(memoryBlock, NULL);
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	if(__my_malloc_chunk_pool_donate(memoryBlock)) {
+		return;
+	}
+#endif
+
+	const uint64_t memoryBlockSize = memoryBlock->size;
+
+	__my_malloc_unmap_memory_block(memoryBlock);
+	__my_malloc_count_mapping(&globalObject->counters, memoryBlockSize, false);
+#endif
+}
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * unlocks the stripes and the mutex, the memory blocks, that were released in between, are removed
+ * from the registry and unmapped after that, so that the other threads don't wait for these
+ * syscalls
+ */
+static void __my_malloc_unlock(uint64_t lockedStripes) {
+
+	MemoryBlockinformation* unmapList = __my_malloc_globalObject.unmapList;
+	__my_malloc_globalObject.unmapList = NULL;
+
+	__my_malloc_unlock_stripes(lockedStripes);
+
+	int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	while(unmapList != NULL) {
+		MemoryBlockinformation* memoryBlock = unmapList;
+		unmapList = unmapList->next;
+
+		__my_malloc_registry_update(memoryBlock, NULL);
+		__my_malloc_unmap_memory_block(memoryBlock);
+	}
+}
+
+#endif
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION MemoryBlockinformation* get_memory_block_by_number(GlobalObject* globalObject,
+                                                                    block_number_t number) {
+
+	MemoryBlockinformation* nextMemoryBlock =
+	    (MemoryBlockinformation*)globalObject->block; // may be NULL
+
+	while(nextMemoryBlock != NULL) {
+
+		if(nextMemoryBlock->number == number) {
+			return nextMemoryBlock;
+		}
+
+		nextMemoryBlock = nextMemoryBlock->next;
+	};
+
+	return NULL;
+}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the GlobalObject, that owns the memory block of the address in the registry, or NULL, if
+ * no memory block contains it, that is a binary search instead of walking the memory blocks of
+ * every GlobalObject
+ *
+ * @note MT-safe, without any lock, only the owner of the memory blocks of other running threads
+ * changes concurrently, the ones of the calling thread are only adopted by the orphan object, when
+ * it exits, and the orphan object only releases them with the orphan mutex locked
+ *
+ */
+static const GlobalObject* __my_malloc_registry_owner(const void* address) {
+	uint64_t epoch = 0;
+	const RegistryEntry* entry =
+	    __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), address);
+	const GlobalObject* owner = entry == NULL ? NULL : entry->owner;
+	__my_malloc_registry_leave(epoch);
+
+	return owner;
+}
+
+#endif
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION MemoryBlockinformation* get_last_memory_block(GlobalObject* globalObject) {
+
+	MemoryBlockinformation* nextMemoryBlock =
+	    (MemoryBlockinformation*)globalObject->block; // may be NULL
+
+	while(nextMemoryBlock != NULL) {
+
+		if(nextMemoryBlock->next == NULL) {
+			return nextMemoryBlock;
+		}
+
+		nextMemoryBlock = nextMemoryBlock->next;
+	};
+
+	return NULL;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION block_number_t get_next_free_memory_number(GlobalObject* globalObject) {
+
+	block_number_t start = 0;
+
+	while(true) {
+
+		// we need to cover some potential strange pattern:
+		// e.g. 0 1 3 4 5 2 needs to say 6
+		// but 0 1 3 4 5 6 needs to say 2
+		bool needsRestart = false;
+
+		const block_number_t oldStart = start;
+
+		MemoryBlockinformation* nextMemoryBlock =
+		    (MemoryBlockinformation*)globalObject->block;
+
+		while(nextMemoryBlock != NULL) {
+
+			if(nextMemoryBlock->number == start) {
+				start = nextMemoryBlock->number + 1;
+			} else if(nextMemoryBlock->number > start) {
+				needsRestart = true;
+			}
+
+			nextMemoryBlock = nextMemoryBlock->next;
+		};
+
+		// no rerun needed => start is settled, if the rerun didn't change anything, it is settled
+		if(!needsRestart || (needsRestart && start == oldStart)) {
+			break;
+		}
+	}
+
+	return start;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION uint64_t size_of_double_pointer_block(GlobalObject* globalObject,
+                                                         BlockInformation* block) {
+	if(block == NULL) {
+		printSingleErrorAndExit(
+		    "INTERNAL: This is an allocator ERROR, this shouldn't occur: block is NULL\n");
+	} else if(block->nextBlock == NULL) {
+		const MemoryBlockinformation* currentMemoryBlock =
+		    get_memory_block_by_number(globalObject, block->blockNumber);
+		if(currentMemoryBlock == NULL) {
+			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
+			                        "currentMemoryBlock is NULL\n");
+		}
+
+		return (((pseudoByte*)currentMemoryBlock + currentMemoryBlock->size) - (pseudoByte*)block) -
+		       sizeof(BlockInformation);
+	}
+
+	// every memory block has its own list of blocks, so the next block is always in the same one
+	return ((pseudoByte*)block->nextBlock - (pseudoByte*)block) - sizeof(BlockInformation);
+}
+
+/**
+ * @brief INTERNAL FUNCTION; DO NOT USE
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION bool __my_malloc_block_fitsBetter(GlobalObject* globalObject,
+                                                    BlockInformation* toCompare,
+                                                    BlockInformation* currentBlock, uint64_t size) {
+
+	if(toCompare->status != FREE) {
+		return false;
+	}
+
+	if(currentBlock->status != FREE) {
+		return true;
+	}
+
+	const uint64_t blockSize = size_of_double_pointer_block(globalObject, toCompare);
+
+	// if a new block has to be "allocated" then there has to be space for that!
+	if(toCompare->nextBlock == NULL) {
+
+		if(blockSize == size) {
+			return true;
+		}
+
+		if(blockSize < sizeof(BlockInformation) + size) {
+			return false;
+		}
+
+		if(blockSize == sizeof(BlockInformation) + size) {
+			return true;
+		}
+	}
+
+	if(blockSize < size) {
+		return false;
+	}
+
+	if(blockSize == size) {
+		return true;
+	}
+
+	const uint64_t currentSize = size_of_double_pointer_block(globalObject, currentBlock);
+
+	if(currentSize > size + sizeof(BlockInformation)) {
+		if(blockSize <= size + sizeof(BlockInformation)) {
+			return false;
+		}
+	}
+	return (blockSize - size) < (currentSize - size);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the best fit search, a block of exactly the size ends it, with goodEnough also a block, that
+ * wastes at most __my_malloc_goodEnoughPercent of the size, if no block fits, a block, that is too
+ * small or not free, is returned
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_find_best_fit(GlobalObject* globalObject,
+                                                              uint64_t size, bool goodEnough) {
+
+	// size / 100 * percent, without overflowing for big sizes
+	const uint64_t percent = goodEnough ? __my_malloc_goodEnoughPercent : 0;
+	const uint64_t maximumWaste = (size / 100) * percent + (size % 100) * percent / 100;
+
+	BlockInformation* bestFit = get_first_block(globalObject->block);
+
+	// iterate over every block of every memory block
+	MemoryBlockinformation* currentMemoryBlock = globalObject->block;
+	BlockInformation* nextFreeBlock = (BlockInformation*)bestFit->nextBlock;
+
+	while(currentMemoryBlock != NULL) {
+		while(nextFreeBlock != NULL) {
+			if(__my_malloc_block_fitsBetter(globalObject, nextFreeBlock, bestFit, size)) {
+				bestFit = nextFreeBlock;
+				// shorthand evaluation, so if it fits perfectly (or good enough) don't look for a
+				// better one
+				const uint64_t blockSize = size_of_double_pointer_block(globalObject, bestFit);
+				if(blockSize == size ||
+				   (goodEnough && blockSize > size && blockSize - size <= maximumWaste)) {
+					return bestFit;
+				}
+			}
+			nextFreeBlock = nextFreeBlock->nextBlock;
+		}
+
+		currentMemoryBlock = currentMemoryBlock->next;
+		nextFreeBlock = currentMemoryBlock == NULL ? NULL : get_first_block(currentMemoryBlock);
+	}
+
+	return bestFit;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the first free block, that fits, from block up to (without) end, or NULL
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_find_first_fit_between(GlobalObject* globalObject,
+                                                                       BlockInformation* block,
+                                                                       BlockInformation* end,
+                                                                       uint64_t size) {
+
+	for(; block != NULL && block != end; block = (BlockInformation*)block->nextBlock) {
+		if(block->status == FREE && size_of_double_pointer_block(globalObject, block) >= size) {
+			return block;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the first fit search, that starts at start (in its memory block), and wraps around to the first
+ * memory block at the end, so with the first block, that is first fit, and with the rover, that is
+ * next fit, returns NULL, if no block fits
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_find_first_fit(GlobalObject* globalObject,
+                                                               BlockInformation* start,
+                                                               uint64_t size) {
+
+	MemoryBlockinformation* startMemoryBlock =
+	    get_memory_block_by_number(globalObject, start->blockNumber);
+
+	// from start to the end of the last memory block
+	BlockInformation* block = start;
+
+	for(MemoryBlockinformation* currentMemoryBlock = startMemoryBlock; currentMemoryBlock != NULL;
+	    currentMemoryBlock = currentMemoryBlock->next) {
+
+		if(currentMemoryBlock != startMemoryBlock) {
+			block = get_first_block(currentMemoryBlock);
+		}
+
+		BlockInformation* found =
+		    __my_malloc_find_first_fit_between(globalObject, block, NULL, size);
+
+		if(found != NULL) {
+			return found;
+		}
+	}
+
+	// from the first memory block up to start
+	for(MemoryBlockinformation* currentMemoryBlock = globalObject->block;
+	    currentMemoryBlock != NULL; currentMemoryBlock = currentMemoryBlock->next) {
+
+		const bool isStartMemoryBlock = currentMemoryBlock == startMemoryBlock;
+
+		BlockInformation* found = __my_malloc_find_first_fit_between(
+		    globalObject, get_first_block(currentMemoryBlock), isStartMemoryBlock ? start : NULL,
+		    size);
+
+		if(found != NULL || isStartMemoryBlock) {
+			return found;
+		}
+	}
+
+	return NULL;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * marks the block as free and merges it with its free neighbours, returns the free block, that
+ * contains it afterwards
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_merge_block(GlobalObject* globalObject,
+                                                            BlockInformation* currentBlock) {
+
+	currentBlock->status = FREE;
+
+	BlockInformation* nextBlock = (BlockInformation*)currentBlock->nextBlock;
+	BlockInformation* previousBlock = (BlockInformation*)currentBlock->previousBlock;
+
+	bool currentWasRemoved = false;
+
+	// merge with previous free block, if in 5the same memory block!
+	if(previousBlock != NULL && previousBlock->status == FREE &&
+	   previousBlock->blockNumber == currentBlock->blockNumber) {
+
+		// MERGE three free blocks into one: layout Previous | Current | Next => New Free one
+		if(nextBlock != NULL && nextBlock->status == FREE &&
+		   nextBlock->blockNumber == currentBlock->blockNumber) {
+			previousBlock->nextBlock = nextBlock->nextBlock; // Can be NULL
+
+			if(nextBlock->nextBlock != NULL) {
+				((BlockInformation*)nextBlock->nextBlock)->previousBlock = previousBlock;
+			}
+
+			__my_malloc_block_removed(globalObject, nextBlock, previousBlock);
+			// merge previous free block with current one
+		} else {
+
+			previousBlock->nextBlock = nextBlock; // can be NULL
+			if(nextBlock != NULL) {
+				nextBlock->previousBlock = previousBlock;
+			}
+		}
+
+		MEMCHECK_REMOVE_INTERNAL_USE(currentBlock, sizeof(BlockInformation));
+		__my_malloc_block_removed(globalObject, currentBlock, previousBlock);
+		currentWasRemoved = true;
+
+		// merge next free block with current one, if in the same memory block
+	} else if(nextBlock != NULL && nextBlock->status == FREE &&
+	          nextBlock->blockNumber == currentBlock->blockNumber) {
+		currentBlock->nextBlock = nextBlock->nextBlock; // can be NULL
+
+		if(nextBlock->nextBlock != NULL) {
+			((BlockInformation*)nextBlock->nextBlock)->previousBlock = currentBlock;
+		}
+
+		MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
+		__my_malloc_block_removed(globalObject, nextBlock, currentBlock);
+	}
+
+	// the next block can't be the start of the memory block, so it can't contain the current one
+	return currentWasRemoved ? previousBlock : currentBlock;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * releases the memory block of the free block, if that is empty
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION void __my_malloc_release_if_empty(GlobalObject* globalObject,
+                                                    BlockInformation* potentialFirstBlock) {
+
+	// if a new EMPTY memory block was created munmap it!
+
+	// step 1: the potential start block of a memory block is the block, that contains the freed one
+
+	// step 2: test if the potentialFirstBlock is the first block, and it also spans the whole block
+	// (and is free, but that is already assured), since every memory block has its own list, that
+	// is the case, if it has no neighbours
+	if(potentialFirstBlock->previousBlock == NULL && potentialFirstBlock->nextBlock == NULL) {
+
+		// step 3: get the start of the current block
+		MemoryBlockinformation* currentMemoryBlock =
+		    get_memory_block_by_number(globalObject, potentialFirstBlock->blockNumber);
+
+		if(currentMemoryBlock == NULL) {
+			printSingleErrorAndExit("INTERNAL: This is an allocator ERROR, this shouldn't occur: "
+			                        "currentMemoryBlock is NULL\n");
+		}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+		// this is the free memory watermark of a thread: it keeps the empty memory block, as long
+		// as all of its free memory, with this one, isn't more than the watermark, so that
+		// allocating and freeing in a loop doesn't take a memory block from the pool every time,
+		// the orphan object keeps none, since it never allocates
+		if(globalObject != &__my_malloc_orphanObject &&
+		   __my_malloc_free_bytes(globalObject) <=
+		       MY_MALLOC_FREE_WATERMARK_FACTOR * globalObject->defaultMemoryBlockSize) {
+			return;
+		}
+#endif
+
+		// now remove this block with munmap, pay attention to the last one, we have to adjust the
+		// global value there!
+
+		// since we have no double pointers, the linked list has to be traversed, and the previous
+		// (if there is one) block has to be found and the next pointer has to be adjusted, it has
+		// to be checked, if the global object (the first list header) is the holder and than adjust
+		// that pointer too, also don't delete the last memory block, so at least one has to remain
+
+		if(globalObject->block == currentMemoryBlock) {
+			if(currentMemoryBlock->next == NULL) {
+				// the last memory block can be deleted
+				globalObject->block = NULL;
+
+			} else {
+				globalObject->block = currentMemoryBlock->next; // may be NULL
+			}
+
+		} else {
+
+			// not special case, the block is somewhere in the middle of this single linked list
+			MemoryBlockinformation* previousMemoryBlock = NULL;
+
+			{
+				MemoryBlockinformation* nextMemoryBlock =
+				    (MemoryBlockinformation*)globalObject->block;
 
 				while(nextMemoryBlock != NULL) {
 
-					if(nextMemoryBlock->next == currentMemoryBlock) {
-						previousMemoryBlock = nextMemoryBlock;
-						break;
-					}
+					if(nextMemoryBlock->next == currentMemoryBlock) {
+						previousMemoryBlock = nextMemoryBlock;
+						break;
+					}
+
+					nextMemoryBlock = nextMemoryBlock->next;
+				};
+			}
+
+			if(previousMemoryBlock != NULL) {
+				previousMemoryBlock->next = currentMemoryBlock->next; // may be NULL
+			}
+		}
+
+		// the next memory block is smaller again, so a heap, that shrinks, doesn't keep mapping
+		// the biggest size
+		if(globalObject->growthSteps != 0) {
+			globalObject->growthSteps--;
+		}
+
+		__my_malloc_block_removed(globalObject, potentialFirstBlock, NULL);
+		__my_malloc_release_memory_block(globalObject, currentMemoryBlock);
+	}
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * marks the block as free and merges it with its free neighbours, if its memory block is empty
+ * afterwards, it is released
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION void __my_malloc_free_block(GlobalObject* globalObject,
+                                              BlockInformation* currentBlock) {
+	__my_malloc_release_if_empty(globalObject, __my_malloc_merge_block(globalObject, currentBlock));
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * empties the fastbins, every block in there is merged with its neighbours, like in a normal free,
+ * returns false, if they were already empty
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION bool __my_malloc_consolidate(GlobalObject* globalObject) {
+
+	bool consolidated = false;
+
+	for(size_t i = 0; i < MY_MALLOC_FASTBIN_COUNT; ++i) {
+		BlockInformation* block = globalObject->fastbins[i];
+		globalObject->fastbins[i] = NULL;
+
+		while(block != NULL) {
+			// the block may be merged into another one, or its memory block may be released
+			BlockInformation* nextBlock = *__my_malloc_fastbin_next(block);
+
+			block->flags = 0;
+			__my_malloc_free_block(globalObject, block);
+
+			block = nextBlock;
+			consolidated = true;
+		}
+	}
+
+	return consolidated;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns a block of the fastbin of the size, the fastbins hold blocks of exactly that size, that
+ * are still ALLOCED, and not merged, returns NULL, if there is none
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+static inline void* __my_malloc_fastbin_malloc(GlobalObject* globalObject, uint64_t size) {
+	if(size > MY_MALLOC_FASTBIN_MAX_SIZE) {
+		return NULL;
+	}
+
+	BlockInformation* block = __my_malloc_fastbin_pop(__my_malloc_fastbin(globalObject, size));
+
+	if(block == NULL) {
+		return NULL;
+	}
+
+	block->flags = 0;
+	globalObject->rover = block;
+	__my_malloc_count_used(globalObject, size, 1);
+
+	void* returnValue = (pseudoByte*)block + sizeof(BlockInformation);
+	VALGRIND_ALLOC(returnValue, size, 0, false);
+
+	return returnValue;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * merges the region, that was mapped directly after the memory block, into it, the last block of
+ * the memory block grows, if it is free, otherwise a free block is put into the region, at the
+ * offset of a first block, so that it is aligned, the free last block is returned. The region may
+ * already be registered on its own (registered), it is counted as a part of the memory block
+ * afterwards
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation*
+__my_malloc_extend_memory_block(GlobalObject* globalObject, MemoryBlockinformation* memoryBlock,
+                                void* region, uint64_t regionSize, bool registered) {
+
+	// the memory blocks don't know their last block, but this is only done, when mapping
+	BlockInformation* lastBlock = get_first_block(memoryBlock);
+
+	while(lastBlock->nextBlock != NULL) {
+		lastBlock = (BlockInformation*)lastBlock->nextBlock;
+	}
+
+	memoryBlock->size += regionSize;
+
+	// the size of the last block is computed from the end of the memory block, so a free one
+	// already spans the region, a block in a fastbin is still allocated
+	if(lastBlock->status != FREE) {
+		BlockInformation* newBlock =
+		    (BlockInformation*)((pseudoByte*)region + sizeof(MemoryBlockinformation));
+
+		MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+		newBlock->nextBlock = NULL;
+		newBlock->previousBlock = lastBlock;
+		newBlock->status = FREE;
+		newBlock->blockNumber = memoryBlock->number;
+
+		lastBlock->nextBlock = newBlock;
+		lastBlock = newBlock;
+	}
+
+	__my_malloc_registry_merge(memoryBlock, memoryBlock, registered ? region : NULL);
+
+	// the mapping was counted as a memory block of its own
+	__my_malloc_counter_add(globalObject->counters.memoryBlocks, -(uint64_t)1);
+
+	return lastBlock;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * merges the region, that was mapped directly before the memory block, into it, the header of the
+ * memory block moves to the start of the region, and a free first block is put after it, that
+ * absorbs the old first block, if that is free, the free first block is returned. The region may
+ * already be registered on its own (registered), it is counted as a part of the memory block
+ * afterwards
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation*
+__my_malloc_prepend_memory_block(GlobalObject* globalObject, MemoryBlockinformation* memoryBlock,
+                                 void* region, uint64_t regionSize, bool registered) {
+
+	MemoryBlockinformation* newMemoryBlock = (MemoryBlockinformation*)region;
+
+	MEMCHECK_DEFINE_INTERNAL_USE(newMemoryBlock, sizeof(MemoryBlockinformation));
+
+	newMemoryBlock->size = regionSize + memoryBlock->size;
+	newMemoryBlock->next = memoryBlock->next;
+	newMemoryBlock->number = memoryBlock->number;
+
+	if(globalObject->block == memoryBlock) {
+		globalObject->block = newMemoryBlock;
+	} else {
+		MemoryBlockinformation* previousMemoryBlock = globalObject->block;
+
+		while(previousMemoryBlock->next != memoryBlock) {
+			previousMemoryBlock = previousMemoryBlock->next;
+		}
+
+		previousMemoryBlock->next = newMemoryBlock;
+	}
+
+	BlockInformation* oldFirstBlock = get_first_block(memoryBlock);
+	BlockInformation* firstBlock = get_first_block(newMemoryBlock);
+
+	MEMCHECK_DEFINE_INTERNAL_USE(firstBlock, sizeof(BlockInformation));
+
+	firstBlock->previousBlock = NULL;
+	firstBlock->status = FREE;
+	firstBlock->blockNumber = newMemoryBlock->number;
+
+	if(oldFirstBlock->status == FREE) {
+		firstBlock->nextBlock = oldFirstBlock->nextBlock;
+		__my_malloc_block_removed(globalObject, oldFirstBlock, firstBlock);
+	} else {
+		firstBlock->nextBlock = oldFirstBlock;
+	}
+
+	if(firstBlock->nextBlock != NULL) {
+		((BlockInformation*)firstBlock->nextBlock)->previousBlock = firstBlock;
+	}
+
+	// the old header is only part of the free block afterwards, but a free, that read the registry
+	// before, may still read its number, so it is left as it is, until they are done
+	__my_malloc_registry_merge(newMemoryBlock, memoryBlock, registered ? region : NULL);
+
+	if(oldFirstBlock->status == FREE) {
+		MEMCHECK_REMOVE_INTERNAL_USE(oldFirstBlock, sizeof(BlockInformation));
+	}
+	MEMCHECK_REMOVE_INTERNAL_USE(memoryBlock, sizeof(MemoryBlockinformation));
+
+	__my_malloc_counter_add(globalObject->counters.memoryBlocks, -(uint64_t)1);
+
+	return firstBlock;
+}
+
+/**
+ * @brief internal malloc, used by realloc and malloc, but doesn't lock mutexes, that is done by the
+ * parent functions, DO NOT us outside of the internals of this file!
+ */
+INTERNAL_FUNCTION void* __internal__my_malloc(GlobalObject* globalObject, uint64_t size,
+                                              BlockInformation* fixedBlock) {
+
+	// calling my_malloc without initializing the allocator doesn't work, if that is the case,
+	// likely the uninitialized mutex access before this will crash the program, but that is here
+	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
+	if(globalObject->defaultMemoryBlockSize == 0) {
+		fprintf(stderr, "Calling malloc before initializing the allocator is prohibited!\n");
+		exit(1);
+	}
+
+	if(fixedBlock == NULL) {
+		void* returnValue = __my_malloc_fastbin_malloc(globalObject, size);
+
+		if(returnValue != NULL) {
+			return returnValue;
+		}
+	}
+
+	BlockInformation* bestFit = fixedBlock;
+	if(bestFit == NULL && globalObject->block != NULL) {
+
+		switch(__my_malloc_fit) {
+			case MY_MALLOC_FIT_FIRST:
+				bestFit = __my_malloc_find_first_fit(globalObject,
+				                                     get_first_block(globalObject->block), size);
+				break;
+			case MY_MALLOC_FIT_NEXT:
+				bestFit = __my_malloc_find_first_fit(globalObject,
+				                                     globalObject->rover == NULL
+				                                         ? get_first_block(globalObject->block)
+				                                         : globalObject->rover,
+				                                     size);
+				break;
+			case MY_MALLOC_FIT_GOOD_ENOUGH:
+				bestFit = __my_malloc_find_best_fit(globalObject, size, true);
+				break;
+			case MY_MALLOC_FIT_BEST:
+			default:
+				bestFit = __my_malloc_find_best_fit(globalObject, size, false);
+				break;
+		}
+	}
+
+	const uint64_t blockSize = globalObject->block == NULL || bestFit == NULL
+	                               ? 0
+	                               : size_of_double_pointer_block(globalObject, bestFit);
+
+	// if the one that fit the best is not big enough, it means no block is big enough! If it's not
+	// free, than there was no free block
+	if(globalObject->block == NULL || bestFit == NULL || bestFit->status != FREE ||
+	   blockSize < size) {
+
+		// the blocks in the fastbins may be merged into a block, that is big enough
+		if(fixedBlock == NULL && __my_malloc_consolidate(globalObject)) {
+			return __internal__my_malloc(globalObject, size, NULL);
+		}
+
+		//  allocate a new memory block, if the size is bigger than pool size, just request a bigger
+		//  one, we can do that here, try first to get a
+		// continuos block, if that works, increase the size of the current one, otherwise just make
+		// a new MemoryBlockInfo structure.
+
+		MemoryBlockinformation* lastMemoryBlock =
+		    get_last_memory_block(globalObject); // may be NULL
+
+		uint64_t preferredSize = __my_malloc_growth_size(globalObject->defaultMemoryBlockSize,
+		                                                 globalObject->growthSteps);
+
+		// a memory block for a bigger request is only used by that, so it is unmapped, when that
+		// is freed, the others are merged with their neighbours, see below
+		bool mergeable = __my_malloc_mergeMemoryBlocks;
+
+		// the new memory block has to be able to hold the headers and the requested size, otherwise
+		// the recursive call below would map memory blocks forever, round it up to whole pages
+		if(preferredSize < size + sizeof(MemoryBlockinformation) + sizeof(BlockInformation)) {
+			preferredSize = (size + sizeof(MemoryBlockinformation) + sizeof(BlockInformation) +
+			                 (MY_MALLOC_PAGE_SIZE - 1)) &
+			                ~(MY_MALLOC_PAGE_SIZE - 1);
+			mergeable = false;
+		}
+
+		// linux maps new regions below the existing ones, so the region directly before the last
+		// memory block is the one, that is free most likely, it is merged with it, see below
+		void* preferredAddress =
+		    !mergeable || lastMemoryBlock == NULL || (uintptr_t)lastMemoryBlock <= preferredSize ||
+		            lastMemoryBlock->size + preferredSize > __my_malloc_maxMemoryBlockSize
+		        ? NULL
+		        : ((pseudoByte*)lastMemoryBlock) - preferredSize;
+
+		void* newRegion = NULL;
+		bool registered = false;
+		bool pooled = false;
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+		// reuse an empty memory block, that another thread gave back, before mapping a new one
+		newRegion = __my_malloc_chunk_pool_take(globalObject, preferredSize);
+
+		if(newRegion != NULL) {
+			preferredSize = ((MemoryBlockinformation*)newRegion)->size;
+			pooled = true;
+		}
+#elif !defined(_ALLOCATOR_NOT_MT_SAVE)
+		// the memory block, that was mapped and registered without the mutex
+		if(globalObject->reserved != NULL && globalObject->reserved->size >= preferredSize) {
+			newRegion = globalObject->reserved;
+			preferredSize = globalObject->reserved->size;
+			registered = true;
+			globalObject->reserved = NULL;
+		} else if(globalObject->deferMapping) {
+			globalObject->reservedAddress = preferredAddress;
+			globalObject->reservedSize = preferredSize;
+			return NULL;
+		}
+#endif
+
+		if(newRegion == NULL) {
+			newRegion = mmap(preferredAddress, preferredSize, PROT_READ | PROT_WRITE,
+			                 MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+			if(newRegion == MAP_FAILED) {
+				// don't fail, just return NULL ,indicating Out of memory
+				return NULL;
+			}
+
+			__my_malloc_count_mapping(&globalObject->counters, preferredSize, true);
+		}
+
+		MEMCHECK_REMOVE_INTERNAL_USE(newRegion, preferredSize);
+
+		// if the region is directly before or after the last memory block, it becomes a part of
+		// that, so that a free block can span both, up to the maximum size
+		mergeable = mergeable && !pooled && lastMemoryBlock != NULL &&
+		            lastMemoryBlock->size + preferredSize <= __my_malloc_maxMemoryBlockSize;
+
+		if(mergeable && (pseudoByte*)newRegion + preferredSize == (pseudoByte*)lastMemoryBlock) {
+			BlockInformation* firstBlock = __my_malloc_prepend_memory_block(
+			    globalObject, lastMemoryBlock, newRegion, preferredSize, registered);
+
+			return __internal__my_malloc(globalObject, size, firstBlock);
+		}
+
+		if(mergeable &&
+		   (pseudoByte*)newRegion == (pseudoByte*)lastMemoryBlock + lastMemoryBlock->size) {
+			BlockInformation* lastBlock = __my_malloc_extend_memory_block(
+			    globalObject, lastMemoryBlock, newRegion, preferredSize, registered);
+
+			return __internal__my_malloc(globalObject, size, lastBlock);
+		}
+
+		MemoryBlockinformation* newMemoryBlock = (MemoryBlockinformation*)newRegion;
+
+		MEMCHECK_DEFINE_INTERNAL_USE(newMemoryBlock, sizeof(MemoryBlockinformation));
+
+		newMemoryBlock->next = NULL;
+		newMemoryBlock->size = preferredSize;
+
+		block_number_t blockNumber = get_next_free_memory_number(globalObject);
+		newMemoryBlock->number = blockNumber;
+
+		if(lastMemoryBlock == NULL) {
+			globalObject->block = newMemoryBlock;
+		} else {
+			lastMemoryBlock->next = newMemoryBlock;
+		}
+
+		// the next memory block is bigger, until the cap is reached, a merged region doesn't
+		// count, so that every released memory block takes back one step
+		if(__my_malloc_growthPercent != 0 &&
+		   __my_malloc_growth_size(globalObject->defaultMemoryBlockSize,
+		                           globalObject->growthSteps) < __my_malloc_maxMemoryBlockSize) {
+			globalObject->growthSteps++;
+		}
+
+		if(!registered) {
+			__my_malloc_registry_update(newMemoryBlock, globalObject);
+		}
+
+		BlockInformation* newBlock =
+		    (BlockInformation*)((pseudoByte*)newRegion + sizeof(MemoryBlockinformation));
+
+		// no adding the BlockInformation to the memoryBlock
+		MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+		newBlock->nextBlock = NULL;
+		newBlock->previousBlock = NULL;
+		newBlock->status = FREE;
+		newBlock->blockNumber = blockNumber;
+
+		// Now call internal malloc with the new block as hint, to use it, without duplicating code
+		// and searching for it, if we already have it
+
+		return __internal__my_malloc(globalObject, size, newBlock);
+	};
+
+	if(blockSize - size <= (sizeof(BlockInformation))) {
+		// block size and size needed for allocation is the same, only need to set the status to
+		// allocated
+
+		// OR
+
+		// block size and size needed for allocation is nearly the same, but can't allocate a new
+		// block at the end, since it hasn't enough space for another BlockInformation, so only need
+		// to set the status to allocated, but some size is wasted, it can create a gap of 1 or
+		// more, that is fine, but gaps of 0 or less just "waste" that memory -- this handling
+		// implicates, that no position of previous or next block may be calculated by using the
+		// size!!
+
+		bestFit->status = ALLOCED;
+		__my_malloc_count_used(globalObject, blockSize, 1);
+
+	} else {
+		BlockInformation* newBlock =
+		    (BlockInformation*)(((pseudoByte*)bestFit + sizeof(BlockInformation)) + size);
+		MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+		// the new gap is at least 1 byte big, see above!
+
+		newBlock->status = FREE;
+		newBlock->nextBlock = bestFit->nextBlock; // can be NULL
+		newBlock->previousBlock = bestFit;
+		newBlock->blockNumber = bestFit->blockNumber;
+
+		bestFit->status = ALLOCED;
+		bestFit->nextBlock = newBlock;
+		__my_malloc_count_used(globalObject, size, 1);
+
+		if(newBlock->nextBlock != NULL) {
+			((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
+		}
+	}
+
+	bestFit->flags = 0;
+	globalObject->rover = bestFit;
+
+	void* returnValue = (pseudoByte*)bestFit + sizeof(BlockInformation);
+
+	MEMCHECK_DEFINE_INTERNAL_USE(bestFit, sizeof(BlockInformation));
+	VALGRIND_ALLOC(returnValue, size, 0, false);
+
+	return returnValue;
+}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * adds the GlobalObject of the calling thread to the list of threads, if it isn't already in there
+ */
+static void __my_malloc_register_thread(void) {
+
+	if(__my_malloc_globalObject.registered) {
+		return;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	__my_malloc_globalObject.nextThread = __my_malloc_threadList;
+	__my_malloc_threadList = &__my_malloc_globalObject;
+	__my_malloc_globalObject.registered = true;
+
+	result = pthread_mutex_unlock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * removes the GlobalObject from the list of threads and adds its counters to the retired ones
+ */
+static void __my_malloc_unregister_thread(GlobalObject* threadObject) {
+
+	if(!threadObject->registered) {
+		return;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	if(__my_malloc_threadList == threadObject) {
+		__my_malloc_threadList = threadObject->nextThread;
+	} else {
+		for(GlobalObject* currentObject = __my_malloc_threadList; currentObject != NULL;
+		    currentObject = currentObject->nextThread) {
+			if(currentObject->nextThread == threadObject) {
+				currentObject->nextThread = threadObject->nextThread;
+				break;
+			}
+		}
+	}
+
+	__my_malloc_merge_counters(&__my_malloc_retiredCounters, &threadObject->counters);
+	threadObject->counters = (AllocatorCounters){ 0 };
+	threadObject->nextThread = NULL;
+	threadObject->registered = false;
+
+	result = pthread_mutex_unlock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the destructor of the thread key, it is called at the exit of every thread, that initialized
+ * its GlobalObject, empty memory blocks are released, the others are adopted by the orphan object,
+ * so that the still allocated blocks in there can be freed by other threads
+ */
+static void __my_malloc_thread_exit(void* arg) {
+	GlobalObject* threadObject = (GlobalObject*)arg;
+
+	// the blocks in the fastbins are free, so that the memory blocks, that only hold them, are
+	// empty
+	__my_malloc_consolidate(threadObject);
+
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	if(__my_malloc_orphanObject.defaultMemoryBlockSize == 0) {
+		__my_malloc_orphanObject.defaultMemoryBlockSize = threadObject->defaultMemoryBlockSize;
+	}
+
+	MemoryBlockinformation* nextMemoryBlock = threadObject->block;
+	threadObject->block = NULL;
+	threadObject->rover = NULL;
+
+	while(nextMemoryBlock != NULL) {
+
+		MemoryBlockinformation* currentMemoryBlock = nextMemoryBlock;
+		nextMemoryBlock = nextMemoryBlock->next;
+
+		BlockInformation* firstBlock = get_first_block(currentMemoryBlock);
+
+		// the last empty memory block, that the thread kept, or the one, that was forcefully
+		// allocated in my_allocator_init, can be used by other threads
+		if(firstBlock->status == FREE && firstBlock->nextBlock == NULL) {
+			__my_malloc_release_memory_block(threadObject, currentMemoryBlock);
+			continue;
+		}
+
+		// the numbers are only unique in one GlobalObject, so every block has to be renumbered
+		const block_number_t blockNumber = get_next_free_memory_number(&__my_malloc_orphanObject);
+		currentMemoryBlock->number = blockNumber;
+
+		for(BlockInformation* block = firstBlock; block != NULL;
+		    block = (BlockInformation*)block->nextBlock) {
+			block->blockNumber = blockNumber;
+		}
+
+		currentMemoryBlock->next = NULL;
+
+		MemoryBlockinformation* lastMemoryBlock =
+		    get_last_memory_block(&__my_malloc_orphanObject); // may be NULL
+
+		if(lastMemoryBlock == NULL) {
+			__my_malloc_orphanObject.block = currentMemoryBlock;
+		} else {
+			lastMemoryBlock->next = currentMemoryBlock;
+		}
+	}
+
+	// before the orphan mutex is unlocked, so that a block, that is found in the orphan object, is
+	// also checked against it
+	__my_malloc_registry_adopt(threadObject, &__my_malloc_orphanObject);
+
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	__my_malloc_unregister_thread(threadObject);
+
+	// if another destructor allocates again, the object gets initialized again and this is called
+	// again afterwards
+	threadObject->defaultMemoryBlockSize = 0;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * called exactly once, my_allocator_destroy is registered with atexit, since the thread key
+ * destructor isn't called for the thread, that calls exit
+ */
+static void __my_malloc_create_thread_key(void) {
+	int result = pthread_key_create(&__my_malloc_threadKey, __my_malloc_thread_exit);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to create the thread key for the allocator");
+
+	result = atexit(my_allocator_destroy);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to register the atexit function");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * initializes the GlobalObject of the calling thread, if that isn't already done
+ */
+static inline void __my_malloc_initialize_thread(void) {
+
+	if(__my_malloc_globalObject.defaultMemoryBlockSize != 0) {
+		return;
+	}
+
+	const uint64_t defaultMemoryBlockSize =
+	    atomic_load_explicit(&__my_malloc_defaultMemoryBlockSize, memory_order_acquire);
+
+	// my_allocator_init wasn't called by any thread, the internal functions report that error
+	if(defaultMemoryBlockSize == 0) {
+		return;
+	}
+
+	int result = pthread_once(&__my_malloc_threadKeyOnce, __my_malloc_create_thread_key);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to create the thread key for the allocator");
+
+	__my_malloc_globalObject.block = NULL;
+	__my_malloc_globalObject.rover = NULL;
+	__my_malloc_fastbins_reset(&__my_malloc_globalObject);
+	__my_malloc_globalObject.defaultMemoryBlockSize = defaultMemoryBlockSize;
+	__my_malloc_globalObject.growthSteps = 0;
+
+	result = pthread_setspecific(__my_malloc_threadKey, &__my_malloc_globalObject);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to set the thread key for the allocator");
+
+	__my_malloc_register_thread();
+}
+
+#endif
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * samples the allocation for the heap profiler, if that is stopped, this is only one branch
+ *
+ * @note has to be called without the mutex locked, the block belongs to the caller, so no other
+ * operation writes its flags
+ */
+static inline void* __my_malloc_profile_block(void* ptr, uint64_t size) {
+	if(__my_malloc_profile_enabled() && __my_malloc_profile_allocation(ptr, size)) {
+		((BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation)))->flags |= SAMPLED;
+	}
+
+	return ptr;
+}
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * maps the memory block, that the last search reserved, and registers it, with the mutex and the
+ * stripes unlocked, then it is put into reserved, that stays NULL, if mmap failed. Returns the
+ * stripes, that are locked again
+ *
+ * @note Needs to be called with the mutex and the stripes locked, in order to be thread safe!
+ */
+static uint64_t __my_malloc_map_reserved(uint64_t lockedStripes) {
+
+	void* const address = __my_malloc_globalObject.reservedAddress;
+	const uint64_t size = __my_malloc_globalObject.reservedSize;
+	__my_malloc_globalObject.reservedSize = 0;
+
+	__my_malloc_unlock(lockedStripes);
+
+	MemoryBlockinformation* memoryBlock =
+	    mmap(address, size, PROT_READ | PROT_WRITE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+
+	if(memoryBlock != MAP_FAILED) {
+		MEMCHECK_REMOVE_INTERNAL_USE(memoryBlock, size);
+		MEMCHECK_DEFINE_INTERNAL_USE(memoryBlock, sizeof(MemoryBlockinformation));
+
+		// the number is only set, when it is added to the list
+		memoryBlock->size = size;
+		__my_malloc_registry_update(memoryBlock, &__my_malloc_globalObject);
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	if(memoryBlock != MAP_FAILED) {
+		__my_malloc_globalObject.reserved = memoryBlock;
+		__my_malloc_count_mapping(&__my_malloc_globalObject.counters, size, true);
+	}
+
+	return __my_malloc_lock_stripes(&__my_malloc_globalObject);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * __internal__my_malloc, but a new memory block is mapped by __my_malloc_map_reserved, so the
+ * mutex and the stripes may be unlocked in between, the stripes, that are locked again, are put
+ * into lockedStripes
+ *
+ * @note Needs to be called with the mutex and the stripes locked, in order to be thread safe!
+ */
+static void* __my_malloc_malloc_deferred(uint64_t size, uint64_t* lockedStripes) {
+
+	__my_malloc_globalObject.deferMapping = true;
+	void* returnValue = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+	__my_malloc_globalObject.deferMapping = false;
+
+	// the search is repeated with the new memory block, since another thread may have freed a
+	// block, that is big enough, while it was mapped
+	if(returnValue == NULL && __my_malloc_globalObject.reservedSize != 0) {
+		*lockedStripes = __my_malloc_map_reserved(*lockedStripes);
+
+		if(__my_malloc_globalObject.reserved != NULL) {
+			returnValue = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+		}
+
+		if(__my_malloc_globalObject.reserved != NULL) {
+			__my_malloc_release_memory_block(&__my_malloc_globalObject,
+			                                 __my_malloc_globalObject.reserved);
+			__my_malloc_globalObject.reserved = NULL;
+		}
+	}
+
+	return returnValue;
+}
+
+#endif
+
+/**
+ * @note MT-safe - with thread_local storage, this only accesses that, otherwise a mutex is
+ * used, a new memory block is mapped without it, if this is called without initializing the
+ * underlying allocator beforehand, it is undefined behaviour, however this function crashes the
+ * program in that case
+ */
+void* my_malloc(uint64_t size) {
+
+	const uint64_t requestedSize = size;
+
+	size = __my_malloc_aligned_size(size);
+
+	// the size would overflow, so this is out of memory
+	if(size == 0) {
+		return NULL;
+	}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	__my_malloc_initialize_thread();
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+
+	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
+		fprintf(stderr, "Calling malloc before initializing the allocator is prohibited!\n");
+		exit(1);
+	}
+
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	// a block of a fastbin isn't in a free list, so only the mutex is needed for it, the search
+	// reads every memory block
+	void* returnValue = __my_malloc_fastbin_malloc(&__my_malloc_globalObject, size);
+	uint64_t lockedStripes = 0;
+
+	if(returnValue == NULL) {
+		lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
+		returnValue = __my_malloc_malloc_deferred(size, &lockedStripes);
+	}
+
+	__my_malloc_unlock(lockedStripes);
+#else
+	void* returnValue = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+#endif
+
+	__my_malloc_trace(TRACE_MALLOC, returnValue, 0, requestedSize);
+
+	return __my_malloc_profile_block(returnValue, size);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * frees the checked block of ptr, small blocks are put into a fastbin, then NULL is returned,
+ * otherwise the block is merged with its neighbours and the free block, that contains it, is
+ * returned, its memory block may be empty then, this doesn't release it
+ *
+ * @note Needs to be called with the mutex or the stripe of the block locked, in order to be thread
+ * safe!
+ *
+ */
+INTERNAL_FUNCTION BlockInformation* __my_malloc_free_checked(GlobalObject* globalObject, void* ptr,
+                                                             BlockInformation* currentBlock) {
+
+	if(currentBlock->status == FREE || (currentBlock->flags & IN_FASTBIN) != 0) {
+		printErrorAndExit("ERROR: You tried to free a already freed Block: %p\n", ptr);
+	}
+
+	if((currentBlock->flags & SAMPLED) != 0) {
+		__my_malloc_profile_free(ptr);
+		currentBlock->flags &= ~SAMPLED;
+	}
+
+	VALGRIND_FREE(ptr, 0);
+
+	const uint64_t blockSize = __my_malloc_registered_block_size(currentBlock);
+	__my_malloc_count_freed(globalObject, currentBlock, blockSize);
+
+	// only blocks, that aren't the last one of their memory block, the orphan object never
+	// allocates, so it wouldn't reuse them
+	if(currentBlock->nextBlock != NULL
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	   && globalObject != &__my_malloc_orphanObject
+#endif
+	) {
+		if(blockSize <= MY_MALLOC_FASTBIN_MAX_SIZE) {
+			MEMCHECK_DEFINE_INTERNAL_USE(ptr, sizeof(BlockInformation*));
+
+			currentBlock->flags |= IN_FASTBIN;
+			__my_malloc_fastbin_push(__my_malloc_fastbin(globalObject, blockSize), currentBlock);
+			return NULL;
+		}
+	}
+
+	return __my_malloc_merge_block(globalObject, currentBlock);
+}
+
+/**
+ * @brief internal free, used by realloc and free, but doesn't lock mutexes, that is done by the
+ * parent functions, DO NOT us outside of the internals of this file!
+ */
+INTERNAL_FUNCTION void __internal__my_free(GlobalObject* globalObject, void* ptr) {
+
+	// calling my_free without initializing the allocator doesn't work, if that is the case,
+	// likely the uninitialized mutex access before this will crash the program, but that is here
+	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
+	if(globalObject->defaultMemoryBlockSize == 0) {
+		fprintf(stderr, "Calling free before initializing the allocator is prohibited!\n");
+		exit(1);
+	}
+
+	if(globalObject->block == NULL) {
+		// no block is not free, since we have no block anymore xD
+		printErrorAndExit("ERROR: You tried to free a already freed Block: %p\n", ptr);
+	}
+
+	BlockInformation* mergedBlock = __my_malloc_free_checked(
+	    globalObject, ptr, __my_malloc_checked_block(globalObject, ptr, "free"));
+
+	if(mergedBlock != NULL) {
+		__my_malloc_release_if_empty(globalObject, mergedBlock);
+	}
+}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * frees the pointer, that has to be in a memory block of the orphan object, that
+ * __my_malloc_registry_owner returned
+ */
+static void __my_malloc_free_orphan(void* ptr) {
+
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	// the owner is checked again in __my_malloc_checked_block, another thread may have released the
+	// memory block in between, by freeing the same pointer
+	__internal__my_free(&__my_malloc_orphanObject, ptr);
+
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the size of the block, that has to be in a memory block of the orphan object, that
+ * __my_malloc_registry_owner returned, a freed block crashes the program with an error
+ */
+static uint64_t __my_malloc_orphan_block_size(void* ptr, const char* operation) {
+
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	BlockInformation* currentBlock =
+	    __my_malloc_checked_block(&__my_malloc_orphanObject, ptr, operation);
+
+	if(currentBlock->status == FREE) {
+		printErrorAndExit("ERROR: You tried to %s a freed Block: %p\n", operation, ptr);
+	}
+
+	const uint64_t blockSize = __my_malloc_registered_block_size(currentBlock);
+
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	return blockSize;
+}
+
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+
+// the background thread, see my_allocator_options, free only signals it, if it emptied a memory
+// block, the thread releases it then, and it merges the small freed blocks, every interval
+static pthread_t __my_malloc_maintenanceThread;
+static _Atomic bool __my_malloc_maintenanceRunning = false;
+static _Atomic bool __my_malloc_maintenancePending = false;
+static uint32_t __my_malloc_maintenanceInterval = 0;
+static bool __my_malloc_maintenanceStop = false;
+static pthread_mutex_t __my_malloc_maintenanceMutex = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t __my_malloc_maintenanceCondition = PTHREAD_COND_INITIALIZER;
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * wakes the background thread up, if it wasn't already, this is called without any mutex locked
+ */
+static void __my_malloc_maintenance_signal(void) {
+
+	if(atomic_exchange(&__my_malloc_maintenancePending, true)) {
+		return;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	result = pthread_cond_signal(&__my_malloc_maintenanceCondition);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to signal the "
+	                                 "condition in the internal allocator");
+
+	result = pthread_mutex_unlock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * frees the pointer with only the stripe of its memory block locked, if its memory block is empty
+ * afterwards, the mutex is locked, to release it, or the background thread is signalled to do
+ * that, if it runs. Returns false, if the pointer isn't in a memory block, then
+ * __internal__my_free reports that
+ */
+static bool __my_malloc_free_striped(void* ptr) {
+
+	uint64_t epoch = 0;
+	const RegistryEntry* entry = __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr);
+
+	// a memory block is only unmapped, after the readers of the registry, that contains it, are
+	// done, so its number can be read in here
+	MemoryBlockinformation* memoryBlock =
+	    entry == NULL ? NULL : (MemoryBlockinformation*)entry->start;
+	const block_number_t number = memoryBlock == NULL ? 0 : memoryBlock->number;
+
+	__my_malloc_registry_leave(epoch);
+
+	if(memoryBlock == NULL) {
+		return false;
+	}
+
+	int result = pthread_mutex_lock(__my_malloc_stripe(number));
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	BlockInformation* mergedBlock = __my_malloc_free_checked(
+	    &__my_malloc_globalObject, ptr,
+	    __my_malloc_checked_block(&__my_malloc_globalObject, ptr, "free"));
+
+	const bool empty = mergedBlock != NULL && mergedBlock->previousBlock == NULL &&
+	                   mergedBlock->nextBlock == NULL;
+
+	result = pthread_mutex_unlock(__my_malloc_stripe(number));
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	if(!empty) {
+		return true;
+	}
+
+	// the background thread releases it, so that this free stays cheap
+	if(atomic_load(&__my_malloc_maintenanceRunning)) {
+		__my_malloc_maintenance_signal();
+		return true;
+	}
+
+	result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	// a region may have been merged in front of the memory block in between, that moved its header,
+	// so it is looked up again, the entries of the memory blocks in the list only change, while the
+	// mutex is locked
+	entry = __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr);
+	memoryBlock = entry == NULL ? NULL : (MemoryBlockinformation*)entry->start;
+	__my_malloc_registry_leave(epoch);
+
+	// another thread may have allocated in it or released it in between, then it is still in the
+	// registry, until it is unmapped, a reserved one isn't in the list yet
+	bool inList = false;
+
+	for(MemoryBlockinformation* nextMemoryBlock = __my_malloc_globalObject.block;
+	    memoryBlock != NULL && nextMemoryBlock != NULL; nextMemoryBlock = nextMemoryBlock->next) {
+		if(nextMemoryBlock == memoryBlock) {
+			inList = true;
+			break;
+		}
+	}
+
+	if(inList) {
+		// the memory block may have been released and mapped again, with another number
+		pthread_mutex_t* stripe = __my_malloc_stripe(memoryBlock->number);
+
+		result = pthread_mutex_lock(stripe);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+		BlockInformation* firstBlock = get_first_block(memoryBlock);
+
+		if(firstBlock->status == FREE) {
+			__my_malloc_release_if_empty(&__my_malloc_globalObject, firstBlock);
+		}
+
+		result = pthread_mutex_unlock(stripe);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+	}
+
+	__my_malloc_unlock(0);
+
+	return true;
+}
+
+#endif
+
+/**
+ * @brief frees a pointer, a NULL pointer is ignored and a safe noop,
+ * if the pointer is not allocated with my_malloc, this call is undefined behaviour. It likely will
+ * crash or create a blockInformation structure, that will crash in later stages, since it tries to
+ * interpret some random garbage memory as block-structure, so be aware of that!
+ * DOUBLE Frees crash the program, so remember to always set freed pointer sto NULL :)
+ *
+ * @note MT-safe, using the stripe of the memory block of the pointer, or the thread local storage,
+ * the mutex is only locked, if the memory block is empty afterwards, the same principles as in
+ * my_malloc apply, so calling this with an uninitialized allocator is undefined behaviour and
+ * crashes the program. With thread local storage, blocks of exited threads can be freed by any
+ * thread, but blocks of other running threads can't, that crashes the program with an error
+ *
+ */
+void my_free(void* ptr) {
+
+	// so that if you pass a wrong argument just nothing happens!
+	if(ptr == NULL) {
+		return;
+	}
+
+	// recorded before the block is freed, so that an allocation of another thread, that reuses it,
+	// is always after this in the trace
+	__my_malloc_trace(TRACE_FREE, ptr, 0, 0);
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	// blocks of exited threads can be freed by every thread
+	if(__my_malloc_registry_owner(ptr) == &__my_malloc_orphanObject) {
+		__my_malloc_free_orphan(ptr);
+		return;
+	}
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	if(__my_malloc_free_striped(ptr)) {
+		return;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+#endif
+
+	__internal__my_free(&__my_malloc_globalObject, ptr);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	__my_malloc_unlock(0);
+#endif
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the implementation of my_realloc, without the heap profiler
+ */
+static void* __my_malloc_realloc(void* ptr, uint64_t size) {
+
+	// if size == 0, it is the same as my_free(size);
+	if(size == 0) {
+		my_free(ptr);
+		return NULL;
+	}
+
+	size = __my_malloc_aligned_size(size);
+
+	// the size would overflow, so this is out of memory, the old block stays untouched
+	if(size == 0) {
+		return NULL;
+	}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	__my_malloc_initialize_thread();
+
+	// blocks of exited threads are never resized in place, they are moved into this thread
+	if(__my_malloc_registry_owner(ptr) == &__my_malloc_orphanObject) {
+		const uint64_t orphanBlockSize = __my_malloc_orphan_block_size(ptr, "realloc");
+
+		void* newRegion = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+
+		if(newRegion == NULL) {
+			return NULL;
+		}
+
+		memcpy(newRegion, ptr, size < orphanBlockSize ? size : orphanBlockSize);
+		__my_malloc_free_orphan(ptr);
+
+		return newRegion;
+	}
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+
+	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
+		fprintf(stderr, "Calling realloc before initializing the allocator is prohibited!\n");
+		exit(1);
+	}
+
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
+#endif
+
+	// calling my_malloc without initializing the allocator doesn't work, if that is the case,
+	// likely the uninitialized mutex access before this will crash the program, but that is here
+	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
+	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
+		fprintf(stderr, "Calling realloc before initializing the allocator is prohibited!\n");
+		exit(1);
+	}
+
+	if(__my_malloc_globalObject.block == NULL) {
+		// no block is not free, since we have no block anymore xD
+		printErrorAndExit("ERROR: You tried to realloc a freed Block: %p\n", ptr);
+	}
+
+	BlockInformation* currentBlock =
+	    __my_malloc_checked_block(&__my_malloc_globalObject, ptr, "realloc");
+
+	if(currentBlock->status == FREE || (currentBlock->flags & IN_FASTBIN) != 0) {
+		printErrorAndExit("ERROR: You tried to realloc a freed Block: %p\n", ptr);
+	}
+
+	// the sample of the old block is removed, the caller samples the resized one again
+	if((currentBlock->flags & SAMPLED) != 0) {
+		__my_malloc_profile_free(ptr);
+		currentBlock->flags &= ~SAMPLED;
+	}
+
+	// ATTENTION: this size isn't always the correct size, of the previous alloc! since some amount
+	// of dread space can be at the end, it can be between 0 and sizeof(BlockInformation) bytes,
+	// since there's no room for a new block in there. So every calculation here has to pay
+	// attention to that
+
+	// It is fine, to copy the undefined memory, since it's  at the end, where the new memory would
+	// be undefined nevertheless
+	const uint64_t blockSize =
+	    size_of_double_pointer_block(&__my_malloc_globalObject, currentBlock);
+
+	// CASE 1: the new size is smaller or the same (it may be also the same, if the blockSize is
+	// slightly bigger, since there might be end padding!)
+	if(size <= blockSize) {
+
+		// CASE 1.1: no new block can be placed after the new size, so just returning the old size
+		// and doing some valgrind house keeping
+		if(blockSize - size <= sizeof(BlockInformation)) {
+
+			VALGRIND_FREE(ptr, 0);
+			VALGRIND_ALLOC(ptr, size, 0, false);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+			__my_malloc_unlock(lockedStripes);
+#endif
+			// just return the old pointer
+			return ptr;
+
+		} else {
+
+			// CASE 1.2: make a new block, that is free, and is at the end of size
+
+			// If applicable we search a better block, that is better suited for that cause, that
+			// is computational intensive, but it may create less holes in the end also pay
+			// attention to padding, so it has to be at least sizeof(BlockInformation) smaller, to
+			// allocate a new block!
+
+			// CASE 1.2.1: the new areas is significantly smaller than the last one, so using free +
+			// malloc to get a better spot for the significantly smaller size, use 50% as threshold,
+			// so that if it's 50% smaller, use malloc to get a new block
+			// small NOTE: since we don't free this block before issuing a malloc, this block might
+			// be suited better, but we have to use another xD, it might even return NULL, so it'S
+			// out of memory xD
+			if(size * 2 < blockSize) {
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+				// the block is only moved into a free one, a new memory block isn't worth
+				// mapping, since it can just be split
+				__my_malloc_globalObject.deferMapping = true;
+#endif
+
+				void* newRegion = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+				__my_malloc_globalObject.deferMapping = false;
+				__my_malloc_globalObject.reservedSize = 0;
+#endif
+
+				// out of memory, so just use the current nevertheless xD
+				// ATTENTION: code duplication, since no good pattern emerges, to reuse code via
+				// call or control flow :(
+				if(newRegion == NULL) {
+
+					VALGRIND_FREE(ptr, 0);
+
+					BlockInformation* newBlock =
+					    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
+					                        size);
+					MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+					newBlock->nextBlock = currentBlock->nextBlock; // may be NULL
+					newBlock->previousBlock = currentBlock;
+					newBlock->status = FREE;
+					newBlock->blockNumber = currentBlock->blockNumber;
+
+					currentBlock->nextBlock = newBlock;
+					if(newBlock->nextBlock != NULL) {
+						((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
+					}
+
+					__my_malloc_count_used(&__my_malloc_globalObject, size - blockSize, 0);
+					VALGRIND_ALLOC(ptr, size, 0, false);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+					__my_malloc_unlock(lockedStripes);
+#endif
+					// just return the old pointer
+					return ptr;
+				}
+
+				// copy the subset of data into the new region
+				void* dest = memcpy(newRegion, ptr, size);
+
+				if(dest != newRegion) {
+					fprintf(stderr,
+					        "Error during memcpy, dest pointer is not the same as the given dest "
+					        "pointer: "
+					        "%p != %p\n",
+					        newRegion, dest);
+					exit(1);
+				}
+
+				// free the previous section
+				__internal__my_free(&__my_malloc_globalObject, ptr);
 
-					nextMemoryBlock = nextMemoryBlock->next;
-				};
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+				__my_malloc_unlock(lockedStripes);
+#endif
+				// return the new region
+				return newRegion;
+
+			} else {
+
+				// CASE 1.2.2: just divide the block and use the current One
+
+				VALGRIND_FREE(ptr, 0);
+
+				BlockInformation* newBlock =
+				    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
+				                        size);
+				MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+				newBlock->nextBlock = currentBlock->nextBlock; // may be NULL
+				newBlock->previousBlock = currentBlock;
+				newBlock->status = FREE;
+				newBlock->blockNumber = currentBlock->blockNumber;
+
+				currentBlock->nextBlock = newBlock;
+				if(newBlock->nextBlock != NULL) {
+					((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
+				}
+
+				__my_malloc_count_used(&__my_malloc_globalObject, size - blockSize, 0);
+				VALGRIND_ALLOC(ptr, size, 0, false);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+				__my_malloc_unlock(lockedStripes);
+#endif
+				// just return the old pointer
+				return ptr;
 			}
+		}
 
-			if(previousMemoryBlock != NULL) {
-				previousMemoryBlock->next = currentMemoryBlock->next; // may be NULL
+	} else {
+		// CASE 2: the size is bigger
+
+		// it is enough to look forward one block, since there is per guarantee no block that is
+		// also free, after a free block
+
+		BlockInformation* nextBlock = (BlockInformation*)currentBlock->nextBlock; // may be NULL
+
+		// Case 2.1: the current block with the next block can fit the new size! (only if they are
+		// in the same memory block, otherwise they aren't contiguous)
+		if(nextBlock != NULL && nextBlock->status == FREE &&
+		   nextBlock->blockNumber == currentBlock->blockNumber) {
+			const uint64_t nextBlockSize =
+			    size_of_double_pointer_block(&__my_malloc_globalObject, nextBlock);
+
+			const uint64_t totalPotentialSize =
+			    nextBlockSize + sizeof(BlockInformation) + blockSize;
+
+			if(totalPotentialSize >= size) {
+
+				// figure out, if theres space for another block inside the new larger area!
+
+				// CASE 2.1.1: no new block can be placed inside the new larger area, just deleting
+				// the old in the middle (nextBlock)
+				if(totalPotentialSize - size <= (sizeof(BlockInformation))) {
+
+					currentBlock->nextBlock = nextBlock->nextBlock; // can be NULL
+					if(nextBlock->nextBlock != NULL) {
+						((BlockInformation*)nextBlock->nextBlock)->previousBlock = currentBlock;
+					}
+
+					MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
+					__my_malloc_block_removed(&__my_malloc_globalObject, nextBlock, currentBlock);
+					__my_malloc_count_used(&__my_malloc_globalObject,
+					                       totalPotentialSize - blockSize, 0);
+					VALGRIND_ALIGN_ALLOC_TO_GREATER_BLOCK(ptr, size);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+					__my_malloc_unlock(lockedStripes);
+#endif
+					// just return the old pointer, it has now space for the size
+					return ptr;
+
+				} else {
+
+					// CASE 2.1.2: delete the current one and create a new one at the end, that is
+					// free
+
+					BlockInformation* newBlock =
+					    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
+					                        size);
+					MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+
+					newBlock->previousBlock = currentBlock;
+					newBlock->nextBlock = nextBlock->nextBlock; // can be NULL
+					newBlock->status = FREE;
+					newBlock->blockNumber = currentBlock->blockNumber;
+
+					currentBlock->nextBlock = newBlock;
+
+					if(nextBlock->nextBlock != NULL) {
+						((BlockInformation*)nextBlock->nextBlock)->previousBlock = newBlock;
+					}
+
+					MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
+					__my_malloc_block_removed(&__my_malloc_globalObject, nextBlock, currentBlock);
+					__my_malloc_count_used(&__my_malloc_globalObject, size - blockSize, 0);
+					VALGRIND_ALIGN_ALLOC_TO_GREATER_BLOCK(ptr, size);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+					__my_malloc_unlock(lockedStripes);
+#endif
+					// just return the old pointer, it has now space for the size
+					return ptr;
+				}
 			}
 		}
 
-		//  remove the current FREE block, that is in this to be deleted memory block
-		if(potentialFirstBlock->nextBlock != NULL) {
-			((BlockInformation*)potentialFirstBlock->nextBlock)->previousBlock =
-			    potentialFirstBlock->previousBlock; // may be NULL
-		}
+		// CASE 2.2 we need to issue a new malloc and copy the data over, a new memory block is
+		// mapped without the locks, the block of ptr is still allocated, so it doesn't change in
+		// between
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+		void* newRegion = __my_malloc_malloc_deferred(size, &lockedStripes);
+#else
+		void* newRegion = __internal__my_malloc(&__my_malloc_globalObject, size, NULL);
+#endif
+
+		if(newRegion == NULL) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+			__my_malloc_unlock(lockedStripes);
+#endif
+
+			return NULL;
+		}
+
+		// copy the data into the new region, the blockSize is not 100%% accurate, but as said
+		// above, the rest is undefined memory, as the rest of the newRegion region
+		void* dest = memcpy(newRegion, ptr, blockSize);
+
+		if(dest != newRegion) {
+			fprintf(stderr,
+			        "Error during memcpy, dest pointer is not the same as the given dest pointer: "
+			        "%p != %p\n",
+			        newRegion, dest);
+			exit(1);
+		}
+
+		// free the previous section
+		__internal__my_free(&__my_malloc_globalObject, ptr);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+		__my_malloc_unlock(lockedStripes);
+#endif
+		// return the new region
+		return newRegion;
+	}
+}
+
+/**
+ * @brief If ptr is NULL, this behaves as my_malloc
+ * If size == 0 it behaves as my_free and returns NULL
+ *
+ * Otherwise it reallocates the memory, it may have a different address than before, but the return
+ * value may also be the same as ptr. If the new size is greater than the previous size, the whole
+ * content of the previous ptr is preserves and copied to the new ptr, if needed, the rest of the
+ * data is undefined. If the new size is smaller, the data beyond that is potentially overwritten,
+ * at least it's not accessible anymore, the returned ptr can be the same, but doesn't have to be
+ * the same, since realloc may chose a better suited block for it, if that'S the case, the data up
+ * to the new size is the same as the old one
+ */
+void* my_realloc(void* ptr, uint64_t size) {
+
+	// if ptr == NULL, it is the same as my_malloc(size);
+	if(ptr == NULL) {
+		return my_malloc(size);
+	}
+
+	// my_free records it
+	if(size == 0) {
+		my_free(ptr);
+		return NULL;
+	}
+
+	// recorded before the old block is freed, like in my_free, so that an allocation of another
+	// thread, that reuses it, is always after this in the trace, the new block is recorded, after
+	// it was allocated, like in my_malloc
+	__my_malloc_trace(TRACE_REALLOC_OLD, ptr, 0, 0);
+
+	// the resized block is sampled like a new allocation
+	void* newRegion = __my_malloc_realloc(ptr, size);
+
+	__my_malloc_trace(TRACE_REALLOC, newRegion, (uint64_t)ptr, size);
+
+	if(newRegion == NULL) {
+		return NULL;
+	}
+
+	return __my_malloc_profile_block(newRegion, size);
+}
+
+/**
+ * @brief allocates size bytes, so that the returned pointer is a multiple of alignment. The
+ * alignment has to be a power of two, otherwise NULL is returned and errno is set to EINVAL. The
+ * returned pointer can be used with my_free and my_realloc, like every pointer from my_malloc
+ *
+ * @note MT-safe, the same principles as in my_malloc apply
+ */
+void* my_memalign(uint64_t alignment, uint64_t size) {
+
+	if(alignment == 0 || (alignment & (alignment - 1)) != 0) {
+		errno = EINVAL;
+		return NULL;
+	}
+
+	// every block is already aligned to that, so nothing special has to be done
+	if(alignment <= MY_MALLOC_ALIGNMENT) {
+		return my_malloc(size);
+	}
+
+	const uint64_t requestedSize = size;
+
+	size = __my_malloc_aligned_size(size);
+
+	// the gap in front of the aligned block is either 0 or has to fit a free block
+	const uint64_t minimumGapSize = sizeof(BlockInformation) + MY_MALLOC_ALIGNMENT;
+
+	if(size == 0 || size > UINT64_MAX - (4 * alignment) - minimumGapSize) {
+		return NULL;
+	}
+
+	// this is enough, so that an aligned address with a big enough gap is in there
+	const uint64_t requestSize = __my_malloc_aligned_size(size + alignment + minimumGapSize);
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	__my_malloc_initialize_thread();
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
+
+	void* rawRegion = __my_malloc_malloc_deferred(requestSize, &lockedStripes);
+#else
+	void* rawRegion = __internal__my_malloc(&__my_malloc_globalObject, requestSize, NULL);
+#endif
+
+	if(rawRegion == NULL) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+		__my_malloc_unlock(lockedStripes);
+#endif
+		return NULL;
+	}
+
+	VALGRIND_FREE(rawRegion, 0);
+
+	BlockInformation* rawBlock =
+	    (BlockInformation*)((pseudoByte*)rawRegion - sizeof(BlockInformation));
+	// it was counted as used with this size, the aligned block replaces it
+	const uint64_t rawBlockSize = __my_malloc_registered_block_size(rawBlock);
+
+	pseudoByte* alignedRegion =
+	    (pseudoByte*)(((uintptr_t)rawRegion + (alignment - 1)) & ~(uintptr_t)(alignment - 1));
+
+	if(alignedRegion != (pseudoByte*)rawRegion &&
+	   (uint64_t)(alignedRegion - (pseudoByte*)rawRegion) < minimumGapSize) {
+		alignedRegion += alignment;
+	}
+
+	BlockInformation* alignedBlock = rawBlock;
+
+	if(alignedRegion != (pseudoByte*)rawRegion) {
+		// the gap in front of the aligned block becomes a free block, the raw block header is
+		// reused for that
+		alignedBlock = (BlockInformation*)(alignedRegion - sizeof(BlockInformation));
+		MEMCHECK_DEFINE_INTERNAL_USE(alignedBlock, sizeof(BlockInformation));
+
+		alignedBlock->status = ALLOCED;
+		alignedBlock->flags = 0;
+		alignedBlock->blockNumber = rawBlock->blockNumber;
+		alignedBlock->nextBlock = rawBlock->nextBlock; // can be NULL
+		alignedBlock->previousBlock = rawBlock;
+
+		if(alignedBlock->nextBlock != NULL) {
+			((BlockInformation*)alignedBlock->nextBlock)->previousBlock = alignedBlock;
+		}
+
+		rawBlock->nextBlock = alignedBlock;
+		rawBlock->status = FREE;
+
+		// no two free blocks may be next to each other, so merge the gap with the previous block
+		BlockInformation* previousBlock = (BlockInformation*)rawBlock->previousBlock;
+
+		if(previousBlock != NULL && previousBlock->status == FREE &&
+		   previousBlock->blockNumber == rawBlock->blockNumber) {
+			previousBlock->nextBlock = alignedBlock;
+			alignedBlock->previousBlock = previousBlock;
+
+			MEMCHECK_REMOVE_INTERNAL_USE(rawBlock, sizeof(BlockInformation));
+			__my_malloc_block_removed(&__my_malloc_globalObject, rawBlock, previousBlock);
+		}
+	}
+
+	// give the unused rest at the end back, if a block fits in there
+	const uint64_t alignedBlockSize =
+	    size_of_double_pointer_block(&__my_malloc_globalObject, alignedBlock);
+
+	if(alignedBlockSize - size > sizeof(BlockInformation)) {
+		BlockInformation* restBlock = (BlockInformation*)(alignedRegion + size);
+		MEMCHECK_DEFINE_INTERNAL_USE(restBlock, sizeof(BlockInformation));
+
+		restBlock->status = FREE;
+		restBlock->blockNumber = alignedBlock->blockNumber;
+		restBlock->previousBlock = alignedBlock;
+		restBlock->nextBlock = alignedBlock->nextBlock; // can be NULL
+
+		BlockInformation* nextBlock = (BlockInformation*)alignedBlock->nextBlock;
+
+		// the same as above, merge it with the next one, if that is free
+		if(nextBlock != NULL && nextBlock->status == FREE &&
+		   nextBlock->blockNumber == restBlock->blockNumber) {
+			restBlock->nextBlock = nextBlock->nextBlock; // can be NULL
+			MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
+			__my_malloc_block_removed(&__my_malloc_globalObject, nextBlock, restBlock);
+		}
+
+		if(restBlock->nextBlock != NULL) {
+			((BlockInformation*)restBlock->nextBlock)->previousBlock = restBlock;
+		}
+
+		alignedBlock->nextBlock = restBlock;
+	}
+
+	__my_malloc_count_used(&__my_malloc_globalObject,
+	                       __my_malloc_registered_block_size(alignedBlock) - rawBlockSize, 0);
+
+	VALGRIND_ALLOC(alignedRegion, size, 0, false);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	__my_malloc_unlock(lockedStripes);
+#endif
+
+	__my_malloc_trace(TRACE_MEMALIGN, alignedRegion, alignment, requestedSize);
+
+	return __my_malloc_profile_block(alignedRegion, size);
+}
+
+/**
+ * @brief returns the number of bytes, that can be used in the block of ptr, this is at least the
+ * size, that was requested, but may be a bit more, since blocks are aligned and small rests are not
+ * split of. A NULL pointer returns 0
+ *
+ * @note MT-safe, only the stripe of the memory block of ptr is locked, like in my_free, or the
+ * thread local storage is used, the same principles as in my_malloc apply
+ */
+uint64_t my_malloc_usable_size(void* ptr) {
+
+	if(ptr == NULL) {
+		return 0;
+	}
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	const GlobalObject* owner = __my_malloc_registry_owner(ptr);
+
+	if(owner == &__my_malloc_orphanObject) {
+		return __my_malloc_orphan_block_size(ptr, "get the size of");
+	}
+
+	// the block of another running thread, or a foreign pointer
+	if(owner != &__my_malloc_globalObject) {
+		return 0;
+	}
+#endif
 
-		if(potentialFirstBlock->previousBlock != NULL) {
-			((BlockInformation*)potentialFirstBlock->previousBlock)->nextBlock =
-			    potentialFirstBlock->nextBlock; // may be NULL
-		}
+	BlockInformation* currentBlock =
+	    (BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation));
 
-		const uint64_t currentMemoryBlockSize = currentMemoryBlock->size;
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	// only the stripe of the memory block is locked, like in __my_malloc_free_striped, the
+	// neighbours of the block and the end of its memory block only change with it locked
+	uint64_t epoch = 0;
+	const RegistryEntry* entry = __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr);
+	const block_number_t number =
+	    entry == NULL ? 0 : ((MemoryBlockinformation*)entry->start)->number;
+	__my_malloc_registry_leave(epoch);
+
+	if(entry == NULL) {
+		return 0;
+	}
 
-		int result = munmap(currentMemoryBlock, currentMemoryBlockSize);
-		checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
+	int result = pthread_mutex_lock(__my_malloc_stripe(number));
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 
-		MEMCHECK_REMOVE_INTERNAL_USE(currentMemoryBlock, currentMemoryBlockSize);
+	uint64_t blockSize = 0;
+
+	if(currentBlock->nextBlock != NULL) {
+		blockSize = size_of_double_pointer_block(&__my_malloc_globalObject, currentBlock);
+	} else {
+		// the size of the last block is computed from the end of the memory block, that is looked
+		// up in the registry, since the list of the memory blocks needs the mutex
+		entry = __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr);
+		blockSize = entry == NULL ? 0 : (entry->end - (uintptr_t)ptr);
+		__my_malloc_registry_leave(epoch);
 	}
+
+	result = pthread_mutex_unlock(__my_malloc_stripe(number));
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#else
+	const uint64_t blockSize = __my_malloc_registered_block_size(currentBlock);
+#endif
+
+	return blockSize;
 }
 
 /**
- * @brief frees a pointer, a NULL pointer is ignored and a safe noop,
- * if the pointer is not allocated with my_malloc, this call is undefined behaviour. It likely will
- * crash or create a blockInformation structure, that will crash in later stages, since it tries to
- * interpret some random garbage memory as block-structure, so be aware of that!
- * DOUBLE Frees crash the program, so remember to always set freed pointer sto NULL :)
- *
- * @note MT-safe, using the mutex, or the thread local storage, the same principles as in my_malloc
- * apply, so calling this with an uninitialized allocator is undefined behaviour and crashes the
- * program
+ * @brief returns true, if ptr points into a memory block, that the allocator uses, in any thread,
+ * that is a binary search over the mapped memory blocks
  *
+ * @note MT-safe, without any lock, it may race with the mapping or unmapping of the memory block,
+ * that contains ptr, then either answer is returned
  */
-void my_free(void* ptr) {
+bool my_allocator_owns(const void* ptr) {
+	uint64_t epoch = 0;
+	const bool owns =
+	    __my_malloc_registry_find(__my_malloc_registry_enter(&epoch), ptr) != NULL;
+	__my_malloc_registry_leave(epoch);
 
-	// so that if you pass a wrong argument just nothing happens!
-	if(ptr == NULL) {
-		return;
-	}
+	return owns;
+}
+
+/**
+ * @brief merges the small freed blocks, that are kept in the fastbins, with their neighbours, the
+ * memory blocks, that are empty afterwards, are released. malloc does that itself, if no free block
+ * is big enough, so this is only needed to give memory back early. Returns true, if a memory block
+ * was released
+ *
+ * @note MT-safe, using the mutex, in the thread local case only the fastbins of the calling thread
+ * are emptied, the ones of other threads are emptied at their exit
+ */
+bool my_allocator_trim(void) {
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
 	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
@@ -672,329 +3366,695 @@ void my_free(void* ptr) {
 	// system is already malfunctioning
 	checkResultForThreadErrorAndExit(
 	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	const uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
 #endif
 
-	__internal__my_free(ptr);
+	uint64_t memoryBlocks = 0;
+	for(MemoryBlockinformation* memoryBlock = __my_malloc_globalObject.block; memoryBlock != NULL;
+	    memoryBlock = memoryBlock->next) {
+		memoryBlocks++;
+	}
+
+	__my_malloc_consolidate(&__my_malloc_globalObject);
+
+	// a released memory block is removed from the list
+	for(MemoryBlockinformation* memoryBlock = __my_malloc_globalObject.block; memoryBlock != NULL;
+	    memoryBlock = memoryBlock->next) {
+		memoryBlocks--;
+	}
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-	checkResultForThreadErrorAndExit(
-	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+	__my_malloc_unlock(lockedStripes);
 #endif
+
+	return memoryBlocks != 0;
 }
 
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+
+// the work of one step of the background thread is bounded by these, so that it doesn't hold the
+// mutex for long, if there is more, the next step starts right away
+#define MY_MALLOC_MAINTENANCE_BLOCKS 256U
+#define MY_MALLOC_MAINTENANCE_RELEASES 8U
+
 /**
- * @brief If ptr is NULL, this behaves as my_malloc
- * If size == 0 it behaves as my_free and returns NULL
+ * @brief INTERNAL FUNCTION: DO NOT USE
  *
- * Otherwise it reallocates the memory, it may have a different address than before, but the return
- * value may also be the same as ptr. If the new size is greater than the previous size, the whole
- * content of the previous ptr is preserves and copied to the new ptr, if needed, the rest of the
- * data is undefined. If the new size is smaller, the data beyond that is potentially overwritten,
- * at least it's not accessible anymore, the returned ptr can be the same, but doesn't have to be
- * the same, since realloc may chose a better suited block for it, if that'S the case, the data up
- * to the new size is the same as the old one
+ * one step of the background thread, it merges a bounded number of blocks of the fastbins with
+ * their neighbours, and releases a bounded number of empty memory blocks, returns true, if there
+ * is more work left
  */
-void* my_realloc(void* ptr, uint64_t size) {
+static bool __my_malloc_maintenance_step(void) {
 
-	// if ptr == NULL, it is the same as my_malloc(size);
-	if(ptr == NULL) {
-		return my_malloc(size);
-	}
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	const uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
 
-	// if size == 0, it is the same as my_free(size);
-	if(size == 0) {
-		my_free(ptr);
-		return NULL;
+	uint32_t merged = 0;
+
+	for(size_t i = 0; i < MY_MALLOC_FASTBIN_COUNT && merged < MY_MALLOC_MAINTENANCE_BLOCKS; ++i) {
+		BlockInformation* block = NULL;
+
+		while(merged < MY_MALLOC_MAINTENANCE_BLOCKS &&
+		      (block = __my_malloc_fastbin_pop(&__my_malloc_globalObject.fastbins[i])) != NULL) {
+			block->flags = 0;
+			__my_malloc_free_block(&__my_malloc_globalObject, block);
+			merged++;
+		}
 	}
 
-#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	bool moreWork = merged == MY_MALLOC_MAINTENANCE_BLOCKS;
+	uint32_t released = 0;
 
-	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
-		fprintf(stderr, "Calling realloc before initializing the allocator is prohibited!\n");
-		exit(1);
+	MemoryBlockinformation* memoryBlock = __my_malloc_globalObject.block;
+
+	while(memoryBlock != NULL) {
+		// the memory block is removed from the list, if it is released
+		MemoryBlockinformation* nextMemoryBlock = memoryBlock->next;
+		BlockInformation* firstBlock = get_first_block(memoryBlock);
+
+		if(firstBlock->status == FREE && firstBlock->nextBlock == NULL) {
+			if(released == MY_MALLOC_MAINTENANCE_RELEASES) {
+				moreWork = true;
+				break;
+			}
+
+			__my_malloc_release_if_empty(&__my_malloc_globalObject, firstBlock);
+			released++;
+		}
+
+		memoryBlock = nextMemoryBlock;
 	}
 
-	// mutex errors are better when being asserted, since no real errors can occur, only when the
-	// system is already malfunctioning
+	__my_malloc_unlock(lockedStripes);
+
+	return moreWork;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the background thread, it does a step every interval, or when it is signalled, until it is
+ * stopped
+ */
+static void* __my_malloc_maintenance_main(void* arg) {
+	(void)arg;
+
+	bool moreWork = false;
+
+	int result = pthread_mutex_lock(&__my_malloc_maintenanceMutex);
 	checkResultForThreadErrorAndExit(
 	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
-#endif
 
-	// calling my_malloc without initializing the allocator doesn't work, if that is the case,
-	// likely the uninitialized mutex access before this will crash the program, but that is here
-	// for safety measures! AND ALSO in the case of uninitialized allocator in the thread local case
-	if(__my_malloc_globalObject.defaultMemoryBlockSize == 0) {
-		fprintf(stderr, "Calling realloc before initializing the allocator is prohibited!\n");
-		exit(1);
+	while(!__my_malloc_maintenanceStop) {
+
+		if(!moreWork && !atomic_load(&__my_malloc_maintenancePending)) {
+			struct timespec timeout;
+			clock_gettime(CLOCK_REALTIME, &timeout);
+
+			const uint64_t nanoseconds =
+			    (uint64_t)timeout.tv_nsec + (uint64_t)__my_malloc_maintenanceInterval * 1000000U;
+			timeout.tv_sec += (time_t)(nanoseconds / 1000000000U);
+			timeout.tv_nsec = (long)(nanoseconds % 1000000000U);
+
+			result = pthread_cond_timedwait(&__my_malloc_maintenanceCondition,
+			                                &__my_malloc_maintenanceMutex, &timeout);
+
+			if(result == ETIMEDOUT) {
+				result = 0;
+			}
+
+			checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to wait "
+			                                 "for the condition in the internal allocator");
+
+			if(__my_malloc_maintenanceStop) {
+				break;
+			}
+		}
+
+		atomic_store(&__my_malloc_maintenancePending, false);
+
+		result = pthread_mutex_unlock(&__my_malloc_maintenanceMutex);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+		moreWork = __my_malloc_maintenance_step();
+
+		result = pthread_mutex_lock(&__my_malloc_maintenanceMutex);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 	}
 
-	BlockInformation* currentBlock =
-	    (BlockInformation*)((pseudoByte*)ptr - sizeof(BlockInformation));
+	result = pthread_mutex_unlock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
 
-	if(__my_malloc_globalObject.block == NULL) {
-		// no block is not free, since we have no block anymore xD
-		printErrorAndExit("ERROR: You tried to realloc a freed Block: %p\n", ptr);
+	return NULL;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * starts the background thread, with a step every interval milliseconds
+ */
+static void __my_malloc_maintenance_start(uint32_t interval) {
+
+	__my_malloc_maintenanceInterval = interval;
+	__my_malloc_maintenanceStop = false;
+	atomic_store(&__my_malloc_maintenancePending, false);
+
+	int result = pthread_create(&__my_malloc_maintenanceThread, NULL, __my_malloc_maintenance_main,
+	                            NULL);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to start the background thread of the allocator");
+
+	atomic_store(&__my_malloc_maintenanceRunning, true);
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * stops the background thread and waits for it, if it is running
+ */
+static void __my_malloc_maintenance_stop(void) {
+
+	if(!atomic_load(&__my_malloc_maintenanceRunning)) {
+		return;
 	}
 
-	if(currentBlock->status == FREE) {
-		printErrorAndExit("ERROR: You tried to realloc a freed Block: %p\n", ptr);
+	int result = pthread_mutex_lock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	__my_malloc_maintenanceStop = true;
+
+	result = pthread_cond_signal(&__my_malloc_maintenanceCondition);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to signal the "
+	                                 "condition in the internal allocator");
+
+	result = pthread_mutex_unlock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	result = pthread_join(__my_malloc_maintenanceThread, NULL);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to join the background thread of the allocator");
+
+	atomic_store(&__my_malloc_maintenanceRunning, false);
+}
+
+#endif
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * walks the block lists of every memory block of the GlobalObject and calls the callback for every
+ * block
+ *
+ * @note Needs to be called with the mutex locked, in order to be thread safe!
+ */
+INTERNAL_FUNCTION void __my_malloc_walk_blocks(GlobalObject* globalObject, my_heap_walk_fn callback,
+                                               void* ctx) {
+
+	for(MemoryBlockinformation* memoryBlock = globalObject->block; memoryBlock != NULL;
+	    memoryBlock = memoryBlock->next) {
+
+		for(BlockInformation* block = get_first_block(memoryBlock); block != NULL;
+		    block = (BlockInformation*)block->nextBlock) {
+
+			// the memory block is already known here, so the size of the last one is computed
+			// directly, instead of searching the memory block by its number again
+			const uint64_t blockSize =
+			    block->nextBlock == NULL
+			        ? (uint64_t)(((pseudoByte*)memoryBlock + memoryBlock->size) -
+			                     (pseudoByte*)block) -
+			              sizeof(BlockInformation)
+			        : size_of_double_pointer_block(globalObject, block);
+
+			const struct my_heap_block_info info = {
+				.memory_block = memoryBlock,
+				.memory_block_size = memoryBlock->size,
+				.memory_block_number = memoryBlock->number,
+				.header = block,
+				.data = (pseudoByte*)block + sizeof(BlockInformation),
+				.size = blockSize,
+				.free = block->status == FREE || (block->flags & IN_FASTBIN) != 0,
+			};
+
+			callback(&info, ctx);
+		}
 	}
+}
 
-	// ATTENTION: this size isn't always the correct size, of the previous alloc! since some amount
-	// of dread space can be at the end, it can be between 0 and sizeof(BlockInformation) bytes,
-	// since there's no room for a new block in there. So every calculation here has to pay
-	// attention to that
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the callback for __my_malloc_walk_blocks, that adds the free blocks to the stats, the used ones
+ * are counted, see __my_malloc_count_used
+ */
+static void __my_malloc_collect_block_stats(const struct my_heap_block_info* info, void* ctx) {
+	struct my_malloc_stats* stats = (struct my_malloc_stats*)ctx;
 
-	// It is fine, to copy the undefined memory, since it's  at the end, where the new memory would
-	// be undefined nevertheless
-	const uint64_t blockSize = size_of_double_pointer_block(currentBlock);
+	if(info->free) {
+		stats->free_bytes += info->size;
+		stats->free_blocks++;
 
-	// CASE 1: the new size is smaller or the same (it may be also the same, if the blockSize is
-	// slightly bigger, since there might be end padding!)
-	if(size <= blockSize) {
+		if(info->size > stats->largest_free_block) {
+			stats->largest_free_block = info->size;
+		}
+	}
+}
 
-		// CASE 1.1: no new block can be placed after the new size, so just returning the old size
-		// and doing some valgrind house keeping
-		if(blockSize - size <= sizeof(BlockInformation)) {
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * adds the counters to the stats
+ */
+static void __my_malloc_collect_counter_stats(AllocatorCounters* counters,
+                                              struct my_malloc_stats* stats) {
+	stats->mapped_bytes += __my_malloc_counter_get(counters->mappedBytes);
+	stats->memory_blocks += __my_malloc_counter_get(counters->memoryBlocks);
+	stats->mmap_calls += __my_malloc_counter_get(counters->mmapCalls);
+	stats->munmap_calls += __my_malloc_counter_get(counters->munmapCalls);
+	stats->used_bytes += __my_malloc_counter_get(counters->usedBytes);
+	stats->used_blocks += __my_malloc_counter_get(counters->usedBlocks);
+}
 
-			VALGRIND_FREE(ptr, 0);
-			VALGRIND_ALLOC(ptr, size, 0, false);
+/**
+ * @brief fills stats with the current state of the allocator. The counters are cheap, they are
+ * updated on every mmap and munmap, and the used bytes and blocks on every allocation and free, so
+ * only the free blocks, the largest free block and the fragmentation are computed by walking the
+ * block lists, that takes time proportional to the number of blocks. The fragmentation is 1 -
+ * largest_free_block / free_bytes, so 0 means, that all free memory is in one block
+ *
+ * @note MT-safe, using the mutex, in the thread local case the counters of all threads are summed
+ * up, so the mapped and the used memory are the ones of the whole process, but only the block lists
+ * of the calling thread and of the exited threads are walked, since the ones of other running
+ * threads can't be accessed safely
+ */
+void my_allocator_stats(struct my_malloc_stats* stats) {
+
+	*stats = (struct my_malloc_stats){ 0 };
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-			int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-			checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-			                                 "unlock the internal allocator mutex");
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	const uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
 #endif
-			// just return the old pointer
-			return ptr;
 
-		} else {
+	__my_malloc_walk_blocks(&__my_malloc_globalObject, __my_malloc_collect_block_stats, stats);
 
-			// CASE 1.2: make a new block, that is free, and is at the end of size
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 
-			// If applicable we search a better block, that is better suited for that cause, that
-			// is computational intensive, but it may create less holes in the end also pay
-			// attention to padding, so it has to be at least sizeof(BlockInformation) smaller, to
-			// allocate a new block!
+	__my_malloc_walk_blocks(&__my_malloc_orphanObject, __my_malloc_collect_block_stats, stats);
+	__my_malloc_collect_counter_stats(&__my_malloc_orphanObject.counters, stats);
 
-			// CASE 1.2.1: the new areas is significantly smaller than the last one, so using free +
-			// malloc to get a better spot for the significantly smaller size, use 50% as threshold,
-			// so that if it's 50% smaller, use malloc to get a new block
-			// small NOTE: since we don't free this block before issuing a malloc, this block might
-			// be suited better, but we have to use another xD, it might even return NULL, so it'S
-			// out of memory xD
-			if(size * 2 < blockSize) {
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	result = pthread_mutex_lock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 
-				void* newRegion = __internal__my_malloc(size, NULL);
+	for(GlobalObject* threadObject = __my_malloc_threadList; threadObject != NULL;
+	    threadObject = threadObject->nextThread) {
+		__my_malloc_collect_counter_stats(&threadObject->counters, stats);
+	}
 
-				// out of memory, so just use the current nevertheless xD
-				// ATTENTION: code duplication, since no good pattern emerges, to reuse code via
-				// call or control flow :(
-				if(newRegion == NULL) {
+	__my_malloc_collect_counter_stats(&__my_malloc_retiredCounters, stats);
 
-					VALGRIND_FREE(ptr, 0);
+	result = pthread_mutex_unlock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#else
+	__my_malloc_collect_counter_stats(&__my_malloc_globalObject.counters, stats);
+#endif
 
-					BlockInformation* newBlock =
-					    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
-					                        size);
-					MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	// a stripe, that isn't locked, has no memory block, so nothing changes its counters
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		__my_malloc_collect_counter_stats(&__my_malloc_stripeCounters[i], stats);
+	}
 
-					newBlock->nextBlock = currentBlock->nextBlock; // may be NULL
-					newBlock->previousBlock = currentBlock;
-					newBlock->status = FREE;
-					newBlock->blockNumber = currentBlock->blockNumber;
+	__my_malloc_unlock_stripes(lockedStripes);
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#endif
 
-					currentBlock->nextBlock = newBlock;
-					if(newBlock->nextBlock != NULL) {
-						((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
-					}
+	stats->fragmentation =
+	    stats->free_bytes == 0
+	        ? 0.0
+	        : 1.0 - ((double)stats->largest_free_block / (double)stats->free_bytes);
+}
 
-					VALGRIND_ALLOC(ptr, size, 0, false);
+/**
+ * @brief calls the callback for every block of every memory block, in address order inside a memory
+ * block, the callback gets the memory block, the header and the data of the block, so the sizes of
+ * the headers don't have to be guessed
+ *
+ * @note MT-safe, using the mutex, the callback is called with it locked, so it must not use the
+ * allocator, in the thread local case only the memory blocks of the calling thread and of exited
+ * threads are visited, the same as in my_allocator_stats
+ */
+void my_heap_walk(my_heap_walk_fn callback, void* ctx) {
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-					int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-					checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-					                                 "unlock the internal allocator mutex");
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	// mutex errors are better when being asserted, since no real errors can occur, only when the
+	// system is already malfunctioning
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	const uint64_t lockedStripes = __my_malloc_lock_stripes(&__my_malloc_globalObject);
 #endif
-					// just return the old pointer
-					return ptr;
-				}
 
-				// copy the subset of data into the new region
-				void* dest = memcpy(newRegion, ptr, size);
+	__my_malloc_walk_blocks(&__my_malloc_globalObject, callback, ctx);
 
-				if(dest != newRegion) {
-					fprintf(stderr,
-					        "Error during memcpy, dest pointer is not the same as the given dest "
-					        "pointer: "
-					        "%p != %p\n",
-					        newRegion, dest);
-					exit(1);
-				}
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 
-				// free the previous section
-				__internal__my_free(ptr);
+	__my_malloc_walk_blocks(&__my_malloc_orphanObject, callback, ctx);
+
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#endif
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-				int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-				checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-				                                 "unlock the internal allocator mutex");
+	__my_malloc_unlock_stripes(lockedStripes);
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
 #endif
-				// return the new region
-				return newRegion;
+}
 
-			} else {
+// the number of cells of the map of one memory block in my_heap_dump_map
+#define HEAP_MAP_CELLS 64
 
-				// CASE 1.2.2: just divide the block and use the current One
+typedef struct {
+	int fd;
+	bool success;
+	// the memory block, that is currently collected, NULL before the first block
+	void* memoryBlock;
+	uint64_t memoryBlockSize;
+	uint32_t memoryBlockNumber;
+	uint64_t usedBytes;
+	uint64_t usedBlocks;
+	uint64_t freeBlocks;
+	// headers are counted as used in here
+	uint64_t usedCellBytes[HEAP_MAP_CELLS];
+	uint64_t freeCellBytes[HEAP_MAP_CELLS];
+} HeapMapState;
 
-				VALGRIND_FREE(ptr, 0);
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * writes everything, returns false on an error
+ */
+static bool __my_malloc_write_all(int fd, const char* buffer, size_t length) {
+	while(length > 0) {
+		const ssize_t written = write(fd, buffer, length);
 
-				BlockInformation* newBlock =
-				    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
-				                        size);
-				MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+		if(written < 0) {
+			if(errno == EINTR) {
+				continue;
+			}
+			return false;
+		}
 
-				newBlock->nextBlock = currentBlock->nextBlock; // may be NULL
-				newBlock->previousBlock = currentBlock;
-				newBlock->status = FREE;
-				newBlock->blockNumber = currentBlock->blockNumber;
+		buffer += written;
+		length -= (size_t)written;
+	}
 
-				currentBlock->nextBlock = newBlock;
-				if(newBlock->nextBlock != NULL) {
-					((BlockInformation*)newBlock->nextBlock)->previousBlock = newBlock;
-				}
+	return true;
+}
 
-				VALGRIND_ALLOC(ptr, size, 0, false);
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * adds the range [start, end) of the current memory block to the cells, it touches
+ */
+static void __my_malloc_heap_map_add(HeapMapState* state, void* start, void* end, bool isFree) {
+	const uint64_t cellSize = (state->memoryBlockSize + HEAP_MAP_CELLS - 1) / HEAP_MAP_CELLS;
 
-#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-				int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-				checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-				                                 "unlock the internal allocator mutex");
-#endif
-				// just return the old pointer
-				return ptr;
-			}
+	uint64_t offset = (uint64_t)((pseudoByte*)start - (pseudoByte*)state->memoryBlock);
+	const uint64_t endOffset = (uint64_t)((pseudoByte*)end - (pseudoByte*)state->memoryBlock);
+
+	while(offset < endOffset) {
+		const uint64_t cell = offset / cellSize;
+		const uint64_t nextCell = (cell + 1) * cellSize;
+		const uint64_t cellEnd = nextCell < endOffset ? nextCell : endOffset;
+
+		if(isFree) {
+			state->freeCellBytes[cell] += cellEnd - offset;
+		} else {
+			state->usedCellBytes[cell] += cellEnd - offset;
 		}
 
-	} else {
-		// CASE 2: the size is bigger
+		offset = cellEnd;
+	}
+}
 
-		// it is enough to look forward one block, since there is per guarantee no block that is
-		// also free, after a free block
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * writes the line of the current memory block, '#' is a cell, that is completely used, '.' one
+ * that is completely free and ':' one that is both
+ */
+static void __my_malloc_heap_map_flush(HeapMapState* state) {
+	if(state->memoryBlock == NULL || !state->success) {
+		return;
+	}
 
-		BlockInformation* nextBlock = (BlockInformation*)currentBlock->nextBlock; // may be NULL
+	char buffer[256];
 
-		// Case 2.1: the current block with the next block can fit the new size!
-		if(nextBlock != NULL && nextBlock->status == FREE) {
-			const uint64_t nextBlockSize = size_of_double_pointer_block(nextBlock);
+	int length = snprintf(buffer, sizeof(buffer), "%u %p %lu %lu %lu %lu |",
+	                      state->memoryBlockNumber, state->memoryBlock, state->memoryBlockSize,
+	                      state->usedBytes, state->usedBlocks, state->freeBlocks);
 
-			const uint64_t totalPotentialSize =
-			    nextBlockSize + sizeof(BlockInformation) + blockSize;
+	for(size_t i = 0; i < HEAP_MAP_CELLS; ++i) {
+		buffer[length++] = state->freeCellBytes[i] == 0  ? '#'
+		                   : state->usedCellBytes[i] == 0 ? '.'
+		                                                  : ':';
+	}
 
-			if(totalPotentialSize >= size) {
+	buffer[length++] = '|';
+	buffer[length++] = '\n';
 
-				// figure out, if theres space for another block inside the new larger area!
+	state->success = __my_malloc_write_all(state->fd, buffer, (size_t)length);
+}
 
-				// CASE 2.1.1: no new block can be placed inside the new larger area, just deleting
-				// the old in the middle (nextBlock)
-				if(totalPotentialSize - size <= (sizeof(BlockInformation))) {
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the callback for __my_malloc_walk_blocks, that collects the occupancy of one memory block, until
+ * the next one starts
+ */
+static void __my_malloc_heap_map_block(const struct my_heap_block_info* info, void* ctx) {
+	HeapMapState* state = (HeapMapState*)ctx;
+
+	if(info->memory_block != state->memoryBlock) {
+		__my_malloc_heap_map_flush(state);
+
+		state->memoryBlock = info->memory_block;
+		state->memoryBlockSize = info->memory_block_size;
+		state->memoryBlockNumber = info->memory_block_number;
+		state->usedBytes = 0;
+		state->usedBlocks = 0;
+		state->freeBlocks = 0;
+		memset(state->usedCellBytes, 0, sizeof(state->usedCellBytes));
+		memset(state->freeCellBytes, 0, sizeof(state->freeCellBytes));
+
+		// the header of the memory block
+		__my_malloc_heap_map_add(state, info->memory_block, info->header, false);
+	}
 
-					currentBlock->nextBlock = nextBlock->nextBlock; // can be NULL
-					if(nextBlock->nextBlock != NULL) {
-						((BlockInformation*)nextBlock->nextBlock)->previousBlock = currentBlock;
-					}
+	__my_malloc_heap_map_add(state, info->header, info->data, false);
+	__my_malloc_heap_map_add(state, info->data, (pseudoByte*)info->data + info->size, info->free);
 
-					MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
-					VALGRIND_ALIGN_ALLOC_TO_GREATER_BLOCK(ptr, size);
+	if(info->free) {
+		state->freeBlocks++;
+	} else {
+		state->usedBytes += info->size;
+		state->usedBlocks++;
+	}
+}
 
-#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-					int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-					checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-					                                 "unlock the internal allocator mutex");
-#endif
-					// just return the old pointer, it has now space for the size
-					return ptr;
+/**
+ * @brief writes a compact occupancy map of every memory block to fd, one line per memory block with
+ * its number, address, size, used bytes, used blocks, free blocks and a map of HEAP_MAP_CELLS
+ * cells, returns 0 on success, -1 with errno set on a write error
+ *
+ * @note MT-safe, the same as my_heap_walk, the writes are done with the mutex locked
+ */
+int my_heap_dump_map(int fd) {
 
-				} else {
+	HeapMapState state = { .fd = fd, .success = true, .memoryBlock = NULL };
 
-					// CASE 2.1.2: delete the current one and create a new one at the end, that is
-					// free
+	const char* legend = "# number address size used_bytes used_blocks free_blocks |map| "
+	                     "('#' used, '.' free, ':' both)\n";
 
-					BlockInformation* newBlock =
-					    (BlockInformation*)(((pseudoByte*)currentBlock + sizeof(BlockInformation)) +
-					                        size);
-					MEMCHECK_DEFINE_INTERNAL_USE(newBlock, sizeof(BlockInformation));
+	if(!__my_malloc_write_all(fd, legend, strlen(legend))) {
+		return -1;
+	}
 
-					newBlock->previousBlock = currentBlock;
-					newBlock->nextBlock = nextBlock->nextBlock; // can be NULL
-					newBlock->status = FREE;
-					newBlock->blockNumber = currentBlock->blockNumber;
+	my_heap_walk(__my_malloc_heap_map_block, &state);
 
-					currentBlock->nextBlock = newBlock;
+	// the last memory block isn't followed by another one, that would flush it
+	__my_malloc_heap_map_flush(&state);
 
-					if(nextBlock->nextBlock != NULL) {
-						((BlockInformation*)nextBlock->nextBlock)->previousBlock = newBlock;
-					}
+	return state.success ? 0 : -1;
+}
 
-					MEMCHECK_REMOVE_INTERNAL_USE(nextBlock, sizeof(BlockInformation));
-					VALGRIND_ALIGN_ALLOC_TO_GREATER_BLOCK(ptr, size);
+/**
+ * @brief these three are meant to be used with pthread_atfork, the prepare handler locks the
+ * allocator, so that no other thread is in the middle of an operation, while forking, the parent
+ * then just unlocks it again, and the child reinitializes the mutex, since only the forking thread
+ * exists in there
+ *
+ * @note in the thread local variant only the mutexes of the orphan object and the stats are
+ * handled, in the not MT-safe variant only the ones of the heap profiler and the trace recorder, a
+ * running trace is stopped in the child
+ */
+void my_allocator_fork_prepare(void) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	int result = pthread_mutex_lock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	// every stripe, since a free locks its stripe without the mutex
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		result = pthread_mutex_lock(&__my_malloc_stripes[i]);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+	}
+#elif !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_lock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+
+	result = pthread_mutex_lock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+#endif
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	result = pthread_mutex_lock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
+#endif
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-					int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-					checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-					                                 "unlock the internal allocator mutex");
+	result = pthread_mutex_lock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex in the internal allocator");
 #endif
-					// just return the old pointer, it has now space for the size
-					return ptr;
-				}
-			}
-		}
 
-		// CASE 2.2 we need to issue a new malloc and copy the data over
-		void* newRegion = __internal__my_malloc(size, NULL);
+	__my_malloc_profile_fork_prepare();
+	__my_malloc_trace_fork_prepare();
+}
+
+void my_allocator_fork_parent(void) {
+	__my_malloc_trace_fork_parent();
+	__my_malloc_profile_fork_parent();
 
-		if(newRegion == NULL) {
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-			int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
-			checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-			                                 "unlock the internal allocator mutex");
+	int result = pthread_mutex_unlock(&__my_malloc_maintenanceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+
+	result = pthread_mutex_unlock(&__my_malloc_registryMutex);
+#elif !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_unlock(&__my_malloc_registryMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
 #endif
 
-			return NULL;
-		}
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		result = pthread_mutex_unlock(&__my_malloc_stripes[i]);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+	}
 
-		// copy the data into the new region, the blockSize is not 100%% accurate, but as said
-		// above, the rest is undefined memory, as the rest of the newRegion region
-		void* dest = memcpy(newRegion, ptr, blockSize);
+	result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#elif !defined(_ALLOCATOR_NOT_MT_SAVE)
+	result = pthread_mutex_unlock(&__my_malloc_statsMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
 
-		if(dest != newRegion) {
-			fprintf(stderr,
-			        "Error during memcpy, dest pointer is not the same as the given dest pointer: "
-			        "%p != %p\n",
-			        newRegion, dest);
-			exit(1);
-		}
+	result = pthread_mutex_unlock(&__my_malloc_orphanMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the internal allocator mutex");
+#endif
+}
 
-		// free the previous section
-		__internal__my_free(ptr);
+void my_allocator_fork_child(void) {
+	__my_malloc_trace_fork_child();
+	__my_malloc_profile_fork_child();
+
+	// the readers of the registry in other threads don't exist in the child
+	atomic_store(&__my_malloc_registryReaders[0], 0);
+	atomic_store(&__my_malloc_registryReaders[1], 0);
+
+#if !defined(_ALLOCATOR_NOT_MT_SAVE)
+	int result = pthread_mutex_init(&__my_malloc_registryMutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+#endif
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
-		int result = pthread_mutex_unlock(&__my_malloc_globalObject.mutex);
+	result = pthread_mutex_init(&__my_malloc_globalObject.mutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		result = pthread_mutex_init(&__my_malloc_stripes[i], NULL);
 		checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
-		                                 "unlock the internal allocator mutex");
-#endif
-		// return the new region
-		return newRegion;
+		                                 "initializing the internal mutex for the allocator");
 	}
+
+	// the background thread doesn't exist in the child, the heap is maintained in the frees again
+	result = pthread_mutex_init(&__my_malloc_maintenanceMutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+
+	result = pthread_cond_init(&__my_malloc_maintenanceCondition, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal condition for the allocator");
+
+	atomic_store(&__my_malloc_maintenanceRunning, false);
+	atomic_store(&__my_malloc_maintenancePending, false);
+	__my_malloc_maintenanceStop = false;
+#elif !defined(_ALLOCATOR_NOT_MT_SAVE)
+	result = pthread_mutex_init(&__my_malloc_orphanMutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+
+	result = pthread_mutex_init(&__my_malloc_statsMutex, NULL);
+	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
+	                                 "internal mutex for the allocator");
+#endif
 }
 
 /**
  * @note NOT MT-safe. this function HAS TO BE called exactly once at the start of every program,
- * that uses this. If using thread_local storage, you have to call it once per thread. After that
- * every call to free and malloc is thread safe in both cases. If this fails, the program crashes.
- * No error is returned
+ * that uses this. If using thread_local storage, calling it once in any thread is enough, every
+ * other thread initializes itself with the same size on its first allocation, after that every call
+ * to free and malloc is thread safe in both cases. If this fails, the program crashes. No error is
+ * returned
  *
  * By default the allocator doesn't allocate a memory block, it creates a block in the first called
  * malloc. But you can force the creation of, one, if you wish so, but free may remove the last one,
@@ -1005,8 +4065,60 @@ void* my_realloc(void* ptr, uint64_t size) {
  */
 
 void my_allocator_init(uint64_t size, bool force_alloc) {
+	const struct my_allocator_options options = {
+		.memory_block_size = size,
+		.force_alloc = force_alloc,
+		.fit = MY_MALLOC_FIT_BEST,
+		.good_enough_percent = 0,
+		.background_interval_ms = 0,
+		.growth_percent = 0,
+		.max_memory_block_size = 0,
+		.separate_memory_blocks = false,
+	};
+
+	my_allocator_init_ex(&options);
+}
+
+/**
+ * @note NOT MT-safe, the same as my_allocator_init, but the fit policy can be chosen, see
+ * enum my_malloc_fit, invalid options crash the program, with a background interval, the
+ * background thread is started at the end, my_allocator_destroy stops it
+ *
+ */
+void my_allocator_init_ex(const struct my_allocator_options* options) {
+	const uint64_t size = options->memory_block_size;
+	const bool force_alloc = options->force_alloc;
+
+	if(options->fit > MY_MALLOC_FIT_GOOD_ENOUGH || options->good_enough_percent > 100) {
+		printErrorAndExit("ERROR: Invalid allocator options: fit %d, good enough percent %u\n",
+		                  (int)options->fit, options->good_enough_percent);
+	}
+
+	if(options->growth_percent > 1000 ||
+	   (options->max_memory_block_size != 0 && options->max_memory_block_size < size)) {
+		printErrorAndExit("ERROR: Invalid allocator options: growth percent %u, max memory block "
+		                  "size %" PRIu64 "\n",
+		                  options->growth_percent, options->max_memory_block_size);
+	}
+
+	__my_malloc_fit = options->fit;
+	__my_malloc_goodEnoughPercent = options->good_enough_percent;
+	__my_malloc_growthPercent = options->growth_percent;
+	__my_malloc_mergeMemoryBlocks = !options->separate_memory_blocks;
+
+	if(options->max_memory_block_size == 0) {
+		__my_malloc_maxMemoryBlockSize =
+		    size > UINT64_MAX / MY_MALLOC_DEFAULT_MAX_FACTOR ? size
+		                                                      : size * MY_MALLOC_DEFAULT_MAX_FACTOR;
+	} else {
+		__my_malloc_maxMemoryBlockSize = options->max_memory_block_size;
+	}
+
 	__my_malloc_globalObject.block = NULL;
+	__my_malloc_globalObject.rover = NULL;
+	__my_malloc_fastbins_reset(&__my_malloc_globalObject);
 	__my_malloc_globalObject.defaultMemoryBlockSize = size;
+	__my_malloc_globalObject.growthSteps = 0;
 	// MAP_ANONYMOUS means, that
 	//  "The mapping is not backed by any file; its contents are initialized to zero.  The fd
 	//  argument is ignored; however, some implementations require fd to be -1 if MAP_ANONYMOUS (or
@@ -1037,6 +4149,8 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
 			                  strerror(errno));
 		}
 
+		__my_malloc_count_mapping(&__my_malloc_globalObject.counters, size, true);
+
 		// FREE is set with the 0 initialized region automatically (only here!)
 
 		MEMCHECK_REMOVE_INTERNAL_USE(__my_malloc_globalObject.block, size);
@@ -1061,6 +4175,8 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
 		firstBlock->previousBlock = NULL;
 		firstBlock->status = FREE;
 		firstBlock->blockNumber = 0;
+
+		__my_malloc_registry_update(firstMemoryBlock, &__my_malloc_globalObject);
 	}
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
@@ -1068,13 +4184,40 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
 	int result = pthread_mutex_init(&__my_malloc_globalObject.mutex, NULL);
 	checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to initializing the "
 	                                 "internal mutex for the allocator");
+
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		result = pthread_mutex_init(&__my_malloc_stripes[i], NULL);
+		checkResultForThreadErrorAndExit("INTERNAL: An Error occurred while trying to "
+		                                 "initializing the internal mutex for the allocator");
+	}
+
+	if(options->background_interval_ms != 0) {
+		__my_malloc_maintenance_start(options->background_interval_ms);
+	}
 #endif
 
 // my_allocator_destroy is not always MT safe, in the thread local it is, but in the mutex case, it
 // isn't so not using it there, in the mutex case, the caller that called the initialization HAS to
 // call it manually, in the thread_local case, every thread cleans up the allocator themselves, a
 // manual call to destroy is a safe noop, but not needed
-#if _PER_THREAD_ALLOCATOR == 1
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	atomic_store_explicit(&__my_malloc_defaultMemoryBlockSize, size, memory_order_release);
+
+	int result2 = pthread_once(&__my_malloc_threadKeyOnce, __my_malloc_create_thread_key);
+	checkForThreadError(result2,
+	                    "INTERNAL: An Error occurred while trying to create the thread key for the "
+	                    "allocator",
+	                    exit(EXIT_FAILURE););
+
+	// so that the destructor is also called for this thread, if it isn't the main thread
+	result2 = pthread_setspecific(__my_malloc_threadKey, &__my_malloc_globalObject);
+	checkForThreadError(result2,
+	                    "INTERNAL: An Error occurred while trying to set the thread key for the "
+	                    "allocator",
+	                    exit(EXIT_FAILURE););
+
+	__my_malloc_register_thread();
+#elif _PER_THREAD_ALLOCATOR == 1
 	int result2 = atexit(my_allocator_destroy);
 	checkForThreadError(result2,
 	                    "INTERNAL: An Error occurred while trying to register the atexit function",
@@ -1087,10 +4230,21 @@ void my_allocator_init(uint64_t size, bool force_alloc) {
  * @note NOT MT-safe,in the thread local case it is however, this function has to be called at the
  * end of every program, except when using thread locals, than you are free to call it, but don#t
  * have to, the initializer creates an atexit handler, that destroys this, but calling it manually
- * is a safe noop
+ * is a safe noop, it also unmaps the empty memory blocks, that exited threads gave to the global
+ * pool
  *
  */
 void my_allocator_destroy(void) {
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	// it may run, even if there is no memory block
+	__my_malloc_maintenance_stop();
+#endif
+
+#if _PER_THREAD_ALLOCATOR == 1 && !defined(_ALLOCATOR_NOT_MT_SAVE)
+	// the pooled memory blocks of exited threads, even if this thread has no memory block
+	__my_malloc_chunk_pool_drain(&__my_malloc_globalObject);
+#endif
+
 	if(__my_malloc_globalObject.block == NULL) {
 		return;
 	}
@@ -1099,6 +4253,20 @@ void my_allocator_destroy(void) {
 	    (MemoryBlockinformation*)__my_malloc_globalObject.block;
 
 	__my_malloc_globalObject.block = NULL;
+	__my_malloc_globalObject.rover = NULL;
+	__my_malloc_fastbins_reset(&__my_malloc_globalObject);
+
+	// the blocks, that are still allocated, are gone with their memory blocks
+	__my_malloc_counter_add(__my_malloc_globalObject.counters.usedBytes,
+	                        -__my_malloc_counter_get(__my_malloc_globalObject.counters.usedBytes));
+	__my_malloc_counter_add(__my_malloc_globalObject.counters.usedBlocks,
+	                        -__my_malloc_counter_get(__my_malloc_globalObject.counters.usedBlocks));
+#if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		__my_malloc_stripeCounters[i].usedBytes = 0;
+		__my_malloc_stripeCounters[i].usedBlocks = 0;
+	}
+#endif
 
 	// unmap the memory blocks in order
 	while(nextMemoryBlock != NULL) {
@@ -1108,10 +4276,14 @@ void my_allocator_destroy(void) {
 
 		nextMemoryBlock = nextMemoryBlock->next;
 
+		__my_malloc_registry_update(currentMemoryBlock, NULL);
+
 		int result = munmap(currentMemoryBlock, currentMemoryBlockSize);
 		checkResultForThreadErrorAndExit("INTERNAL: Failed to munmap for the allocator:");
 
 		MEMCHECK_REMOVE_INTERNAL_USE(currentMemoryBlock, currentMemoryBlockSize);
+		__my_malloc_count_mapping(&__my_malloc_globalObject.counters, currentMemoryBlockSize,
+		                          false);
 	};
 
 #if !defined(_ALLOCATOR_NOT_MT_SAVE) && _PER_THREAD_ALLOCATOR != 1
@@ -1119,6 +4291,13 @@ void my_allocator_destroy(void) {
 	checkResultForThreadErrorAndExit(
 	    "INTERNAL: An Error occurred while trying to destroy the internal mutex "
 	    "in cleaning up for the allocator");
+
+	for(size_t i = 0; i < MY_MALLOC_STRIPES; ++i) {
+		result = pthread_mutex_destroy(&__my_malloc_stripes[i]);
+		checkResultForThreadErrorAndExit(
+		    "INTERNAL: An Error occurred while trying to destroy the internal mutex "
+		    "in cleaning up for the allocator");
+	}
 #endif
 }
 
@@ -0,0 +1,49 @@
+// header include guard
+#ifndef _MY_PERSISTENT_HEAP_H_
+#define _MY_PERSISTENT_HEAP_H_
+
+#include <stdint.h>
+
+#include "my_malloc.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the pool of the fixed pool allocator (my_malloc.c) in a file, so the blocks outlive the process,
+// the file is mapped at any address, so the blocks should refer to each other by their offsets
+// from the root block, not by pointers
+
+/**
+ * Opens the file at path as the pool of my_malloc, instead of my_allocator_init, my_malloc and
+ * my_free use its blocks then, until my_allocator_destroy. An empty or new file becomes a heap of
+ * size bytes, an existing heap is used as it is, size has to be 0 or its size then. The file is
+ * locked with flock until my_allocator_destroy, so only one process can have it open at a time.
+ * Returns 0, or -1 and sets errno, if the file can't be opened or mapped, to EWOULDBLOCK, if
+ * another process has it open, or to EINVAL, if the file isn't a heap, or its blocks aren't valid.
+ * A root, that isn't an allocated block anymore, is reset to NULL.
+ */
+int my_allocator_open_file(const char* path, uint64_t size);
+
+// the block, that the data in the file starts from, ptr has to be an allocated block of the heap
+// or NULL, otherwise the program exits
+void my_allocator_set_root(void* ptr);
+
+// the root of the file, NULL if none was set, or its block was freed
+void* my_allocator_get_root(void);
+
+/**
+ * Writes the whole file back to the disk (msync), without changing blocks in the meantime. Only
+ * this state is durable, and only as long as nothing is changed afterwards: the kernel writes the
+ * changed pages of the mapping back at any time, so if the system crashes after a later change,
+ * the file may hold parts of both states. my_allocator_open_file rejects it then, if the blocks
+ * don't fit together anymore, but the data in them isn't checked. Returns -1 and sets errno, if
+ * the file can't be written.
+ */
+int my_allocator_checkpoint(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
@@ -0,0 +1,56 @@
+// header include guard
+#ifndef _MY_SHM_HEAP_H_
+#define _MY_SHM_HEAP_H_
+
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// heaps of the fixed pool allocator (my_malloc.c) in shared memory, that several processes use at
+// the same time, every process maps them at another address, so the blocks are given out as
+// offsets from the start of the heap, that are valid in every process, and only turned into
+// pointers with my_shm_pointer in the process, that uses them
+
+// the offset of a block, 0 is never one, it is returned, if no block is big enough
+typedef uint64_t my_shm_offset_t;
+
+// the handle of one process for a shared heap
+struct my_shm_heap;
+
+/**
+ * Creates a shared heap of size bytes, in the shared memory object name (see shm_open, it has to
+ * not exist yet), or in an anonymous memfd, if name is NULL, that other processes get with fork
+ * or by passing my_shm_fd over a unix socket. Returns NULL and sets errno, if the object can't be
+ * created or mapped, or to EINVAL, if size is too small for any block.
+ */
+struct my_shm_heap* my_shm_create(const char* name, uint64_t size);
+
+/**
+ * Attaches to the shared heap in the shared memory object name or in the file descriptor fd (it
+ * is duplicated, so the caller still owns it). Returns NULL and sets errno, if it can't be mapped,
+ * or to EINVAL, if it isn't a shared heap, that was created by my_shm_create.
+ */
+struct my_shm_heap* my_shm_attach(const char* name);
+struct my_shm_heap* my_shm_attach_fd(int fd);
+
+// unmaps the heap in this process, the blocks stay valid for the other ones, the memory is freed,
+// after the last process detached, and the name was removed with shm_unlink
+void my_shm_detach(struct my_shm_heap* heap);
+
+// the file descriptor of the heap, that other processes can attach to
+int my_shm_fd(const struct my_shm_heap* heap);
+
+my_shm_offset_t my_shm_malloc(struct my_shm_heap* heap, uint64_t size);
+void my_shm_free(struct my_shm_heap* heap, my_shm_offset_t offset);
+
+// converts between the offsets and the addresses, where the heap is mapped in this process
+void* my_shm_pointer(const struct my_shm_heap* heap, my_shm_offset_t offset);
+my_shm_offset_t my_shm_offset(const struct my_shm_heap* heap, const void* ptr);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif
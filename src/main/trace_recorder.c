@@ -0,0 +1,301 @@
+/*
+Author: Totto16
+*/
+
+// records every my_malloc, my_free, my_realloc and my_memalign call into a binary trace file, the
+// format is described in trace_format.h. Every thread appends fixed size records to its own
+// segment of the file, that is mapped with MAP_SHARED, so recording is only a clock read and a
+// store and the kernel writes the pages back to the file. Only claiming a new segment takes the
+// mutex
+
+#include <fcntl.h>
+#include <pthread.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <utils.h>
+
+#include "my_malloc.h"
+#include "trace_recorder.h"
+
+// the number of records of one segment, 16384 * 40 bytes are a multiple of every page size up to
+// 64 KiB, so the segments can be mapped directly
+#define TRACE_SEGMENT_RECORDS ((uint64_t)16384)
+#define TRACE_SEGMENT_SIZE (TRACE_SEGMENT_RECORDS * sizeof(TraceRecord))
+
+_Atomic bool __my_malloc_traceEnabled = false;
+
+// the file and the end of its last segment, these are only accessed with the mutex locked
+static int __my_malloc_traceFd = -1;
+static uint64_t __my_malloc_traceFileSize = 0;
+static pthread_mutex_t __my_malloc_traceMutex = PTHREAD_MUTEX_INITIALIZER;
+
+// incremented on every start, so that threads don't write into a segment of an older trace
+static _Atomic uint64_t __my_malloc_traceSession = 0;
+static uint64_t __my_malloc_traceStart = 0;
+
+// unmaps the segment of an exiting thread
+static pthread_key_t __my_malloc_traceKey;
+static pthread_once_t __my_malloc_traceKeyOnce = PTHREAD_ONCE_INIT;
+
+static _Thread_local TraceRecord* __my_malloc_traceSegment = NULL;
+static _Thread_local uint64_t __my_malloc_traceNextRecord = 0;
+static _Thread_local uint64_t __my_malloc_traceSegmentSession = 0;
+static _Thread_local uint64_t __my_malloc_traceSegmentStart = 0;
+static _Thread_local uint32_t __my_malloc_traceThread = 0;
+
+// pthread_setspecific may allocate, these allocations are never recorded
+static _Thread_local bool __my_malloc_traceInside = false;
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * returns the time of the clock in ns
+ */
+static uint64_t __my_malloc_trace_now(clockid_t clock) {
+	struct timespec time;
+	clock_gettime(clock, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * the destructor of the key, the thread may still allocate after this, then it maps a new segment
+ */
+static void __my_malloc_trace_thread_exit(void* segment) {
+	if(segment == __my_malloc_traceSegment) {
+		__my_malloc_traceSegment = NULL;
+	}
+
+	munmap(segment, TRACE_SEGMENT_SIZE);
+}
+
+static void __my_malloc_trace_create_key(void) {
+	int result = pthread_key_create(&__my_malloc_traceKey, __my_malloc_trace_thread_exit);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to create the key of the trace recorder");
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * closes the trace file, the segments, that threads still have mapped, stay valid, until they map
+ * a new one
+ *
+ * @note Needs to be called with the mutex locked
+ */
+static void __my_malloc_trace_close(void) {
+	atomic_store_explicit(&__my_malloc_traceEnabled, false, memory_order_relaxed);
+
+	if(__my_malloc_traceFd >= 0) {
+		close(__my_malloc_traceFd);
+		__my_malloc_traceFd = -1;
+	}
+}
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * unmaps the current segment of the thread and maps a new one at the end of the file, returns false
+ * if no trace is recorded anymore, if the file can't be grown, the trace is stopped
+ */
+static bool __my_malloc_trace_claim_segment(void) {
+
+	if(__my_malloc_traceSegment != NULL) {
+		pthread_setspecific(__my_malloc_traceKey, NULL);
+		munmap(__my_malloc_traceSegment, TRACE_SEGMENT_SIZE);
+		__my_malloc_traceSegment = NULL;
+	}
+
+	int result = pthread_mutex_lock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the trace recorder");
+
+	void* segment = MAP_FAILED;
+
+	if(__my_malloc_traceFd >= 0) {
+		if(ftruncate(__my_malloc_traceFd,
+		             (off_t)(__my_malloc_traceFileSize + TRACE_SEGMENT_SIZE)) == 0) {
+			segment = mmap(NULL, TRACE_SEGMENT_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED,
+			               __my_malloc_traceFd, (off_t)__my_malloc_traceFileSize);
+		}
+
+		if(segment == MAP_FAILED) {
+			fprintf(stderr, "ERROR: Failed to grow the allocation trace, it is stopped: %s\n",
+			        strerror(errno));
+			__my_malloc_trace_close();
+		} else {
+			__my_malloc_traceFileSize += TRACE_SEGMENT_SIZE;
+			__my_malloc_traceSegmentSession =
+			    atomic_load_explicit(&__my_malloc_traceSession, memory_order_relaxed);
+			__my_malloc_traceSegmentStart = __my_malloc_traceStart;
+		}
+	}
+
+	result = pthread_mutex_unlock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the trace recorder");
+
+	if(segment == MAP_FAILED) {
+		return false;
+	}
+
+	__my_malloc_traceSegment = (TraceRecord*)segment;
+	__my_malloc_traceNextRecord = 0;
+
+	if(__my_malloc_traceThread == 0) {
+		__my_malloc_traceThread = (uint32_t)syscall(SYS_gettid);
+	}
+
+	__my_malloc_traceInside = true;
+	pthread_setspecific(__my_malloc_traceKey, segment);
+	__my_malloc_traceInside = false;
+
+	return true;
+}
+
+void __my_malloc_trace_record(TraceOperation operation, void* ptr, uint64_t argument,
+                              uint64_t size) {
+
+	if(__my_malloc_traceInside) {
+		return;
+	}
+
+	if(__my_malloc_traceSegment == NULL ||
+	   __my_malloc_traceNextRecord == TRACE_SEGMENT_RECORDS ||
+	   __my_malloc_traceSegmentSession !=
+	       atomic_load_explicit(&__my_malloc_traceSession, memory_order_relaxed)) {
+		if(!__my_malloc_trace_claim_segment()) {
+			return;
+		}
+	}
+
+	TraceRecord* record = &__my_malloc_traceSegment[__my_malloc_traceNextRecord++];
+
+	record->timestamp = __my_malloc_trace_now(CLOCK_MONOTONIC) - __my_malloc_traceSegmentStart;
+	record->ptr = (uint64_t)ptr;
+	record->argument = argument;
+	record->size = size;
+	record->thread = __my_malloc_traceThread;
+	record->operation = (uint8_t)operation;
+}
+
+void __my_malloc_trace_fork_prepare(void) {
+	int result = pthread_mutex_lock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the trace recorder");
+}
+
+void __my_malloc_trace_fork_parent(void) {
+	int result = pthread_mutex_unlock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the trace recorder");
+}
+
+/**
+ * @brief the child doesn't record into the file of the parent, since the segment of the forking
+ * thread is shared with it, it has to start its own trace
+ */
+void __my_malloc_trace_fork_child(void) {
+	int result = pthread_mutex_init(&__my_malloc_traceMutex, NULL);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to initialize the mutex of the trace recorder");
+
+	__my_malloc_trace_close();
+
+	if(__my_malloc_traceSegment != NULL) {
+		munmap(__my_malloc_traceSegment, TRACE_SEGMENT_SIZE);
+		__my_malloc_traceSegment = NULL;
+	}
+
+	__my_malloc_traceThread = 0;
+}
+
+/**
+ * @brief starts recording every allocator call into the file at path, it is truncated, if it
+ * exists. A running trace is stopped first. Returns 0 on success, -1 with errno set, if the file
+ * can't be created
+ *
+ * @note MT-safe, the records are written without a lock into a segment of the file per thread, so
+ * the overhead is a clock read per call, and a mutex and a mmap every TRACE_SEGMENT_RECORDS calls
+ */
+int my_malloc_trace_start(const char* path) {
+
+	int result = pthread_once(&__my_malloc_traceKeyOnce, __my_malloc_trace_create_key);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to create the key of the trace recorder");
+
+	result = pthread_mutex_lock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the trace recorder");
+
+	__my_malloc_trace_close();
+
+	const uint64_t dataOffset = (uint64_t)sysconf(_SC_PAGESIZE);
+
+	const TraceFileHeader header = {
+		.magic = TRACE_MAGIC,
+		.version = TRACE_VERSION,
+		.recordSize = sizeof(TraceRecord),
+		.dataOffset = dataOffset,
+		.segmentRecords = TRACE_SEGMENT_RECORDS,
+		.startTime = __my_malloc_trace_now(CLOCK_REALTIME),
+	};
+
+	int fd = open(path, O_RDWR | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+
+	if(fd >= 0 && (ftruncate(fd, (off_t)dataOffset) != 0 ||
+	               pwrite(fd, &header, sizeof(header), 0) != (ssize_t)sizeof(header))) {
+		const int savedErrno = errno;
+		close(fd);
+		errno = savedErrno;
+		fd = -1;
+	}
+
+	if(fd >= 0) {
+		__my_malloc_traceFd = fd;
+		__my_malloc_traceFileSize = dataOffset;
+		__my_malloc_traceStart = __my_malloc_trace_now(CLOCK_MONOTONIC);
+		atomic_fetch_add_explicit(&__my_malloc_traceSession, 1, memory_order_relaxed);
+		atomic_store_explicit(&__my_malloc_traceEnabled, true, memory_order_relaxed);
+	}
+
+	const int savedErrno = errno;
+
+	result = pthread_mutex_unlock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the trace recorder");
+
+	if(fd < 0) {
+		errno = savedErrno;
+		return -1;
+	}
+
+	return 0;
+}
+
+/**
+ * @brief stops recording, the file contains every record up to this point, records of other
+ * threads, that are in the middle of an allocator call, may still be appended
+ *
+ * @note MT-safe
+ */
+void my_malloc_trace_stop(void) {
+	int result = pthread_mutex_lock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to lock the mutex of the trace recorder");
+
+	__my_malloc_trace_close();
+
+	result = pthread_mutex_unlock(&__my_malloc_traceMutex);
+	checkResultForThreadErrorAndExit(
+	    "INTERNAL: An Error occurred while trying to unlock the mutex of the trace recorder");
+}
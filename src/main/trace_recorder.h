@@ -0,0 +1,45 @@
+// header guard
+#ifndef _MY_MALLOC_TRACE_RECORDER_H_
+#define _MY_MALLOC_TRACE_RECORDER_H_
+
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stdint.h>
+
+#include <trace_format.h>
+
+// the internal interface between the allocator and the trace recorder, the public functions
+// (my_malloc_trace_start, my_malloc_trace_stop) are declared in my_malloc.h
+
+// true while a trace is recorded
+extern _Atomic bool __my_malloc_traceEnabled;
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * appends a record to the segment of the calling thread, a new segment of the trace file is mapped,
+ * if that is full
+ *
+ * @note has to be called without the mutex of the allocator locked
+ */
+void __my_malloc_trace_record(TraceOperation operation, void* ptr, uint64_t argument,
+                              uint64_t size);
+
+/**
+ * @brief INTERNAL FUNCTION: DO NOT USE
+ *
+ * this is the only thing, that is done on every operation, if no trace is recorded
+ */
+static inline void __my_malloc_trace(TraceOperation operation, void* ptr, uint64_t argument,
+                                     uint64_t size) {
+	if(__builtin_expect(atomic_load_explicit(&__my_malloc_traceEnabled, memory_order_relaxed), 0)) {
+		__my_malloc_trace_record(operation, ptr, argument, size);
+	}
+}
+
+// the recorder has its own mutex, these are called by the fork handlers of the allocator
+void __my_malloc_trace_fork_prepare(void);
+void __my_malloc_trace_fork_parent(void);
+void __my_malloc_trace_fork_child(void);
+
+#endif
@@ -2,19 +2,55 @@
 Author: Totto16
 */
 
+#include <stdbool.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
 
 #include <membench.h>
 
 #include <main/my_malloc.h>
 
 // this main executes the tests and the membench, it has to be linked with the necessary .c files
-int main(void) {
+// the optional first argument is the name of the scenario, all are run without it, the others are
+// options of the benchmark
+int main(int argc, char const* argv[]) {
 
-	printf("Now running the memory benchmark with the best fit list allocator and thread local "
-	       "memory:\n");
+	membench_options options;
+	membench_default_options(&options);
+
+	for(int i = 1; i < argc; ++i) {
+		if(i == 1 && strncmp(argv[i], "--", 2) != 0) {
+			options.scenario = argv[i];
+		} else if(!parse_membench_option(argv[i], &options)) {
+			printf("usage: %s [scenario] [options]\n", argv[0]);
+			print_membench_usage();
+			return EXIT_FAILURE;
+		}
+	}
+
+#ifdef _FIXED_POOL
+	options.fixed_pool = true;
+#endif
+
+	if(options.format == MEMBENCH_FORMAT_TEXT) {
+		printf("Now running the memory benchmark with the best fit list allocator and thread local "
+		       "memory:\n");
+	}
+
+	const bool success = run_membench(my_allocator_init, my_allocator_destroy, my_malloc, my_free,
+#ifdef _WITH_REALLOC
+	                                  my_realloc,
+#else
+	                                  NULL,
+#endif
+	                                  true, &options);
+
+	if(!success) {
+		printf("usage: %s [scenario] [options]\n", argv[0]);
+		print_membench_usage();
+		return EXIT_FAILURE;
+	}
 
-	run_membench_thread_local(my_allocator_init, my_allocator_destroy, my_malloc, my_free);
 	return EXIT_SUCCESS;
 }
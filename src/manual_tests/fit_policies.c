@@ -0,0 +1,213 @@
+/*
+Author: Totto16
+*/
+
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#include <membench.h>
+#include <trace_replay.h>
+#include <utils.h>
+
+#include <main/my_malloc.h>
+
+// the size of the memory blocks of the fragmentation workload, it is small, so that the peak of
+// the mapped bytes shows, how well the free blocks are reused
+#define POOL_SIZE ((uint64_t)(1024U * 1024U))
+
+#define SEED 42U
+
+// the fragmentation workload keeps this many objects alive and replaces a random one in every step
+#define LIVE_OBJECTS 8192U
+#define STEPS 100000U
+
+// the statistics walk every block, so they are only sampled every that many steps
+#define STATS_INTERVAL 5000U
+
+#define MIB(bytes) ((double)(bytes) / (1024.0 * 1024.0))
+
+typedef struct {
+	const char* name;
+	enum my_malloc_fit fit;
+} fit_policy;
+
+static const fit_policy fit_policies[] = {
+	{ "best", MY_MALLOC_FIT_BEST },
+	{ "first", MY_MALLOC_FIT_FIRST },
+	{ "next", MY_MALLOC_FIT_NEXT },
+	{ "good-enough", MY_MALLOC_FIT_GOOD_ENOUGH },
+};
+
+#define FIT_POLICY_COUNT (sizeof(fit_policies) / sizeof(fit_policies[0]))
+
+// the membench and the trace replay call the init function with the size, so the policy is passed
+// with these
+static enum my_malloc_fit current_fit = MY_MALLOC_FIT_BEST;
+static uint32_t good_enough_percent = 10;
+
+static void init_with_fit(uint64_t size, bool force_alloc) {
+	const struct my_allocator_options options = {
+		.memory_block_size = size,
+		.force_alloc = force_alloc,
+		.fit = current_fit,
+		.good_enough_percent = good_enough_percent,
+	};
+
+	my_allocator_init_ex(&options);
+}
+
+static double elapsed_ns(const struct timespec* start, const struct timespec* end) {
+	return (double)(end->tv_sec - start->tv_sec) * 1e9 + (double)(end->tv_nsec - start->tv_nsec);
+}
+
+// every power of two between 16 and 4096 is half as likely as the one before, inside of it the
+// size is uniform, like the power-law distribution of the membench
+static uint64_t random_size(unsigned int* seed) {
+	uint64_t power = 16;
+	while(power < 4096 && rand_r(seed) % 2 == 0) {
+		power *= 2;
+	}
+
+	return power + (uint64_t)rand_r(seed) % power;
+}
+
+// replaces random objects with new ones of random sizes, so free blocks of every size are left
+// between the live ones, prints the time per operation, the peak of the mapped bytes and how
+// fragmented the free memory is at the end
+static void run_fragmentation_workload(void) {
+	void** objects = (void**)mallocOrFail(sizeof(void*) * LIVE_OBJECTS, false);
+	unsigned int seed = SEED;
+
+	init_with_fit(POOL_SIZE, false);
+
+	struct timespec start;
+	struct timespec end;
+	clock_gettime(CLOCK_MONOTONIC, &start);
+
+	for(uint32_t i = 0; i < LIVE_OBJECTS; ++i) {
+		objects[i] = my_malloc(random_size(&seed));
+	}
+
+	uint64_t peak_mapped = 0;
+	double stats_ns = 0;
+
+	for(uint32_t step = 0; step < STEPS; ++step) {
+		const uint32_t index = (uint32_t)rand_r(&seed) % LIVE_OBJECTS;
+		my_free(objects[index]);
+		objects[index] = my_malloc(random_size(&seed));
+
+		if(objects[index] == NULL) {
+			fprintf(stderr, "ERROR: The allocator is out of memory\n");
+			exit(EXIT_FAILURE);
+		}
+
+		if(step % STATS_INTERVAL == 0) {
+			struct timespec stats_start;
+			struct timespec stats_end;
+			clock_gettime(CLOCK_MONOTONIC, &stats_start);
+
+			struct my_malloc_stats stats;
+			my_allocator_stats(&stats);
+			if(stats.mapped_bytes > peak_mapped) {
+				peak_mapped = stats.mapped_bytes;
+			}
+
+			clock_gettime(CLOCK_MONOTONIC, &stats_end);
+			stats_ns += elapsed_ns(&stats_start, &stats_end);
+		}
+	}
+
+	clock_gettime(CLOCK_MONOTONIC, &end);
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	if(stats.mapped_bytes > peak_mapped) {
+		peak_mapped = stats.mapped_bytes;
+	}
+
+	// one malloc and one free per step
+	const double ns_per_operation =
+	    (elapsed_ns(&start, &end) - stats_ns) / (2.0 * STEPS + LIVE_OBJECTS);
+
+	printf("\tfragmentation workload: %.1lf ns/op, peak mapped: %.2lf MiB, used: %.2lf MiB, free: "
+	       "%.2lf MiB in %" PRIu64 " blocks, fragmentation: %.3lf\n",
+	       ns_per_operation, MIB(peak_mapped), MIB(stats.used_bytes), MIB(stats.free_bytes),
+	       stats.free_blocks, stats.fragmentation);
+
+	for(uint32_t i = 0; i < LIVE_OBJECTS; ++i) {
+		my_free(objects[i]);
+	}
+
+	my_allocator_destroy();
+	free((void*)objects);
+}
+
+static void print_usage(const char* program_name) {
+	printf("usage: %s [--trace=<path>] [--good-enough=<percent>] [membench options]\n\t trace: "
+	       "also replay this trace, recorded with my_malloc_trace_start, with every policy\n\t "
+	       "good-enough: the waste, that ends the good enough search, default: 10\n",
+	       program_name);
+	print_membench_usage();
+}
+
+// this main compares the fit policies of the best fit list allocator, that uses one mutex: every
+// policy runs a workload, that shows the fragmentation, the membench and, if given, a trace replay
+int main(int argc, char const* argv[]) {
+
+	membench_options options;
+	membench_default_options(&options);
+
+	const char* trace_path = NULL;
+
+	for(int i = 1; i < argc; ++i) {
+		if(strncmp(argv[i], "--trace=", 8) == 0) {
+			trace_path = argv[i] + 8;
+		} else if(strncmp(argv[i], "--good-enough=", 14) == 0) {
+			const long percent = parseLongSafely(argv[i] + 14, "good-enough");
+			if(percent < 0 || percent > 100) {
+				print_usage(argv[0]);
+				return EXIT_FAILURE;
+			}
+			good_enough_percent = (uint32_t)percent;
+		} else if(!parse_membench_option(argv[i], &options)) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+	}
+
+	trace_replay* replay = trace_path == NULL ? NULL : load_trace_replay(trace_path, 0);
+
+	// in the other formats, the membench prints one document for every policy, in this order
+	const bool text = options.format == MEMBENCH_FORMAT_TEXT;
+
+	for(size_t i = 0; i < FIT_POLICY_COUNT; ++i) {
+		current_fit = fit_policies[i].fit;
+
+		if(text) {
+			printf("Fit policy: %s\n", fit_policies[i].name);
+			run_fragmentation_workload();
+		}
+
+		if(!run_membench(init_with_fit, my_allocator_destroy, my_malloc, my_free, my_realloc,
+		                 false, &options)) {
+			print_usage(argv[0]);
+			return EXIT_FAILURE;
+		}
+
+		if(replay != NULL) {
+			run_trace_replay(replay, fit_policies[i].name, init_with_fit, my_allocator_destroy,
+			                 my_malloc, my_free, my_realloc);
+		}
+	}
+
+	if(replay != NULL) {
+		free_trace_replay(replay);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -1,15 +1,19 @@
 #include <assert.h>
 #include <inttypes.h>
+#include <math.h>
 #include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
 #include <stdbool.h>
 #include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
-#include <sys/time.h>
+#include <time.h>
 
 #include "membench.h"
+#include "perf_counters.h"
 
 #ifdef NDEBUG
 #define ASSERT(x) \
@@ -24,156 +28,1328 @@
 #define ASSERT(x) assert(x)
 #endif
 
-#define POOL_SIZE ((uint64_t)(1024U * 1024U * 128U))
-#define MAX_ALLOC_MULTIPLIER 4U
+#define DEFAULT_POOL_SIZE ((uint64_t)(1024U * 1024U * 128U))
+#define DEFAULT_SEED 42U
 
+// log-linear latency histogram (like HdrHistogram), values below HISTOGRAM_SUB_BUCKETS ns are
+// exact, every larger power of two is split into HISTOGRAM_SUB_BUCKETS / 2 buckets, so the relative
+// error is about 3%, and every uint64_t value fits
+#define HISTOGRAM_SUB_BITS 5U
+#define HISTOGRAM_SUB_BUCKETS (1U << HISTOGRAM_SUB_BITS)
+#define HISTOGRAM_BUCKETS ((HISTOGRAM_SUB_BUCKETS / 2U) * (64U - HISTOGRAM_SUB_BITS + 2U))
+
+typedef enum { OP_MALLOC = 0, OP_FREE, OP_REALLOC, OP_COUNT } operation_kind;
+
+static const char* const operation_names[OP_COUNT] = { "malloc", "free", "realloc" };
+
+static const char* const distribution_names[] = { "default", "uniform", "power-law", "multiples" };
+
+typedef struct {
+	uint64_t counts[HISTOGRAM_BUCKETS];
+	uint64_t total;
+	uint64_t max;
+} latency_histogram;
+
+// the functions of one allocator, init and destroy are NULL for the system allocator
 typedef struct {
-	uint64_t num_allocations;
-	uint64_t alloc_size;
+	const char* name;
 	init_allocator_fn my_init;
 	destroy_allocator_fn my_destroy;
 	malloc_fn my_malloc;
 	free_fn my_free;
-} thread_context;
+	realloc_fn my_realloc;
+} allocator_functions;
+
+// one configuration of a scenario, the meaning of allocations depends on the scenario
+typedef struct {
+	uint32_t threads;
+	uint64_t allocations;
+	uint64_t min_size;
+	uint64_t max_size;
+	membench_distribution distribution;
+} scenario_config;
+
+// every thread records into its own histograms and counters, they are merged after the join
+typedef struct {
+	uint64_t time_ns;
+	uint64_t operations;
+	latency_histogram histograms[OP_COUNT];
+	perf_counter_values counters;
+} thread_result;
+
+typedef struct scenario_thread scenario_thread;
 
-static int64_t get_timestamp_us(void) {
-	struct timeval tv;
-	const int ret = gettimeofday(&tv, NULL);
+typedef void (*scenario_thread_fn)(scenario_thread* thread);
+
+// the state of one benchmark thread, shared points to the state of the scenario, that all threads
+// of one trial share
+struct scenario_thread {
+	uint32_t index;
+	uint32_t num_threads;
+	unsigned int seed;
+	const scenario_config* config;
+	const allocator_functions* allocator;
+	bool init_per_thread;
+	bool perf_counters;
+	uint64_t pool_size;
+	scenario_thread_fn fn;
+	void* shared;
+	pthread_barrier_t* barrier;
+	thread_result result;
+};
+
+static uint64_t get_timestamp_ns(void) {
+	struct timespec ts;
+	const int ret = clock_gettime(CLOCK_MONOTONIC, &ts);
 	if(ret != 0) {
-		perror("gettimeofday");
+		perror("clock_gettime");
 		exit(EXIT_FAILURE);
 	}
-	return tv.tv_sec * 1000 * 1000 + tv.tv_usec;
+	return (uint64_t)ts.tv_sec * 1000 * 1000 * 1000 + (uint64_t)ts.tv_nsec;
+}
+
+static uint32_t histogram_index(uint64_t value) {
+	if(value < HISTOGRAM_SUB_BUCKETS) {
+		return (uint32_t)value;
+	}
+
+	const uint32_t exponent = 63U - (uint32_t)__builtin_clzll(value);
+	const uint32_t sub_bucket = (uint32_t)(value >> (exponent - HISTOGRAM_SUB_BITS + 1U));
+
+	return (exponent - HISTOGRAM_SUB_BITS + 1U) * (HISTOGRAM_SUB_BUCKETS / 2U) + sub_bucket;
+}
+
+// the middle of the range of values of the bucket
+static uint64_t histogram_value(uint32_t index) {
+	if(index < HISTOGRAM_SUB_BUCKETS) {
+		return index;
+	}
+
+	const uint32_t shift = index / (HISTOGRAM_SUB_BUCKETS / 2U) - 1U;
+	const uint64_t sub_bucket = index % (HISTOGRAM_SUB_BUCKETS / 2U) + HISTOGRAM_SUB_BUCKETS / 2U;
+
+	return (sub_bucket << shift) + ((1ULL << shift) >> 1U);
+}
+
+static inline void histogram_record(latency_histogram* histogram, uint64_t value) {
+	histogram->counts[histogram_index(value)]++;
+	histogram->total++;
+	if(value > histogram->max) {
+		histogram->max = value;
+	}
+}
+
+static void histogram_merge(latency_histogram* target, const latency_histogram* source) {
+	for(uint32_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		target->counts[i] += source->counts[i];
+	}
+	target->total += source->total;
+	if(source->max > target->max) {
+		target->max = source->max;
+	}
+}
+
+// the value, that percentile percent of the recorded values are less or equal to
+static uint64_t histogram_percentile(const latency_histogram* histogram, double percentile) {
+	const uint64_t rank = (uint64_t)((double)histogram->total * percentile / 100.0 + 0.5);
+	uint64_t count = 0;
+
+	for(uint32_t i = 0; i < HISTOGRAM_BUCKETS; ++i) {
+		count += histogram->counts[i];
+		if(count >= rank && count > 0) {
+			const uint64_t value = histogram_value(i);
+			return value > histogram->max ? histogram->max : value;
+		}
+	}
+
+	return histogram->max;
+}
+
+static void print_latencies(const latency_histogram* histograms) {
+	for(uint32_t op = 0; op < OP_COUNT; ++op) {
+		const latency_histogram* histogram = &histograms[op];
+		if(histogram->total == 0) {
+			continue;
+		}
+
+		printf("		%-7s latency (ns): p50 %" PRIu64 ", p90 %" PRIu64 ", p99 %" PRIu64
+		       ", p99.9 %" PRIu64 ", max %" PRIu64 "\n",
+		       operation_names[op], histogram_percentile(histogram, 50.0),
+		       histogram_percentile(histogram, 90.0), histogram_percentile(histogram, 99.0),
+		       histogram_percentile(histogram, 99.9), histogram->max);
+	}
+}
+
+static inline void* timed_malloc(scenario_thread* thread, uint64_t size) {
+	const uint64_t start = get_timestamp_ns();
+	void* ptr = thread->allocator->my_malloc(size);
+	histogram_record(&thread->result.histograms[OP_MALLOC], get_timestamp_ns() - start);
+	thread->result.operations++;
+	ASSERT(ptr != NULL);
+	return ptr;
+}
+
+static inline void timed_free(scenario_thread* thread, void* ptr) {
+	const uint64_t start = get_timestamp_ns();
+	thread->allocator->my_free(ptr);
+	histogram_record(&thread->result.histograms[OP_FREE], get_timestamp_ns() - start);
+	thread->result.operations++;
+}
+
+static inline void* timed_realloc(scenario_thread* thread, void* ptr, uint64_t size) {
+	const uint64_t start = get_timestamp_ns();
+	void* result = thread->allocator->my_realloc(ptr, size);
+	histogram_record(&thread->result.histograms[OP_REALLOC], get_timestamp_ns() - start);
+	thread->result.operations++;
+	ASSERT(result != NULL);
+	return result;
+}
+
+// a random value in [min, max], with favor_small every power of two is half as likely as the one
+// before (a power law, like the sizes of real allocations), otherwise every power of two is equally
+// likely (log-uniform, like the lifetimes of objects)
+static uint64_t log_random(unsigned int* seed, uint64_t min, uint64_t max, bool favor_small) {
+	const uint32_t octaves = 64U - (uint32_t)__builtin_clzll(max / min);
+
+	uint32_t octave = 0;
+	if(favor_small) {
+		while(octave + 1 < octaves && rand_r(seed) % 2 == 0) {
+			++octave;
+		}
+	} else {
+		octave = (uint32_t)rand_r(seed) % octaves;
+	}
+
+	const uint64_t lower = min << octave;
+	const uint64_t value = lower + (uint64_t)rand_r(seed) % lower;
+	return value > max ? max : value;
+}
+
+// a random size of the configured distribution
+static uint64_t random_size(scenario_thread* thread) {
+	const scenario_config* config = thread->config;
+
+	if(config->distribution == MEMBENCH_DISTRIBUTION_POWER_LAW) {
+		return log_random(&thread->seed, config->min_size, config->max_size, true);
+	}
+
+	if(config->distribution == MEMBENCH_DISTRIBUTION_MULTIPLES) {
+		return config->min_size *
+		       (1 + (uint64_t)rand_r(&thread->seed) % (config->max_size / config->min_size));
+	}
+
+	return config->min_size +
+	       (uint64_t)rand_r(&thread->seed) % (config->max_size - config->min_size + 1);
+}
+
+// the finalizer of splitmix64
+static uint64_t mix_bits(uint64_t value) {
+	value = (value ^ (value >> 30U)) * 0xBF58476D1CE4E5B9ULL;
+	value = (value ^ (value >> 27U)) * 0x94D049BB133111EBULL;
+	return value ^ (value >> 31U);
+}
+
+// every thread of every trial gets its own seed, that only depends on the seed of the options, so
+// both allocators do the same work, and every run of the program does too
+static unsigned int thread_seed(unsigned int seed, uint32_t trial, uint32_t index) {
+	return (unsigned int)mix_bits(mix_bits(((uint64_t)seed << 32U) | trial) ^ index);
+}
+
+static void* scenario_thread_main(void* arg) {
+	scenario_thread* thread = arg;
+
+	if(thread->init_per_thread) {
+		thread->allocator->my_init(thread->pool_size, true);
+	}
+
+	// the counters are opened before the barrier, so that only the scenario is counted
+	perf_counters counters;
+	if(thread->perf_counters) {
+		perf_counters_open(&counters);
+	}
+
+	pthread_barrier_wait(thread->barrier);
+
+	if(thread->perf_counters) {
+		perf_counters_start(&counters);
+	}
+	const uint64_t before = get_timestamp_ns();
+
+	thread->fn(thread);
+
+	thread->result.time_ns = get_timestamp_ns() - before;
+	if(thread->perf_counters) {
+		perf_counters_stop(&counters, &thread->result.counters);
+		perf_counters_close(&counters);
+	}
+
+	if(thread->init_per_thread) {
+		thread->allocator->my_destroy();
+	}
+
+	return NULL;
+}
+
+typedef struct {
+	const char* name;
+	const char* description;
+	// what allocations means in this scenario
+	const char* allocations_description;
+	// blocks are freed by other running threads, that doesn't work with thread local allocators
+	bool cross_thread;
+	bool needs_realloc;
+	// blocks are bigger than the pool size, that doesn't work with allocators, that can't grow
+	bool needs_growth;
+	scenario_thread_fn fn;
+	// creates the state, that all threads of one trial share, it is freed with free, may be NULL
+	void* (*create_shared)(const scenario_config* config);
+	uint32_t num_defaults;
+	scenario_config defaults[4];
+} membench_scenario;
+
+typedef struct {
+	double time_ms; // the average time per thread
+	double throughput; // in Mops/s, the operations of all threads / the time of the slowest one
+	uint64_t operations;
+	perf_counter_values counters; // the sum over all threads
+} trial_result;
+
+// runs the scenario once on config->threads threads, the latencies are merged into histograms, if
+// it isn't NULL
+static trial_result run_trial(const membench_scenario* scenario, const scenario_config* config,
+                              const allocator_functions* allocator, bool init_per_thread,
+                              const membench_options* options, uint32_t trial,
+                              latency_histogram* histograms) {
+	perf_counter_values counters;
+	perf_counter_values_init(&counters);
+
+	const uint32_t num_threads = config->threads;
+	scenario_thread* threads = calloc(num_threads, sizeof(scenario_thread));
+	pthread_t* thread_ids = calloc(num_threads, sizeof(pthread_t));
+	ASSERT(threads != NULL && thread_ids != NULL);
+
+	void* shared = scenario->create_shared != NULL ? scenario->create_shared(config) : NULL;
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, num_threads);
+
+	for(uint32_t i = 0; i < num_threads; ++i) {
+		threads[i] = (scenario_thread){ .index = i,
+			                            .num_threads = num_threads,
+			                            .seed = thread_seed(options->seed, trial, i),
+			                            .config = config,
+			                            .allocator = allocator,
+			                            .init_per_thread = init_per_thread,
+			                            .perf_counters = options->perf_counters,
+			                            .pool_size = options->pool_size,
+			                            .fn = scenario->fn,
+			                            .shared = shared,
+			                            .barrier = &barrier };
+		pthread_create(&thread_ids[i], NULL, scenario_thread_main, &threads[i]);
+	}
+
+	double time_sum = 0.0;
+	uint64_t max_time = 0;
+	uint64_t operations = 0;
+
+	for(uint32_t i = 0; i < num_threads; ++i) {
+		pthread_join(thread_ids[i], NULL);
+		time_sum += (double)threads[i].result.time_ns;
+		operations += threads[i].result.operations;
+		if(threads[i].result.time_ns > max_time) {
+			max_time = threads[i].result.time_ns;
+		}
+		perf_counter_values_add(&counters, &threads[i].result.counters);
+
+		if(histograms != NULL) {
+			for(uint32_t op = 0; op < OP_COUNT; ++op) {
+				histogram_merge(&histograms[op], &threads[i].result.histograms[op]);
+			}
+		}
+	}
+
+	pthread_barrier_destroy(&barrier);
+	free(shared);
+	free(thread_ids);
+	free(threads);
+
+	return (trial_result){ .time_ms = time_sum / num_threads / 1000.0 / 1000.0,
+		                   .throughput = max_time == 0
+		                                     ? 0.0
+		                                     : (double)operations / ((double)max_time / 1000.0),
+		                   .operations = operations,
+		                   .counters = counters };
+}
+
+// -----------------------------------
+//    statistics and output
+// -----------------------------------
+
+typedef struct {
+	double mean;
+	double stddev;
+	double ci95; // the half width of the 95% confidence interval of the mean
+} summary;
+
+// the 97.5% quantiles of the t-distribution for 1 - 30 degrees of freedom, above that, the normal
+// distribution is close enough
+static const double t_quantiles[] = { 12.706, 4.303, 3.182, 2.776, 2.571, 2.447, 2.365, 2.306,
+	                                  2.262,  2.228, 2.201, 2.179, 2.160, 2.145, 2.131, 2.120,
+	                                  2.110,  2.101, 2.093, 2.086, 2.080, 2.074, 2.069, 2.064,
+	                                  2.060,  2.056, 2.052, 2.048, 2.045, 2.042 };
+
+static summary summarize(const double* values, uint32_t count) {
+	summary result = { .mean = 0.0, .stddev = 0.0, .ci95 = 0.0 };
+
+	for(uint32_t i = 0; i < count; ++i) {
+		result.mean += values[i];
+	}
+	result.mean /= count;
+
+	if(count < 2) {
+		return result;
+	}
+
+	double squares = 0.0;
+	for(uint32_t i = 0; i < count; ++i) {
+		squares += (values[i] - result.mean) * (values[i] - result.mean);
+	}
+
+	result.stddev = sqrt(squares / (count - 1));
+
+	const uint32_t degrees = count - 1;
+	const double quantile = degrees <= sizeof(t_quantiles) / sizeof(t_quantiles[0])
+	                            ? t_quantiles[degrees - 1]
+	                            : 1.96;
+	result.ci95 = quantile * result.stddev / sqrt(count);
+
+	return result;
+}
+
+// the results of all repetitions of one configuration with one allocator
+typedef struct {
+	summary time_ms;
+	summary throughput;
+	latency_histogram histograms[OP_COUNT];
+	// summed over the repetitions, they are reported per operation
+	uint64_t operations;
+	perf_counter_values counters;
+} allocator_result;
+
+// the events of a counter per malloc / free / realloc, negative if the counter isn't available
+static double counter_per_operation(const allocator_result* result, perf_counter_kind kind) {
+	if(!result->counters.available[kind] || result->operations == 0) {
+		return -1.0;
+	}
+	return (double)result->counters.values[kind] / (double)result->operations;
+}
+
+static void print_counters(const allocator_result* result) {
+	bool any = false;
+	for(uint32_t kind = 0; kind < PERF_COUNTER_COUNT; ++kind) {
+		const double value = counter_per_operation(result, kind);
+		if(value < 0.0) {
+			continue;
+		}
+
+		printf("%s%.4g %s", any ? ", " : "\t\tper operation: ", value, perf_counter_names[kind]);
+		any = true;
+	}
+
+	if(any) {
+		printf("\n");
+	}
+}
+
+static void print_output_header(const membench_options* options) {
+	switch(options->format) {
+		case MEMBENCH_FORMAT_JSON:
+			printf("{\"seed\": %u, \"repetitions\": %" PRIu32 ", \"warmup\": %" PRIu32
+			       ", \"pool_size\": %" PRIu64 ", \"results\": [\n",
+			       options->seed, options->repetitions, options->warmup, options->pool_size);
+			break;
+		case MEMBENCH_FORMAT_CSV:
+			printf("scenario,allocator,threads,allocations,min_size,max_size,distribution,seed,"
+			       "repetitions,time_ms_mean,time_ms_stddev,time_ms_ci95,mops_mean,mops_stddev,"
+			       "mops_ci95");
+			for(uint32_t op = 0; op < OP_COUNT; ++op) {
+				const char* name = operation_names[op];
+				printf(",%s_count,%s_p50,%s_p90,%s_p99,%s_p99_9,%s_max", name, name, name, name,
+				       name, name);
+			}
+			for(uint32_t kind = 0; kind < PERF_COUNTER_COUNT; ++kind) {
+				printf(",%s_per_op", perf_counter_names[kind]);
+			}
+			printf("\n");
+			break;
+		case MEMBENCH_FORMAT_TEXT:
+		default:
+			break;
+	}
+}
+
+static void print_output_footer(const membench_options* options) {
+	if(options->format == MEMBENCH_FORMAT_JSON) {
+		printf("\n]}\n");
+	}
+}
+
+static void print_json_summary(const char* name, const summary* value) {
+	printf("\"%s\": {\"mean\": %.6f, \"stddev\": %.6f, \"ci95\": %.6f}", name, value->mean,
+	       value->stddev, value->ci95);
+}
+
+// first is true before the first result is printed
+static void print_result(const membench_scenario* scenario, const scenario_config* config,
+                         const char* allocator, const allocator_result* result,
+                         const membench_options* options, bool* first) {
+	switch(options->format) {
+		case MEMBENCH_FORMAT_JSON:
+			printf("%s  {\"scenario\": \"%s\", \"allocator\": \"%s\", \"threads\": %" PRIu32
+			       ", \"allocations\": %" PRIu64 ", \"min_size\": %" PRIu64
+			       ", \"max_size\": %" PRIu64 ", \"distribution\": \"%s\", ",
+			       *first ? "" : ",\n", scenario->name, allocator, config->threads,
+			       config->allocations, config->min_size, config->max_size,
+			       distribution_names[config->distribution]);
+			print_json_summary("time_ms", &result->time_ms);
+			printf(", ");
+			print_json_summary("throughput_mops", &result->throughput);
+			printf(", \"latency_ns\": {");
+
+			bool first_operation = true;
+			for(uint32_t op = 0; op < OP_COUNT; ++op) {
+				const latency_histogram* histogram = &result->histograms[op];
+				if(histogram->total == 0) {
+					continue;
+				}
+
+				printf("%s\"%s\": {\"count\": %" PRIu64 ", \"p50\": %" PRIu64 ", \"p90\": %" PRIu64
+				       ", \"p99\": %" PRIu64 ", \"p99_9\": %" PRIu64 ", \"max\": %" PRIu64 "}",
+				       first_operation ? "" : ", ", operation_names[op], histogram->total,
+				       histogram_percentile(histogram, 50.0), histogram_percentile(histogram, 90.0),
+				       histogram_percentile(histogram, 99.0), histogram_percentile(histogram, 99.9),
+				       histogram->max);
+				first_operation = false;
+			}
+
+			// unavailable counters are null
+			printf("}, \"perf_per_op\": {");
+			for(uint32_t kind = 0; kind < PERF_COUNTER_COUNT; ++kind) {
+				const double value = counter_per_operation(result, kind);
+				printf("%s\"%s\": ", kind == 0 ? "" : ", ", perf_counter_names[kind]);
+				if(value < 0.0) {
+					printf("null");
+				} else {
+					printf("%.6f", value);
+				}
+			}
+
+			printf("}}");
+			break;
+		case MEMBENCH_FORMAT_CSV:
+			printf("%s,%s,%" PRIu32 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%s,%u,%" PRIu32
+			       ",%.6f,%.6f,%.6f,%.6f,%.6f,%.6f",
+			       scenario->name, allocator, config->threads, config->allocations,
+			       config->min_size, config->max_size, distribution_names[config->distribution],
+			       options->seed, options->repetitions, result->time_ms.mean,
+			       result->time_ms.stddev, result->time_ms.ci95, result->throughput.mean,
+			       result->throughput.stddev, result->throughput.ci95);
+
+			for(uint32_t op = 0; op < OP_COUNT; ++op) {
+				const latency_histogram* histogram = &result->histograms[op];
+				printf(",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64 ",%" PRIu64,
+				       histogram->total, histogram_percentile(histogram, 50.0),
+				       histogram_percentile(histogram, 90.0), histogram_percentile(histogram, 99.0),
+				       histogram_percentile(histogram, 99.9), histogram->max);
+			}
+
+			// unavailable counters are empty
+			for(uint32_t kind = 0; kind < PERF_COUNTER_COUNT; ++kind) {
+				const double value = counter_per_operation(result, kind);
+				if(value < 0.0) {
+					printf(",");
+				} else {
+					printf(",%.6f", value);
+				}
+			}
+
+			printf("\n");
+			break;
+		case MEMBENCH_FORMAT_TEXT:
+		default:
+			printf("\t%s: %.2lf ms, %.2lf Mops/s", allocator, result->time_ms.mean,
+			       result->throughput.mean);
+			if(options->repetitions > 1) {
+				printf(" (95%% CI: +- %.2lf ms, +- %.2lf Mops/s, stddev: %.2lf ms, %" PRIu32
+				       " repetitions)",
+				       result->time_ms.ci95, result->throughput.ci95, result->time_ms.stddev,
+				       options->repetitions);
+			}
+			printf("\n");
+			print_latencies(result->histograms);
+			print_counters(result);
+			break;
+	}
+
+	*first = false;
 }
 
-static void* thread_fn(void* arg) {
-	thread_context* ctx = arg;
-	unsigned int seed = time(NULL);
-	void** ptrs = calloc(ctx->num_allocations, sizeof(void*));
+// runs the configuration with the system allocator (allocators[0]) and the custom one
+// (allocators[1]) and prints the results
+static void run_config(const membench_scenario* scenario, const scenario_config* config,
+                       const allocator_functions* allocators, bool init_per_thread,
+                       const membench_options* options, bool* first) {
+	const uint32_t repetitions = options->repetitions;
 
-	if(ctx->my_init != NULL) {
-		ctx->my_init(POOL_SIZE, true);
+	allocator_result* results = calloc(2, sizeof(allocator_result));
+	double* times = calloc(2 * (uint64_t)repetitions, sizeof(double));
+	double* throughputs = calloc(2 * (uint64_t)repetitions, sizeof(double));
+	ASSERT(results != NULL && times != NULL && throughputs != NULL);
+
+	for(uint32_t i = 0; i < 2; ++i) {
+		perf_counter_values_init(&results[i].counters);
+	}
+
+	if(options->format == MEMBENCH_FORMAT_TEXT) {
+		printf("%" PRIu32 " thread(s), %" PRIu64 " %s, %" PRIu64 " - %" PRIu64 " byte (%s):\n",
+		       config->threads, config->allocations, scenario->allocations_description,
+		       config->min_size, config->max_size, distribution_names[config->distribution]);
 	}
 
-	const int64_t before = get_timestamp_us();
+	// the allocators take turns, so that a slow phase of the machine affects both
+	for(uint32_t trial = 0; trial < options->warmup + repetitions; ++trial) {
+		for(uint32_t i = 0; i < 2; ++i) {
+			const bool recorded = trial >= options->warmup;
+			const trial_result result =
+			    run_trial(scenario, config, &allocators[i], i == 1 && init_per_thread, options,
+			              trial, recorded ? results[i].histograms : NULL);
 
-	// -----------------------------------
-	//    Start of benchmarked section
-	// -----------------------------------
+			if(recorded) {
+				times[i * repetitions + trial - options->warmup] = result.time_ms;
+				throughputs[i * repetitions + trial - options->warmup] = result.throughput;
+				results[i].operations += result.operations;
+				perf_counter_values_add(&results[i].counters, &result.counters);
+			}
+		}
+	}
+
+	for(uint32_t i = 0; i < 2; ++i) {
+		results[i].time_ms = summarize(&times[i * repetitions], repetitions);
+		results[i].throughput = summarize(&throughputs[i * repetitions], repetitions);
+		print_result(scenario, config, allocators[i].name, &results[i], options, first);
+	}
+
+	if(options->format == MEMBENCH_FORMAT_TEXT) {
+		const double system_time = results[0].time_ms.mean;
+		const double custom_time = results[1].time_ms.mean;
+		printf("\tCustom is %.2lf %s than System\n",
+		       system_time > custom_time ? system_time / custom_time : custom_time / system_time,
+		       system_time > custom_time ? "faster" : "slower");
+	}
+
+	free(throughputs);
+	free(times);
+	free(results);
+}
+
+// -----------------------------------
+//    phases: the original benchmark
+// -----------------------------------
+
+static void phases_thread(scenario_thread* thread) {
+	const scenario_config* config = thread->config;
+	void** ptrs = calloc(config->allocations, sizeof(void*));
+	ASSERT(ptrs != NULL);
 
 	// Make N allocations of random size
-	for(uint64_t i = 0; i < ctx->num_allocations; ++i) {
-		const uint64_t size = ctx->alloc_size * (1 + rand_r(&seed) % MAX_ALLOC_MULTIPLIER);
-		ptrs[i] = ctx->my_malloc(size);
-		assert(ptrs[i] != NULL);
+	for(uint64_t i = 0; i < config->allocations; ++i) {
+		const uint64_t size = random_size(thread);
+		ptrs[i] = timed_malloc(thread, size);
 		memset(ptrs[i], 0xFF, size);
 	}
 
 	// Free ~50% of allocations
-	for(uint64_t i = 0; i < ctx->num_allocations; ++i) {
-		if(rand_r(&seed) % 2 == 0) {
-			ctx->my_free(ptrs[i]);
+	for(uint64_t i = 0; i < config->allocations; ++i) {
+		if(rand_r(&thread->seed) % 2 == 0) {
+			timed_free(thread, ptrs[i]);
 			ptrs[i] = NULL;
 		}
 	}
 
 	// Re-allocate those ~50%
-	for(uint64_t i = 0; i < ctx->num_allocations; ++i) {
+	for(uint64_t i = 0; i < config->allocations; ++i) {
 		if(ptrs[i] == NULL) {
-			const uint64_t size = ctx->alloc_size * (1 + rand_r(&seed) % MAX_ALLOC_MULTIPLIER);
-			ptrs[i] = ctx->my_malloc(size);
-			assert(ptrs[i] != NULL);
+			ptrs[i] = timed_malloc(thread, random_size(thread));
+		}
+	}
+
+	// Grow all allocations, if the allocator supports that
+	if(thread->allocator->my_realloc != NULL) {
+		for(uint64_t i = 0; i < config->allocations; ++i) {
+			ptrs[i] = timed_realloc(thread, ptrs[i], config->max_size + config->min_size);
 		}
 	}
 
 	// Free all allocations
-	for(uint64_t i = 0; i < ctx->num_allocations; ++i) {
-		ctx->my_free(ptrs[i]);
+	for(uint64_t i = 0; i < config->allocations; ++i) {
+		timed_free(thread, ptrs[i]);
 	}
 
-	// -----------------------------------
-	//    End of benchmarked section
-	// -----------------------------------
+	free(ptrs);
+}
 
-	const int64_t after = get_timestamp_us();
+// -----------------------------------
+//    producer-consumer
+// -----------------------------------
 
-	free(ptrs);
+#define QUEUE_CAPACITY 256U
+
+// a single producer single consumer queue of pointers, a slot is NULL, if it is empty
+typedef struct {
+	_Atomic(void*) slots[QUEUE_CAPACITY];
+} pointer_queue;
+
+static void* producer_consumer_create(const scenario_config* config) {
+	pointer_queue* queues = calloc((config->threads + 1) / 2, sizeof(pointer_queue));
+	ASSERT(queues != NULL);
+	return queues;
+}
 
-	if(ctx->my_destroy != NULL) {
-		ctx->my_destroy();
+// the even threads allocate and pass the objects to the next odd thread, that frees them, with an
+// odd number of threads, the last one frees its objects itself
+static void producer_consumer_thread(scenario_thread* thread) {
+	const scenario_config* config = thread->config;
+	pointer_queue* queue = &((pointer_queue*)thread->shared)[thread->index / 2];
+	const bool alone = thread->index % 2 == 0 && thread->index + 1 == thread->num_threads;
+
+	for(uint64_t i = 0; i < config->allocations; ++i) {
+		_Atomic(void*)* slot = &queue->slots[i % QUEUE_CAPACITY];
+
+		if(alone) {
+			void* ptr = timed_malloc(thread, random_size(thread));
+			memset(ptr, 0xAB, config->min_size);
+			timed_free(thread, ptr);
+		} else if(thread->index % 2 == 0) {
+			void* ptr = timed_malloc(thread, random_size(thread));
+			memset(ptr, 0xAB, config->min_size);
+			while(atomic_load_explicit(slot, memory_order_acquire) != NULL) {
+				sched_yield();
+			}
+			atomic_store_explicit(slot, ptr, memory_order_release);
+		} else {
+			void* ptr;
+			while((ptr = atomic_load_explicit(slot, memory_order_acquire)) == NULL) {
+				sched_yield();
+			}
+			atomic_store_explicit(slot, NULL, memory_order_release);
+			timed_free(thread, ptr);
+		}
 	}
+}
+
+// -----------------------------------
+//    larson
+// -----------------------------------
+
+#define LARSON_SLOTS 500U
+#define LARSON_ROUNDS 3U
 
-	return (void*)(intptr_t)(after - before);
+static void* larson_create(const scenario_config* config) {
+	void** slots = calloc((uint64_t)config->threads * LARSON_SLOTS, sizeof(void*));
+	ASSERT(slots != NULL);
+	return slots;
 }
 
-static double run_config(uint32_t num_threads, thread_context* ctx) {
-	pthread_t thread_ids[num_threads];
-	for(uint32_t i = 0; i < num_threads; ++i) {
-		pthread_create(&thread_ids[i], NULL, thread_fn, ctx);
+// every thread replaces random objects of its slots, after every round, the slots are handed to the
+// next thread, like the server threads of the Larson benchmark, that pass their objects on
+static void larson_thread(scenario_thread* thread) {
+	void** all_slots = thread->shared;
+
+	for(uint32_t round = 0; round < LARSON_ROUNDS; ++round) {
+		void** slots = &all_slots[((thread->index + round) % thread->num_threads) * LARSON_SLOTS];
+
+		for(uint64_t i = 0; i < thread->config->allocations; ++i) {
+			void** slot = &slots[(uint32_t)rand_r(&thread->seed) % LARSON_SLOTS];
+			if(*slot != NULL) {
+				timed_free(thread, *slot);
+			}
+			*slot = timed_malloc(thread, random_size(thread));
+		}
+
+		pthread_barrier_wait(thread->barrier);
 	}
 
-	double time_sum = 0.0;
-	for(uint32_t i = 0; i < num_threads; ++i) {
-		intptr_t delta_time;
-		pthread_join(thread_ids[i], (void**)&delta_time);
-		time_sum += (double)delta_time;
+	void** slots =
+	    &all_slots[((thread->index + LARSON_ROUNDS) % thread->num_threads) * LARSON_SLOTS];
+	for(uint32_t i = 0; i < LARSON_SLOTS; ++i) {
+		if(slots[i] != NULL) {
+			timed_free(thread, slots[i]);
+		}
 	}
+}
+
+// -----------------------------------
+//    ping-pong
+// -----------------------------------
+
+#define PING_PONG_ROUNDS 50U
+
+static void* ping_pong_create(const scenario_config* config) {
+	void** batches = calloc((uint64_t)config->threads * config->allocations, sizeof(void*));
+	ASSERT(batches != NULL);
+	return batches;
+}
+
+// like threadtest, every thread allocates a batch in every round, but like xmalloc, the batch is
+// freed by the next thread
+static void ping_pong_thread(scenario_thread* thread) {
+	const uint64_t batch = thread->config->allocations;
+	void** batches = thread->shared;
+	void** own = &batches[thread->index * batch];
+	void** other = &batches[((thread->index + 1) % thread->num_threads) * batch];
+
+	for(uint32_t round = 0; round < PING_PONG_ROUNDS; ++round) {
+		for(uint64_t i = 0; i < batch; ++i) {
+			own[i] = timed_malloc(thread, random_size(thread));
+		}
+
+		pthread_barrier_wait(thread->barrier);
 
-	return time_sum / num_threads / 1000.0;
+		for(uint64_t i = 0; i < batch; ++i) {
+			timed_free(thread, other[i]);
+		}
+
+		pthread_barrier_wait(thread->barrier);
+	}
 }
 
-static void run_membench(init_allocator_fn my_init, destroy_allocator_fn my_destroy,
-                         malloc_fn my_malloc, free_fn my_free, bool init_per_thread) {
-	if(!init_per_thread) {
-		my_init(POOL_SIZE, true);
+// -----------------------------------
+//    realloc-growth
+// -----------------------------------
+
+#define GROWTH_ROUNDS 10U
+
+// every thread appends to a few vectors at the same time, they grow from the minimum to the maximum
+// size by 1.5 with realloc, like a std::vector or a string builder
+static void realloc_growth_thread(scenario_thread* thread) {
+	const scenario_config* config = thread->config;
+	void** vectors = calloc(config->allocations, sizeof(void*));
+	uint64_t* sizes = calloc(config->allocations, sizeof(uint64_t));
+	ASSERT(vectors != NULL && sizes != NULL);
+
+	for(uint32_t round = 0; round < GROWTH_ROUNDS; ++round) {
+		for(uint64_t i = 0; i < config->allocations; ++i) {
+			sizes[i] = config->min_size;
+			vectors[i] = timed_malloc(thread, sizes[i]);
+		}
+
+		for(bool growing = true; growing;) {
+			growing = false;
+			for(uint64_t i = 0; i < config->allocations; ++i) {
+				if(sizes[i] >= config->max_size || rand_r(&thread->seed) % 4 == 0) {
+					growing = growing || sizes[i] < config->max_size;
+					continue;
+				}
+
+				const uint64_t old_size = sizes[i];
+				sizes[i] += sizes[i] / 2;
+				if(sizes[i] > config->max_size) {
+					sizes[i] = config->max_size;
+				}
+				vectors[i] = timed_realloc(thread, vectors[i], sizes[i]);
+				memset((char*)vectors[i] + old_size, 0xCD, sizes[i] - old_size);
+				growing = true;
+			}
+		}
+
+		for(uint64_t i = 0; i < config->allocations; ++i) {
+			timed_free(thread, vectors[i]);
+		}
 	}
 
-	const uint64_t configs[][3] = {
-		{ 1, 1000, 256 }, { 10, 1000, 256 }, { 50, 1000, 256 }, { 100, 1000, 32 }
-	};
-	const uint64_t num_configs = sizeof(configs) / sizeof(uint64_t[3]);
-
-	for(uint64_t i = 0; i < num_configs; ++i) {
-		const uint32_t num_threads = configs[i][0];
-		const uint64_t num_allocations = configs[i][1];
-		const uint64_t alloc_size = configs[i][2];
-		thread_context system_ctx = { .num_allocations = num_allocations,
-			                          .alloc_size = alloc_size,
-			                          .my_init = NULL,
-			                          .my_destroy = NULL,
-			                          .my_malloc = malloc,
-			                          .my_free = free };
-		thread_context custom_ctx = { .num_allocations = num_allocations,
-			                          .alloc_size = alloc_size,
-			                          .my_init = init_per_thread ? my_init : NULL,
-			                          .my_destroy = init_per_thread ? my_destroy : NULL,
-			                          .my_malloc = my_malloc,
-			                          .my_free = my_free };
-
-		printf("%" PRIu32 " thread(s), %" PRIu64 " allocations of size %" PRIu64 " - %" PRIu64
-		       " byte per thread. Avg time per "
-		       "thread:\n",
-		       num_threads, num_allocations, alloc_size, alloc_size * MAX_ALLOC_MULTIPLIER);
-		const double system = run_config(num_threads, &system_ctx);
-		printf("\tSystem: %.2lf ms\n", system);
-		const double custom = run_config(num_threads, &custom_ctx);
-		printf("\tCustom: %.2lf ms\n", custom);
-		printf("\tCustom is %.2lf %s than System\n",
-		       system > custom ? system / custom : custom / system,
-		       system > custom ? "faster" : "slower");
+	free(sizes);
+	free(vectors);
+}
+
+// -----------------------------------
+//    fragmentation
+// -----------------------------------
+
+// the lifetimes are at most FRAGMENTATION_WHEEL - 1 steps, a power of two
+#define FRAGMENTATION_WHEEL 4096U
+
+// in every step one object is allocated, with a log-uniform lifetime, the objects, that expire, are
+// freed, the objects are kept in a timing wheel, linked through their first bytes
+static void fragmentation_thread(scenario_thread* thread) {
+	const uint64_t steps = thread->config->allocations;
+	void** wheel = calloc(FRAGMENTATION_WHEEL, sizeof(void*));
+	ASSERT(wheel != NULL);
+
+	for(uint64_t step = 0; step < steps + FRAGMENTATION_WHEEL; ++step) {
+		void** expired = &wheel[step % FRAGMENTATION_WHEEL];
+		while(*expired != NULL) {
+			void* next = *(void**)*expired;
+			timed_free(thread, *expired);
+			*expired = next;
+		}
+
+		// after the last step, only the remaining objects are freed
+		if(step >= steps) {
+			continue;
+		}
+
+		const uint64_t size = random_size(thread);
+		const uint64_t lifetime = log_random(&thread->seed, 1, FRAGMENTATION_WHEEL - 1, false);
+
+		void* ptr = timed_malloc(thread, size);
+		memset(ptr, 0xEF, size);
+
+		void** bucket = &wheel[(step + lifetime) % FRAGMENTATION_WHEEL];
+		*(void**)ptr = *bucket;
+		*bucket = ptr;
+	}
+
+	free(wheel);
+}
+
+// -----------------------------------
+//    chunk-growth
+// -----------------------------------
+
+#define GROWTH_LIVE_OBJECTS 64U
+#define GROWTH_PAGE_SIZE 4096U
+
+static void* chunk_growth_create(const scenario_config* config) {
+	(void)config;
+	_Atomic uint32_t* finished = calloc(1, sizeof(_Atomic uint32_t));
+	ASSERT(finished != NULL);
+	return finished;
+}
+
+// the first thread allocates and frees blocks, that are bigger than the pool size, so the allocator
+// has to map and unmap a new memory block for every one, until the other threads are done, these
+// replace small objects, so their tail latency shows, how long they wait for the mapping, the
+// first thread isn't timed
+static void chunk_growth_thread(scenario_thread* thread) {
+	_Atomic uint32_t* finished = thread->shared;
+
+	if(thread->index == 0) {
+		while(atomic_load_explicit(finished, memory_order_relaxed) + 1 < thread->num_threads) {
+			char* big = thread->allocator->my_malloc(thread->pool_size);
+			ASSERT(big != NULL);
+
+			// every page is touched, so that unmapping it is expensive
+			for(uint64_t offset = 0; offset < thread->pool_size; offset += GROWTH_PAGE_SIZE) {
+				big[offset] = 1;
+			}
+
+			thread->allocator->my_free(big);
+		}
+
+		return;
+	}
+
+	void* objects[GROWTH_LIVE_OBJECTS] = { NULL };
+
+	for(uint64_t i = 0; i < thread->config->allocations; ++i) {
+		void** slot = &objects[(uint32_t)rand_r(&thread->seed) % GROWTH_LIVE_OBJECTS];
+		if(*slot != NULL) {
+			timed_free(thread, *slot);
+		}
+		*slot = timed_malloc(thread, random_size(thread));
+	}
+
+	for(uint32_t i = 0; i < GROWTH_LIVE_OBJECTS; ++i) {
+		if(objects[i] != NULL) {
+			timed_free(thread, objects[i]);
+		}
+	}
+
+	atomic_fetch_add_explicit(finished, 1, memory_order_relaxed);
+}
+
+// -----------------------------------
+//    scenarios
+// -----------------------------------
+
+#define UNIFORM MEMBENCH_DISTRIBUTION_UNIFORM
+#define POWER_LAW MEMBENCH_DISTRIBUTION_POWER_LAW
+#define MULTIPLES MEMBENCH_DISTRIBUTION_MULTIPLES
+
+static const membench_scenario scenarios[] = {
+	{ "phases", "allocate, free ~50%, allocate again, grow with realloc, free all",
+	  "allocations per thread", false, false, false, phases_thread, NULL, 4,
+	  { { 1, 1000, 256, 1024, MULTIPLES },
+	    { 10, 1000, 256, 1024, MULTIPLES },
+	    { 50, 1000, 256, 1024, MULTIPLES },
+	    { 100, 1000, 32, 128, MULTIPLES } } },
+	{ "producer-consumer", "objects are allocated by one thread and freed by another",
+	  "objects per pair", true, false, false, producer_consumer_thread, producer_consumer_create, 2,
+	  { { 2, 20000, 16, 512, UNIFORM }, { 8, 20000, 16, 512, UNIFORM } } },
+	{ "larson", "Larson server simulation, objects are replaced and handed to other threads",
+	  "replacements per round", true, false, false, larson_thread, larson_create, 2,
+	  { { 4, 10000, 16, 128, UNIFORM }, { 8, 10000, 16, 128, UNIFORM } } },
+	{ "ping-pong", "threadtest/xmalloc style, batches are freed by the next thread",
+	  "objects per batch", true, false, false, ping_pong_thread, ping_pong_create, 2,
+	  { { 2, 500, 16, 256, UNIFORM }, { 8, 500, 16, 256, UNIFORM } } },
+	{ "realloc-growth", "vectors grow from the min to the max size by 1.5 with realloc",
+	  "vectors per thread", false, true, false, realloc_growth_thread, NULL, 2,
+	  { { 1, 64, 16, 65536, UNIFORM }, { 8, 64, 16, 65536, UNIFORM } } },
+	{ "fragmentation", "long running, power law sizes and lifetimes", "steps per thread", false,
+	  false, false, fragmentation_thread, NULL, 2,
+	  { { 1, 200000, 16, 65536, POWER_LAW }, { 4, 200000, 16, 65536, POWER_LAW } } },
+	{ "chunk-growth", "small objects are replaced, while one thread maps and unmaps big blocks",
+	  "replacements per thread", false, false, true, chunk_growth_thread, chunk_growth_create,
+	  2,
+	  { { 4, 100000, 16, 256, UNIFORM }, { 8, 100000, 16, 256, UNIFORM } } },
+};
+
+#undef UNIFORM
+#undef POWER_LAW
+#undef MULTIPLES
+
+static const uint64_t num_scenarios = sizeof(scenarios) / sizeof(scenarios[0]);
+
+static bool scenario_selected(const membench_scenario* scenario, const membench_options* options) {
+	return options->scenario == NULL || strcmp(options->scenario, "all") == 0 ||
+	       strcmp(options->scenario, scenario->name) == 0;
+}
+
+// the configurations of the scenario with the options applied, with thread counts from the options,
+// every thread count uses the default configuration with the next smaller or equal thread count,
+// returns the number of configurations
+static uint32_t scenario_configs(const membench_scenario* scenario,
+                                 const membench_options* options, scenario_config* configs) {
+	uint32_t count = scenario->num_defaults;
+
+	if(options->num_thread_counts == 0) {
+		memcpy(configs, scenario->defaults, count * sizeof(scenario_config));
+	} else {
+		count = options->num_thread_counts;
+		for(uint32_t i = 0; i < count; ++i) {
+			configs[i] = scenario->defaults[0];
+			for(uint32_t j = 0; j < scenario->num_defaults; ++j) {
+				if(scenario->defaults[j].threads <= options->thread_counts[i]) {
+					configs[i] = scenario->defaults[j];
+				}
+			}
+			configs[i].threads = options->thread_counts[i];
+		}
 	}
 
-	if(!init_per_thread) {
-		my_destroy();
+	for(uint32_t i = 0; i < count; ++i) {
+		if(options->allocations != 0) {
+			configs[i].allocations = options->allocations;
+		}
+		if(options->min_size != 0) {
+			configs[i].min_size = options->min_size;
+		}
+		if(options->max_size != 0) {
+			configs[i].max_size = options->max_size;
+		}
+		if(options->distribution != MEMBENCH_DISTRIBUTION_DEFAULT) {
+			configs[i].distribution = options->distribution;
+		}
+	}
+
+	return count;
+}
+
+// checks the scenario names and the sizes, before anything is run
+static bool validate_options(const membench_options* options) {
+	bool found = false;
+
+	for(uint64_t i = 0; i < num_scenarios; ++i) {
+		if(!scenario_selected(&scenarios[i], options)) {
+			continue;
+		}
+
+		found = true;
+
+		scenario_config configs[MEMBENCH_MAX_THREAD_COUNTS];
+		const uint32_t count = scenario_configs(&scenarios[i], options, configs);
+
+		for(uint32_t j = 0; j < count; ++j) {
+			// the fragmentation scenario links the objects through their first bytes
+			if(configs[j].min_size < sizeof(void*) || configs[j].min_size > configs[j].max_size) {
+				fprintf(stderr,
+				        "ERROR: %s: the min size has to be at least %zu and not larger than "
+				        "the max size, but they are %" PRIu64 " and %" PRIu64 "\n",
+				        scenarios[i].name, sizeof(void*), configs[j].min_size,
+				        configs[j].max_size);
+				return false;
+			}
+		}
+	}
+
+	if(!found) {
+		fprintf(stderr, "ERROR: Unknown scenario: %s\n", options->scenario);
+	}
+
+	return found;
+}
+
+void membench_default_options(membench_options* options) {
+	*options = (membench_options){ .scenario = NULL,
+		                           .thread_counts = { 0 },
+		                           .num_thread_counts = 0,
+		                           .allocations = 0,
+		                           .min_size = 0,
+		                           .max_size = 0,
+		                           .distribution = MEMBENCH_DISTRIBUTION_DEFAULT,
+		                           .seed = DEFAULT_SEED,
+		                           .repetitions = 1,
+		                           .warmup = 0,
+		                           .pool_size = DEFAULT_POOL_SIZE,
+		                           .format = MEMBENCH_FORMAT_TEXT,
+		                           .perf_counters = true,
+		                           .fixed_pool = false };
+}
+
+// parses a decimal number in [min, max], that ends at a character of terminators or at the end of
+// the string, end is set to that character
+static bool parse_number(const char* value, uint64_t min, uint64_t max, const char* terminators,
+                         uint64_t* result, const char** end) {
+	uint64_t number = 0;
+	const char* current = value;
+
+	for(; *current >= '0' && *current <= '9'; ++current) {
+		const uint64_t digit = (uint64_t)(*current - '0');
+		if(number > (max - digit) / 10) {
+			return false;
+		}
+		number = number * 10 + digit;
+	}
+
+	*result = number;
+	*end = current;
+	return current != value && number >= min &&
+	       (*current == '\0' || strchr(terminators, *current) != NULL);
+}
+
+static bool parse_unsigned(const char* value, uint64_t min, uint64_t max, uint64_t* result) {
+	const char* end;
+	return parse_number(value, min, max, "", result, &end);
+}
+
+static bool parse_thread_counts(const char* value, membench_options* options) {
+	options->num_thread_counts = 0;
+
+	while(true) {
+		uint64_t count;
+		const char* end;
+		if(options->num_thread_counts == MEMBENCH_MAX_THREAD_COUNTS ||
+		   !parse_number(value, 1, 65536, ",", &count, &end)) {
+			return false;
+		}
+
+		options->thread_counts[options->num_thread_counts++] = (uint32_t)count;
+
+		if(*end == '\0') {
+			return true;
+		}
+
+		value = end + 1;
+	}
+}
+
+bool parse_membench_option(const char* argument, membench_options* options) {
+	const char* equals = strchr(argument, '=');
+
+	if(strncmp(argument, "--", 2) != 0 || equals == NULL) {
+		fprintf(stderr, "ERROR: Unknown option: %s\n", argument);
+		return false;
+	}
+
+	const char* name = argument + 2;
+	const size_t name_length = (size_t)(equals - name);
+	const char* value = equals + 1;
+
+	uint64_t number = 0;
+	bool valid = false;
+
+#define OPTION_IS(option) (name_length == strlen(option) && strncmp(name, option, name_length) == 0)
+
+	if(OPTION_IS("scenario")) {
+		options->scenario = value;
+		valid = true;
+	} else if(OPTION_IS("threads")) {
+		valid = parse_thread_counts(value, options);
+	} else if(OPTION_IS("allocations")) {
+		valid = parse_unsigned(value, 1, UINT32_MAX, &number);
+		options->allocations = number;
+	} else if(OPTION_IS("min-size")) {
+		valid = parse_unsigned(value, 1, UINT32_MAX, &number);
+		options->min_size = number;
+	} else if(OPTION_IS("max-size")) {
+		valid = parse_unsigned(value, 1, UINT32_MAX, &number);
+		options->max_size = number;
+	} else if(OPTION_IS("distribution")) {
+		valid = true;
+		if(strcmp(value, "uniform") == 0) {
+			options->distribution = MEMBENCH_DISTRIBUTION_UNIFORM;
+		} else if(strcmp(value, "power-law") == 0) {
+			options->distribution = MEMBENCH_DISTRIBUTION_POWER_LAW;
+		} else if(strcmp(value, "multiples") == 0) {
+			options->distribution = MEMBENCH_DISTRIBUTION_MULTIPLES;
+		} else {
+			valid = false;
+		}
+	} else if(OPTION_IS("seed")) {
+		valid = parse_unsigned(value, 0, UINT32_MAX, &number);
+		options->seed = (unsigned int)number;
+	} else if(OPTION_IS("repetitions")) {
+		valid = parse_unsigned(value, 1, 100000, &number);
+		options->repetitions = (uint32_t)number;
+	} else if(OPTION_IS("warmup")) {
+		valid = parse_unsigned(value, 0, 100000, &number);
+		options->warmup = (uint32_t)number;
+	} else if(OPTION_IS("pool-size")) {
+		valid = parse_unsigned(value, 1, UINT64_MAX, &number);
+		options->pool_size = number;
+	} else if(OPTION_IS("format")) {
+		valid = true;
+		if(strcmp(value, "text") == 0) {
+			options->format = MEMBENCH_FORMAT_TEXT;
+		} else if(strcmp(value, "json") == 0) {
+			options->format = MEMBENCH_FORMAT_JSON;
+		} else if(strcmp(value, "csv") == 0) {
+			options->format = MEMBENCH_FORMAT_CSV;
+		} else {
+			valid = false;
+		}
+	} else if(OPTION_IS("perf-counters")) {
+		valid = true;
+		if(strcmp(value, "on") == 0) {
+			options->perf_counters = true;
+		} else if(strcmp(value, "off") == 0) {
+			options->perf_counters = false;
+		} else {
+			valid = false;
+		}
+	} else {
+		fprintf(stderr, "ERROR: Unknown option: %s\n", argument);
+		return false;
+	}
+
+#undef OPTION_IS
+
+	if(!valid) {
+		fprintf(stderr, "ERROR: Invalid value for --%.*s: %s\n", (int)name_length, name, value);
+	}
+
+	return valid;
+}
+
+void print_membench_usage(void) {
+	printf("\t options:\n"
+	       "\t--scenario=<name>          only run this scenario, default: all\n"
+	       "\t--threads=<n>[,<n>...]     the thread counts, default: per scenario\n"
+	       "\t--allocations=<n>          see the scenarios, default: per scenario\n"
+	       "\t--min-size=<bytes>         the smallest allocation, default: per scenario\n"
+	       "\t--max-size=<bytes>         the largest allocation, default: per scenario\n"
+	       "\t--distribution=<name>      uniform, power-law or multiples, default: per scenario\n"
+	       "\t--seed=<n>                 the seed of the random numbers, default: %u\n"
+	       "\t--repetitions=<n>          the measured runs of every configuration, default: 1\n"
+	       "\t--warmup=<n>               the unmeasured runs before these, default: 0\n"
+	       "\t--pool-size=<bytes>        passed to the init function, default: %" PRIu64 "\n"
+	       "\t--format=<format>          text, json or csv, default: text\n"
+	       "\t--perf-counters=<on|off>   count cycles, cache misses, ... with perf, default: on\n"
+	       "\t scenarios:\n",
+	       DEFAULT_SEED, DEFAULT_POOL_SIZE);
+
+	for(uint64_t i = 0; i < num_scenarios; ++i) {
+		printf("\t%-18s %s\n\t%-18s allocations: %s\n", scenarios[i].name,
+		       scenarios[i].description, "", scenarios[i].allocations_description);
+	}
+}
+
+bool run_membench(init_allocator_fn my_init, destroy_allocator_fn my_destroy, malloc_fn my_malloc,
+                  free_fn my_free, realloc_fn my_realloc, bool init_per_thread,
+                  const membench_options* options) {
+	if(!validate_options(options)) {
+		return false;
+	}
+
+	// the system allocator only uses realloc, if the custom one does too, so they do the same work
+	const allocator_functions allocators[2] = {
+		{ .name = "System",
+		  .my_init = NULL,
+		  .my_destroy = NULL,
+		  .my_malloc = malloc,
+		  .my_free = free,
+		  .my_realloc = my_realloc != NULL ? realloc : NULL },
+		{ .name = "Custom",
+		  .my_init = my_init,
+		  .my_destroy = my_destroy,
+		  .my_malloc = my_malloc,
+		  .my_free = my_free,
+		  .my_realloc = my_realloc },
+	};
+
+	bool first = true;
+
+	print_output_header(options);
+
+	for(uint64_t i = 0; i < num_scenarios; ++i) {
+		const membench_scenario* scenario = &scenarios[i];
+
+		if(!scenario_selected(scenario, options)) {
+			continue;
+		}
+
+		// the text goes to stdout, so that it stays in order with the results, with json and csv,
+		// only the results go there
+		FILE* info = options->format == MEMBENCH_FORMAT_TEXT ? stdout : stderr;
+
+		fprintf(info, "%s (%s):\n", scenario->name, scenario->description);
+
+		if(scenario->cross_thread && init_per_thread) {
+			fprintf(info, "\tskipped, the allocator is thread local\n");
+			continue;
+		}
+
+		if(scenario->needs_realloc && my_realloc == NULL) {
+			fprintf(info, "\tskipped, the allocator has no realloc\n");
+			continue;
+		}
+
+		if(scenario->needs_growth && options->fixed_pool) {
+			fprintf(info, "\tskipped, the allocator can't grow beyond its pool\n");
+			continue;
+		}
+
+		scenario_config configs[MEMBENCH_MAX_THREAD_COUNTS];
+		const uint32_t count = scenario_configs(scenario, options, configs);
+
+		if(!init_per_thread) {
+			my_init(options->pool_size, true);
+		}
+
+		for(uint32_t j = 0; j < count; ++j) {
+			run_config(scenario, &configs[j], allocators, init_per_thread, options, &first);
+		}
+
+		if(!init_per_thread) {
+			my_destroy();
+		}
 	}
+
+	print_output_footer(options);
+
+	return true;
 }
 
 void run_membench_global(init_allocator_fn my_init, destroy_allocator_fn my_destroy,
-                         malloc_fn my_malloc, free_fn my_free) {
-	run_membench(my_init, my_destroy, my_malloc, my_free, false);
+                         malloc_fn my_malloc, free_fn my_free, realloc_fn my_realloc) {
+	membench_options options;
+	membench_default_options(&options);
+	run_membench(my_init, my_destroy, my_malloc, my_free, my_realloc, false, &options);
 }
 
 void run_membench_thread_local(init_allocator_fn my_init, destroy_allocator_fn my_destroy,
-                               malloc_fn my_malloc, free_fn my_free) {
-	run_membench(my_init, my_destroy, my_malloc, my_free, true);
+                               malloc_fn my_malloc, free_fn my_free, realloc_fn my_realloc) {
+	membench_options options;
+	membench_default_options(&options);
+	run_membench(my_init, my_destroy, my_malloc, my_free, my_realloc, true, &options);
 }
@@ -10,13 +10,98 @@ typedef void (*destroy_allocator_fn)(void);
 
 typedef void* (*malloc_fn)(uint64_t);
 typedef void (*free_fn)(void*);
+typedef void* (*realloc_fn)(void*, uint64_t);
+
+typedef enum {
+	MEMBENCH_DISTRIBUTION_DEFAULT = 0,
+	MEMBENCH_DISTRIBUTION_UNIFORM,
+	// every power of two is half as likely as the one before
+	MEMBENCH_DISTRIBUTION_POWER_LAW,
+	// the min size times 1 - max size / min size, the sizes of the original membench
+	MEMBENCH_DISTRIBUTION_MULTIPLES,
+} membench_distribution;
+
+typedef enum {
+	MEMBENCH_FORMAT_TEXT = 0,
+	MEMBENCH_FORMAT_JSON,
+	MEMBENCH_FORMAT_CSV,
+} membench_format;
+
+#define MEMBENCH_MAX_THREAD_COUNTS 16U
+
+// the settings of a benchmark run, 0, NULL and MEMBENCH_DISTRIBUTION_DEFAULT select the defaults of
+// every scenario
+typedef struct {
+	const char* scenario; // NULL or "all" runs all scenarios
+	uint32_t thread_counts[MEMBENCH_MAX_THREAD_COUNTS];
+	uint32_t num_thread_counts;
+	uint64_t allocations; // the meaning depends on the scenario, see print_membench_usage
+	uint64_t min_size;
+	uint64_t max_size;
+	membench_distribution distribution;
+	unsigned int seed;
+	uint32_t repetitions;
+	uint32_t warmup;
+	uint64_t pool_size;
+	membench_format format;
+	// hardware and software counters of every thread, see perf_counters.h
+	bool perf_counters;
+	// the allocator can't map more memory, than the pool size, that is passed to the init function
+	bool fixed_pool;
+} membench_options;
+
+/**
+ * Sets the default options: all scenarios with their default configurations, a fixed seed, one
+ * repetition without warmup and text output.
+ */
+void membench_default_options(membench_options* options);
+
+/**
+ * Parses one command-line argument of the form --<option>=<value> into options, see
+ * print_membench_usage.
+ *
+ * @return false, if the argument isn't a membench option or its value is invalid, then an error is
+ *         printed to stderr.
+ */
+bool parse_membench_option(const char* argument, membench_options* options);
+
+/**
+ * Prints the options, that parse_membench_option accepts, and the name and a description of every
+ * scenario.
+ */
+void print_membench_usage(void);
+
+/**
+ * Runs the multi-threaded benchmark scenario options->scenario, or all of them, comparing the
+ * performance to the system allocator, like run_membench_global.
+ *
+ * Every configuration is run options->warmup times without recording anything and then
+ * options->repetitions times, the mean, the standard deviation and the 95% confidence interval of
+ * the time per thread and of the throughput, and the latency percentiles of all repetitions are
+ * printed in options->format. With options->perf_counters, the cycles, instructions, cache and
+ * dTLB misses, page faults and context switches of the scenario threads are reported per
+ * operation, the counters, that perf_event_open doesn't allow, are left out. The same seed gives
+ * both allocators the same work, and the same work in every run of the program.
+ *
+ * Scenarios, where blocks are freed by other threads, than the one, that allocated them, are
+ * skipped, if init_per_thread is true, scenarios, that need realloc, are skipped, if my_realloc is
+ * NULL, and scenarios, that allocate blocks bigger than the pool, are skipped with
+ * options->fixed_pool.
+ *
+ * @param init_per_thread If the init/destroy functions are called once for each thread, like in
+ *                        run_membench_thread_local, or only once for each scenario.
+ * @return false, if there is no scenario with that name or the sizes are invalid.
+ */
+bool run_membench(init_allocator_fn my_init, destroy_allocator_fn my_destroy, malloc_fn my_malloc,
+                  free_fn my_free, realloc_fn my_realloc, bool init_per_thread,
+                  const membench_options* options);
 
 /**
  * Runs a multi-threaded benchmark for the provided allocation/deallocation
  * functions, comparing performance to the system allocator (malloc/free).
  * Results are printed to stdout.
  *
- * The init/destroy functions are only called once.
+ * The init/destroy functions are only called once per scenario.
  * The provided allocation/deallocation functions are assumed to be thread-safe.
  *
  * @param my_init Initializes the allocator, passing the total amount
@@ -24,15 +109,22 @@ typedef void (*free_fn)(void*);
  * @param my_destroy Destroys the allocator, freeing all reserved memory.
  * @param my_malloc Custom allocation function that mimics malloc() in behavior.
  * @param my_free Custom deallocation function that mimics free() in behavior.
+ * @param my_realloc Custom reallocation function that mimics realloc() in behavior, may be NULL,
+ *                   then the realloc phase is skipped for both allocators.
+ *
+ * Every operation is timed with CLOCK_MONOTONIC, the p50/p90/p99/p99.9/max latencies of malloc,
+ * free and realloc of all threads are printed for both allocators.
+ *
+ * All scenarios are run with the default options, see membench_default_options.
  */
 void run_membench_global(init_allocator_fn my_init, destroy_allocator_fn my_destroy,
-                         malloc_fn my_malloc, free_fn my_free);
+                         malloc_fn my_malloc, free_fn my_free, realloc_fn my_realloc);
 
 /**
  * Same as run_membench_global, except that the init/destroy functions are
  * called once for each thread of the multi-threaded benchmark.
  */
 void run_membench_thread_local(init_allocator_fn my_init, destroy_allocator_fn my_destroy,
-                               malloc_fn my_malloc, free_fn my_free);
+                               malloc_fn my_malloc, free_fn my_free, realloc_fn my_realloc);
 
 #endif
@@ -0,0 +1,458 @@
+/*
+Author: Totto16
+*/
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <time.h>
+#include <unistd.h>
+
+#if defined(__GLIBC__)
+#include <malloc.h>
+#endif
+
+#include <utils.h>
+
+#include <main/my_malloc.h>
+
+#include "process_status.h"
+
+// the pool of my_malloc.c is fixed, so it has to fit the largest workload, the pages are only
+// resident, after they were touched, the allocator with pointers uses it as the size of the first
+// memory block. The allocators search their block lists, so the object counts are kept small
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 64U))
+
+#define SEED 42U
+
+#define MIB(bytes) ((double)(bytes) / (1024.0 * 1024.0))
+
+typedef void* (*malloc_fn)(size_t);
+typedef void (*free_fn)(void*);
+
+typedef struct {
+	const char* name;
+	void (*my_init)(uint64_t, bool);
+	void (*my_destroy)(void);
+	malloc_fn my_malloc;
+	free_fn my_free;
+	// fills the bytes, the allocator holds for allocated blocks (including their headers), and the
+	// bytes, it got from the OS, false if the allocator has no statistics
+	bool (*held_bytes)(uint64_t* in_use, uint64_t* mapped);
+} allocator_functions;
+
+// what one workload run measured, written by the child process into a pipe
+typedef struct {
+	// RSS growth over the RSS before the workload, at the peak and after everything was freed
+	uint64_t peak_rss;
+	uint64_t retained_rss;
+	// the requested bytes, that were allocated at the same time
+	uint64_t peak_live;
+	uint64_t objects_at_peak;
+	// sampled at the checkpoint with the most live bytes, if the allocator has statistics
+	bool has_stats;
+	uint64_t in_use_at_peak;
+	uint64_t mapped_at_peak;
+	double time_ms;
+} efficiency_result;
+
+typedef struct {
+	const allocator_functions* allocator;
+	unsigned int seed;
+	void** ptrs;
+	uint64_t* sizes;
+	uint64_t count;
+	uint64_t live;
+	uint64_t live_objects;
+	efficiency_result result;
+} workload_state;
+
+typedef struct {
+	const char* name;
+	const char* description;
+	void (*fn)(workload_state* state);
+} efficiency_workload;
+
+static uint64_t get_timestamp_ns(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+static bool system_held_bytes(uint64_t* in_use, uint64_t* mapped) {
+#if defined(__GLIBC__) && (__GLIBC__ > 2 || (__GLIBC__ == 2 && __GLIBC_MINOR__ >= 33))
+	const struct mallinfo2 info = mallinfo2();
+	// hblkhd are the blocks, that got their own mmap
+	*in_use = info.uordblks + info.hblkhd;
+	*mapped = info.arena + info.hblkhd;
+	return true;
+#else
+	(void)in_use;
+	(void)mapped;
+	return false;
+#endif
+}
+
+#if defined(_WITH_ALLOCATOR_STATS)
+static bool custom_held_bytes(uint64_t* in_use, uint64_t* mapped) {
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	// everything, that isn't a free block, are allocated blocks and headers
+	*in_use = stats.mapped_bytes - stats.free_bytes;
+	*mapped = stats.mapped_bytes;
+	return true;
+}
+#endif
+
+static void* custom_malloc(size_t size) {
+	return my_malloc(size);
+}
+
+static void custom_free(void* ptr) {
+	my_free(ptr);
+}
+
+static const allocator_functions allocators[] = {
+	{ .name = "System",
+	  .my_init = NULL,
+	  .my_destroy = NULL,
+	  .my_malloc = malloc,
+	  .my_free = free,
+	  .held_bytes = system_held_bytes },
+	{ .name = "Custom",
+	  .my_init = my_allocator_init,
+	  .my_destroy = my_allocator_destroy,
+	  .my_malloc = custom_malloc,
+	  .my_free = custom_free,
+#if defined(_WITH_ALLOCATOR_STATS)
+	  .held_bytes = custom_held_bytes
+#else
+	  .held_bytes = NULL
+#endif
+	},
+};
+
+#define ALLOCATOR_COUNT (sizeof(allocators) / sizeof(*allocators))
+
+// a random value in [min, max], every power of two is half as likely as the one before, so small
+// sizes are the most common ones, like in real programs
+static uint64_t log_random(unsigned int* seed, uint64_t min, uint64_t max) {
+	uint32_t octaves = 0;
+	while((min << octaves) <= max / 2) {
+		++octaves;
+	}
+
+	uint32_t octave = 0;
+	while(octave < octaves && rand_r(seed) % 2 == 0) {
+		++octave;
+	}
+
+	const uint64_t lower = min << octave;
+	const uint64_t upper = octave == octaves ? max : (lower * 2) - 1;
+	return lower + (uint64_t)rand_r(seed) % (upper - lower + 1);
+}
+
+static uint64_t uniform_random(unsigned int* seed, uint64_t min, uint64_t max) {
+	return min + (uint64_t)rand_r(seed) % (max - min + 1);
+}
+
+static void allocate_slot(workload_state* state, uint64_t slot, uint64_t size) {
+	void* ptr = state->allocator->my_malloc(size);
+	if(ptr == NULL) {
+		printErrorAndExit("ERROR: %s is out of memory, allocating %" PRIu64 " bytes\n",
+		                  state->allocator->name, size);
+	}
+	// touch every page, like a program, that uses the memory, the first and the last byte are
+	// enough for the small sizes
+	for(uint64_t offset = 0; offset < size; offset += 4096) {
+		((volatile char*)ptr)[offset] = 1;
+	}
+	((volatile char*)ptr)[size - 1] = 1;
+
+	state->ptrs[slot] = ptr;
+	state->sizes[slot] = size;
+	state->live += size;
+	++state->live_objects;
+}
+
+static void free_slot(workload_state* state, uint64_t slot) {
+	if(state->ptrs[slot] == NULL) {
+		return;
+	}
+	state->allocator->my_free(state->ptrs[slot]);
+	state->live -= state->sizes[slot];
+	--state->live_objects;
+	state->ptrs[slot] = NULL;
+	state->sizes[slot] = 0;
+}
+
+// called at the (local) peaks of a workload, the statistics are only sampled here, since they walk
+// the whole heap
+static void checkpoint(workload_state* state) {
+	if(state->live <= state->result.peak_live) {
+		return;
+	}
+
+	state->result.peak_live = state->live;
+	state->result.objects_at_peak = state->live_objects;
+	if(state->allocator->held_bytes != NULL) {
+		state->result.has_stats = state->allocator->held_bytes(&state->result.in_use_at_peak,
+		                                                       &state->result.mapped_at_peak);
+	}
+}
+
+static void free_all(workload_state* state) {
+	for(uint64_t i = 0; i < state->count; ++i) {
+		free_slot(state, i);
+	}
+}
+
+// many small objects, where the header is large compared to the object
+static void workload_small_objects(workload_state* state) {
+	for(uint64_t i = 0; i < state->count; ++i) {
+		allocate_slot(state, i, uniform_random(&state->seed, 16, 64));
+	}
+	checkpoint(state);
+	free_all(state);
+}
+
+// random sizes, half of them are freed and allocated again, like the phases scenario of membench
+static void workload_mixed(workload_state* state) {
+	for(uint64_t i = 0; i < state->count; ++i) {
+		allocate_slot(state, i, log_random(&state->seed, 16, 4096));
+	}
+	checkpoint(state);
+
+	for(uint64_t i = 0; i < state->count; ++i) {
+		if(rand_r(&state->seed) % 2 == 0) {
+			free_slot(state, i);
+		}
+	}
+	for(uint64_t i = 0; i < state->count; ++i) {
+		if(state->ptrs[i] == NULL) {
+			allocate_slot(state, i, log_random(&state->seed, 16, 4096));
+		}
+	}
+	checkpoint(state);
+	free_all(state);
+}
+
+// objects, that span many pages, so the RSS is dominated by the payload
+static void workload_large_objects(workload_state* state) {
+	for(uint64_t i = 0; i < state->count; ++i) {
+		allocate_slot(state, i, uniform_random(&state->seed, 64 * 1024, 512 * 1024));
+	}
+	checkpoint(state);
+	free_all(state);
+}
+
+// small objects, of which only every 16th survives, then larger objects are allocated, that don't
+// fit into the holes, so the RSS of the holes can't be reused
+static void workload_fragmentation(workload_state* state) {
+	const uint64_t small_count = state->count - (state->count / 8);
+	for(uint64_t i = 0; i < small_count; ++i) {
+		allocate_slot(state, i, log_random(&state->seed, 16, 512));
+	}
+	checkpoint(state);
+
+	for(uint64_t i = 0; i < small_count; ++i) {
+		if(i % 16 != 0) {
+			free_slot(state, i);
+		}
+	}
+
+	for(uint64_t i = small_count; i < state->count; ++i) {
+		allocate_slot(state, i, uniform_random(&state->seed, 2048, 8192));
+	}
+	checkpoint(state);
+	free_all(state);
+}
+
+// a fixed number of live objects, random ones are replaced with objects of a random size, so the
+// heap has to reuse freed memory for a long time
+static void workload_churn(workload_state* state) {
+	for(uint64_t i = 0; i < state->count; ++i) {
+		allocate_slot(state, i, log_random(&state->seed, 16, 16384));
+	}
+	checkpoint(state);
+
+	const uint64_t replacements = state->count * 10;
+	for(uint64_t i = 0; i < replacements; ++i) {
+		const uint64_t slot = (uint64_t)rand_r(&state->seed) % state->count;
+		free_slot(state, slot);
+		allocate_slot(state, slot, log_random(&state->seed, 16, 16384));
+
+		if(i % state->count == 0) {
+			checkpoint(state);
+		}
+	}
+	checkpoint(state);
+	free_all(state);
+}
+
+typedef struct {
+	efficiency_workload workload;
+	uint64_t count;
+} workload_entry;
+
+static const workload_entry workloads[] = {
+	{ { "small-objects", "allocates small objects (16 - 64 bytes)", workload_small_objects },
+	  20000 },
+	{ { "mixed", "random sizes (16 - 4096 bytes), half of them are replaced", workload_mixed },
+	  10000 },
+	{ { "large-objects", "large objects (64 KiB - 512 KiB)", workload_large_objects }, 100 },
+	{ { "fragmentation", "keeps every 16th small object, then allocates larger ones",
+	    workload_fragmentation },
+	  10000 },
+	{ { "churn", "replaces random objects of a fixed set (16 - 16384 bytes)", workload_churn },
+	  2000 },
+};
+
+#define WORKLOAD_COUNT (sizeof(workloads) / sizeof(*workloads))
+
+// runs in the forked child, so that the RSS isn't influenced by the previous runs
+static efficiency_result run_workload(const workload_entry* entry,
+                                      const allocator_functions* allocator) {
+	workload_state state = { .allocator = allocator, .seed = SEED, .count = entry->count };
+	state.ptrs = mallocOrFail(entry->count * sizeof(void*), true);
+	state.sizes = mallocOrFail(entry->count * sizeof(uint64_t), true);
+
+	if(allocator->my_init != NULL) {
+		allocator->my_init(POOL_SIZE, false);
+	}
+
+	const uint64_t rss_before = read_status_kib("VmRSS:");
+	reset_peak_rss();
+	const uint64_t start = get_timestamp_ns();
+
+	entry->workload.fn(&state);
+
+	state.result.time_ms = (double)(get_timestamp_ns() - start) / 1000000.0;
+	const uint64_t peak_rss = read_status_kib("VmHWM:");
+	const uint64_t rss_after = read_status_kib("VmRSS:");
+
+	state.result.peak_rss = peak_rss > rss_before ? (peak_rss - rss_before) * 1024 : 0;
+	state.result.retained_rss = rss_after > rss_before ? (rss_after - rss_before) * 1024 : 0;
+
+	if(allocator->my_destroy != NULL) {
+		allocator->my_destroy();
+	}
+
+	free(state.ptrs);
+	free(state.sizes);
+	return state.result;
+}
+
+// returns false, if the workload failed, e.g. since the fixed pool of my_malloc.c has no block,
+// that fits
+static bool run_in_child(const workload_entry* entry, const allocator_functions* allocator,
+                         efficiency_result* parent_result) {
+	int fds[2];
+	int result = pipe(fds);
+	checkResultForErrorAndExit("ERROR: Couldn't create a pipe");
+
+	const pid_t pid = fork();
+	checkForError(pid, "ERROR: Couldn't fork", exit(EXIT_FAILURE););
+
+	if(pid == 0) {
+		close(fds[0]);
+		// the result is reported through the pipe, the warnings of the allocators would only mix
+		// into the table
+		int null_fd = open("/dev/null", O_WRONLY);
+		if(null_fd >= 0) {
+			dup2(null_fd, STDOUT_FILENO);
+			close(null_fd);
+		}
+		const efficiency_result child_result = run_workload(entry, allocator);
+		if(write(fds[1], &child_result, sizeof(child_result)) != sizeof(child_result)) {
+			_exit(EXIT_FAILURE);
+		}
+		close(fds[1]);
+		_exit(EXIT_SUCCESS);
+	}
+
+	close(fds[1]);
+	const ssize_t bytes_read = read(fds[0], parent_result, sizeof(*parent_result));
+	close(fds[0]);
+
+	int status = 0;
+	waitpid(pid, &status, 0);
+	return bytes_read == sizeof(*parent_result) && WIFEXITED(status) &&
+	       WEXITSTATUS(status) == EXIT_SUCCESS;
+}
+
+static void print_result(const allocator_functions* allocator, const efficiency_result* result) {
+	const double efficiency =
+	    result->peak_rss == 0 ? 0.0 : (double)result->peak_live / (double)result->peak_rss;
+
+	printf("\t%s: peak RSS %.1f MiB, live/RSS %.2f, retained RSS %.1f MiB, %.1f ms\n",
+	       allocator->name, MIB(result->peak_rss), efficiency, MIB(result->retained_rss),
+	       result->time_ms);
+
+	if(result->has_stats) {
+		const uint64_t overhead = result->in_use_at_peak > result->peak_live
+		                              ? result->in_use_at_peak - result->peak_live
+		                              : 0;
+		printf("\t\tmapped %.1f MiB, metadata and rounding %.1f MiB (%.1f bytes per object, "
+		       "%.1f%% of live)\n",
+		       MIB(result->mapped_at_peak), MIB(overhead),
+		       (double)overhead / (double)result->objects_at_peak,
+		       (double)overhead * 100.0 / (double)result->peak_live);
+	}
+}
+
+// prints the usage, if argc is not the right amount!
+void printUsage(const char* programName) {
+	printf("usage: %s [workload]\n\t workload: one of", programName);
+	for(size_t i = 0; i < WORKLOAD_COUNT; ++i) {
+		printf(" %s", workloads[i].workload.name);
+	}
+	printf(", default: all\n");
+}
+
+// this main compares the peak RSS, the live bytes per RSS and the metadata overhead of the system
+// allocator and this one, every workload runs in its own process
+int main(int argc, char const* argv[]) {
+
+	if(argc > 2) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	bool found = false;
+	for(size_t i = 0; i < WORKLOAD_COUNT; ++i) {
+		const workload_entry* entry = &workloads[i];
+		if(argc == 2 && strcmp(argv[1], entry->workload.name) != 0) {
+			continue;
+		}
+		found = true;
+
+		printf("%s: %s, %" PRIu64 " objects\n", entry->workload.name, entry->workload.description,
+		       entry->count);
+		for(size_t j = 0; j < ALLOCATOR_COUNT; ++j) {
+			efficiency_result result;
+			if(!run_in_child(entry, &allocators[j], &result)) {
+				printf("\t%s: failed\n", allocators[j].name);
+				continue;
+			}
+			if(j == 0) {
+				printf("\tpeak live %.1f MiB\n", MIB(result.peak_live));
+			}
+			print_result(&allocators[j], &result);
+		}
+		fflush(stdout);
+	}
+
+	if(!found) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,131 @@
+#include <errno.h>
+#include <linux/perf_event.h>
+#include <stdatomic.h>
+#include <stdio.h>
+#include <string.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+
+#include "perf_counters.h"
+
+const char* const perf_counter_names[PERF_COUNTER_COUNT] = {
+	"cycles",     "instructions", "l1d_misses",      "llc_misses",
+	"dtlb_misses", "page_faults", "context_switches",
+};
+
+#define CACHE_READ_MISS(cache) \
+	((cache) | (PERF_COUNT_HW_CACHE_OP_READ << 8U) | (PERF_COUNT_HW_CACHE_RESULT_MISS << 16U))
+
+static const struct {
+	uint32_t type;
+	uint64_t config;
+} perf_counter_events[PERF_COUNTER_COUNT] = {
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CPU_CYCLES },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_INSTRUCTIONS },
+	{ PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_L1D) },
+	{ PERF_TYPE_HARDWARE, PERF_COUNT_HW_CACHE_MISSES },
+	{ PERF_TYPE_HW_CACHE, CACHE_READ_MISS(PERF_COUNT_HW_CACHE_DTLB) },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_PAGE_FAULTS },
+	{ PERF_TYPE_SOFTWARE, PERF_COUNT_SW_CONTEXT_SWITCHES },
+};
+
+// only the first failure is reported, not one for every thread and every counter
+static atomic_flag warning_printed = ATOMIC_FLAG_INIT;
+
+static int open_event(uint32_t type, uint64_t config, bool exclude_kernel) {
+	struct perf_event_attr attr;
+	memset(&attr, 0, sizeof(attr));
+	attr.size = sizeof(attr);
+	attr.type = type;
+	attr.config = config;
+	attr.disabled = 1;
+	attr.exclude_kernel = exclude_kernel ? 1 : 0;
+	attr.exclude_hv = 1;
+	attr.read_format = PERF_FORMAT_TOTAL_TIME_ENABLED | PERF_FORMAT_TOTAL_TIME_RUNNING;
+
+	// the calling thread, on any cpu, there is no glibc wrapper
+	return (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+}
+
+void perf_counters_open(perf_counters* counters) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		int fd = open_event(perf_counter_events[i].type, perf_counter_events[i].config, false);
+		if(fd < 0 && (errno == EACCES || errno == EPERM)) {
+			// perf_event_paranoid >= 2 only allows to count user space
+			fd = open_event(perf_counter_events[i].type, perf_counter_events[i].config, true);
+		}
+
+		if(fd < 0 && !atomic_flag_test_and_set(&warning_printed)) {
+			fprintf(stderr,
+			        "WARNING: The perf counter %s isn't available (%s), the unavailable counters "
+			        "aren't reported\n",
+			        perf_counter_names[i], strerror(errno));
+		}
+
+		counters->fds[i] = fd;
+	}
+}
+
+void perf_counters_start(perf_counters* counters) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		if(counters->fds[i] >= 0) {
+			ioctl(counters->fds[i], PERF_EVENT_IOC_RESET, 0);
+			ioctl(counters->fds[i], PERF_EVENT_IOC_ENABLE, 0);
+		}
+	}
+}
+
+void perf_counters_stop(perf_counters* counters, perf_counter_values* values) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		if(counters->fds[i] >= 0) {
+			ioctl(counters->fds[i], PERF_EVENT_IOC_DISABLE, 0);
+		}
+	}
+
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		values->values[i] = 0;
+		values->available[i] = false;
+
+		if(counters->fds[i] < 0) {
+			continue;
+		}
+
+		// value, time enabled, time running
+		uint64_t data[3];
+		if(read(counters->fds[i], data, sizeof(data)) != sizeof(data)) {
+			continue;
+		}
+
+		values->available[i] = true;
+		if(data[2] != 0 && data[2] < data[1]) {
+			// the counter was multiplexed with others, so it only counted a part of the time
+			values->values[i] = (uint64_t)((double)data[0] * (double)data[1] / (double)data[2]);
+		} else {
+			values->values[i] = data[0];
+		}
+	}
+}
+
+void perf_counters_close(perf_counters* counters) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		if(counters->fds[i] >= 0) {
+			close(counters->fds[i]);
+			counters->fds[i] = -1;
+		}
+	}
+}
+
+void perf_counter_values_init(perf_counter_values* values) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		values->values[i] = 0;
+		values->available[i] = true;
+	}
+}
+
+void perf_counter_values_add(perf_counter_values* target, const perf_counter_values* source) {
+	for(uint32_t i = 0; i < PERF_COUNTER_COUNT; ++i) {
+		target->values[i] += source->values[i];
+		target->available[i] = target->available[i] && source->available[i];
+	}
+}
@@ -0,0 +1,56 @@
+#ifndef PERF_COUNTERS_H
+#define PERF_COUNTERS_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef enum {
+	PERF_COUNTER_CYCLES = 0,
+	PERF_COUNTER_INSTRUCTIONS,
+	PERF_COUNTER_L1D_MISSES,
+	PERF_COUNTER_LLC_MISSES,
+	PERF_COUNTER_DTLB_MISSES,
+	PERF_COUNTER_PAGE_FAULTS,
+	PERF_COUNTER_CONTEXT_SWITCHES,
+	PERF_COUNTER_COUNT,
+} perf_counter_kind;
+
+// the names, that are used in the output, e.g. "l1d_misses"
+extern const char* const perf_counter_names[PERF_COUNTER_COUNT];
+
+// the counters of the calling thread, a counter, that couldn't be opened, has fd -1
+typedef struct {
+	int fds[PERF_COUNTER_COUNT];
+} perf_counters;
+
+// the counted events, available is false, if the counter couldn't be opened (in one of the threads)
+typedef struct {
+	uint64_t values[PERF_COUNTER_COUNT];
+	bool available[PERF_COUNTER_COUNT];
+} perf_counter_values;
+
+/**
+ * Opens the counters for the calling thread, disabled, only the user space part is counted, if the
+ * kernel isn't allowed (perf_event_paranoid). Counters, that aren't supported or permitted, are
+ * left out, the first time that happens, a warning is printed to stderr.
+ */
+void perf_counters_open(perf_counters* counters);
+
+// resets and enables the counters
+void perf_counters_start(perf_counters* counters);
+
+/**
+ * Disables the counters and stores the counted events in values, scaled up, if the kernel had to
+ * multiplex them.
+ */
+void perf_counters_stop(perf_counters* counters, perf_counter_values* values);
+
+void perf_counters_close(perf_counters* counters);
+
+// sets every counter to 0 and available
+void perf_counter_values_init(perf_counter_values* values);
+
+// adds the values of source to target, a counter is only available, if it is in both
+void perf_counter_values_add(perf_counter_values* target, const perf_counter_values* source);
+
+#endif
@@ -0,0 +1,38 @@
+#include <fcntl.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <unistd.h>
+
+#include "process_status.h"
+
+uint64_t read_status_kib(const char* key) {
+	FILE* file = fopen("/proc/self/status", "r");
+	if(file == NULL) {
+		return 0;
+	}
+
+	char line[256];
+	uint64_t value = 0;
+	const size_t key_length = strlen(key);
+
+	while(fgets(line, sizeof(line), file) != NULL) {
+		if(strncmp(line, key, key_length) == 0) {
+			value = strtoull(line + key_length, NULL, 10);
+			break;
+		}
+	}
+
+	fclose(file);
+	return value;
+}
+
+void reset_peak_rss(void) {
+	int fd = open("/proc/self/clear_refs", O_WRONLY);
+	if(fd >= 0) {
+		if(write(fd, "5", 1) != 1) {
+			perror("WARNING: Couldn't reset the peak RSS");
+		}
+		close(fd);
+	}
+}
@@ -0,0 +1,12 @@
+#ifndef PROCESS_STATUS_H
+#define PROCESS_STATUS_H
+
+#include <stdint.h>
+
+// reads a value in KiB from /proc/self/status, e.g. "VmHWM:", 0 if it isn't available
+uint64_t read_status_kib(const char* key);
+
+// resets VmHWM to the current RSS, this is supported since Linux 4.0
+void reset_peak_rss(void);
+
+#endif
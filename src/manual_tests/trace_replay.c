@@ -0,0 +1,483 @@
+#include <fcntl.h>
+#include <inttypes.h>
+#include <pthread.h>
+#include <sched.h>
+#include <stdatomic.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <time.h>
+#include <unistd.h>
+
+#include <trace_format.h>
+
+#include "process_status.h"
+#include "trace_replay.h"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 64U))
+
+#define NO_OBJECT UINT64_MAX
+
+typedef struct {
+	uint8_t operation;
+	uint64_t size;
+	// the object, that is allocated (or freed, for TRACE_FREE)
+	uint64_t object;
+	// the reallocated object, NO_OBJECT if it was allocated before the trace started
+	uint64_t old_object;
+} replay_operation;
+
+struct trace_replay {
+	uint64_t num_operations;
+	replay_operation* operations; // in the recorded global order
+	uint64_t num_objects;
+	uint64_t* object_sizes;
+	uint64_t peak_live_bytes;
+	uint32_t num_recorded_threads;
+	uint32_t num_threads;
+	// the operations of thread i are thread_operations[thread_offsets[i]..thread_offsets[i + 1]]
+	uint64_t* thread_offsets;
+	uint64_t* thread_operations;
+};
+
+typedef struct {
+	uint64_t ptr; // 0 if this slot is empty
+	uint64_t object;
+} address_entry;
+
+typedef struct {
+	const trace_replay* replay;
+	uint32_t thread;
+	malloc_fn my_malloc;
+	free_fn my_free;
+	realloc_fn my_realloc;
+	_Atomic(void*)* objects;
+	uint32_t* latencies;
+	pthread_barrier_t* barrier;
+} replay_context;
+
+static void* checked_calloc(size_t count, size_t size) {
+	void* result = calloc(count, size);
+	if(result == NULL) {
+		fprintf(stderr, "ERROR: Couldn't allocate memory for the trace replay!\n");
+		exit(EXIT_FAILURE);
+	}
+	return result;
+}
+
+static uint64_t get_timestamp_ns(void) {
+	struct timespec time;
+	clock_gettime(CLOCK_MONOTONIC, &time);
+	return (uint64_t)time.tv_sec * 1000000000ULL + (uint64_t)time.tv_nsec;
+}
+
+// the records are sorted by their timestamps, the records of one thread are in file order, so
+// that is used for equal timestamps
+static const TraceRecord* sort_records;
+
+static int compare_records(const void* first, const void* second) {
+	const uint64_t first_index = *(const uint64_t*)first;
+	const uint64_t second_index = *(const uint64_t*)second;
+	const uint64_t first_time = sort_records[first_index].timestamp;
+	const uint64_t second_time = sort_records[second_index].timestamp;
+
+	if(first_time != second_time) {
+		return first_time < second_time ? -1 : 1;
+	}
+
+	return first_index < second_index ? -1 : (first_index > second_index ? 1 : 0);
+}
+
+static address_entry* find_address(address_entry* table, uint64_t mask, uint64_t ptr) {
+	uint64_t slot = ((ptr >> 4) * 0x9E3779B97F4A7C15ULL) & mask;
+
+	while(table[slot].ptr != 0 && table[slot].ptr != ptr) {
+		slot = (slot + 1) & mask;
+	}
+
+	return &table[slot];
+}
+
+trace_replay* load_trace_replay(const char* path, uint32_t num_threads) {
+	int fd = open(path, O_RDONLY);
+	struct stat file_stat;
+
+	if(fd < 0 || fstat(fd, &file_stat) != 0) {
+		perror("ERROR: Couldn't open the trace");
+		exit(EXIT_FAILURE);
+	}
+
+	const uint64_t file_size = (uint64_t)file_stat.st_size;
+
+	if(file_size < sizeof(TraceFileHeader)) {
+		fprintf(stderr, "ERROR: '%s' is not an allocation trace!\n", path);
+		exit(EXIT_FAILURE);
+	}
+
+	void* mapped = mmap(NULL, file_size, PROT_READ, MAP_PRIVATE, fd, 0);
+	close(fd);
+
+	if(mapped == MAP_FAILED) {
+		perror("ERROR: Couldn't map the trace");
+		exit(EXIT_FAILURE);
+	}
+
+	const TraceFileHeader* header = mapped;
+
+	if(header->magic != TRACE_MAGIC || header->version != TRACE_VERSION ||
+	   header->recordSize != sizeof(TraceRecord) || header->dataOffset > file_size) {
+		fprintf(stderr, "ERROR: '%s' is not an allocation trace of version %d!\n", path,
+		        TRACE_VERSION);
+		exit(EXIT_FAILURE);
+	}
+
+	const TraceRecord* records = (const TraceRecord*)((const char*)mapped + header->dataOffset);
+	const uint64_t num_slots = (file_size - header->dataOffset) / sizeof(TraceRecord);
+
+	uint64_t num_records = 0;
+	uint64_t* order = checked_calloc(num_slots + 1, sizeof(uint64_t));
+
+	for(uint64_t i = 0; i < num_slots; ++i) {
+		if(records[i].operation != TRACE_NONE) {
+			order[num_records++] = i;
+		}
+	}
+
+	sort_records = records;
+	qsort(order, num_records, sizeof(uint64_t), compare_records);
+
+	trace_replay* replay = checked_calloc(1, sizeof(trace_replay));
+	replay->operations = checked_calloc(num_records + 1, sizeof(replay_operation));
+	replay->object_sizes = checked_calloc(num_records + 1, sizeof(uint64_t));
+
+	uint32_t* operation_threads = checked_calloc(num_records + 1, sizeof(uint32_t));
+
+	uint64_t mask = 1;
+	while(mask < num_records * 2) {
+		mask <<= 1;
+	}
+	address_entry* addresses = checked_calloc(mask, sizeof(address_entry));
+	mask -= 1;
+
+	uint32_t* recorded_threads = NULL;
+	uint32_t recorded_threads_capacity = 0;
+
+	// the old objects of the reallocs, that started, but whose TRACE_REALLOC wasn't read yet, at
+	// most one per thread
+	uint32_t* pending_threads = checked_calloc(num_records + 1, sizeof(uint32_t));
+	uint64_t* pending_objects = checked_calloc(num_records + 1, sizeof(uint64_t));
+	uint64_t num_pending = 0;
+
+	uint64_t live_bytes = 0;
+
+	for(uint64_t i = 0; i < num_records; ++i) {
+		const TraceRecord* record = &records[order[i]];
+		replay_operation operation = { .operation = record->operation,
+			                           .size = record->size == 0 ? 1 : record->size,
+			                           .object = NO_OBJECT,
+			                           .old_object = NO_OBJECT };
+
+		switch(record->operation) {
+			case TRACE_MALLOC:
+			case TRACE_MEMALIGN:
+			case TRACE_REALLOC: {
+				if(record->operation == TRACE_REALLOC) {
+					for(uint64_t j = 0; j < num_pending; ++j) {
+						if(pending_threads[j] == record->thread) {
+							operation.old_object = pending_objects[j];
+							--num_pending;
+							pending_threads[j] = pending_threads[num_pending];
+							pending_objects[j] = pending_objects[num_pending];
+							break;
+						}
+					}
+				}
+
+				// failed allocations aren't replayed, the old block of a failed realloc is still
+				// allocated
+				if(record->ptr == 0) {
+					if(operation.old_object != NO_OBJECT) {
+						address_entry* old_entry = find_address(addresses, mask, record->argument);
+						old_entry->ptr = record->argument;
+						old_entry->object = operation.old_object;
+					}
+					continue;
+				}
+
+				if(operation.old_object != NO_OBJECT) {
+					live_bytes -= replay->object_sizes[operation.old_object];
+				}
+
+				operation.object = replay->num_objects++;
+				replay->object_sizes[operation.object] = operation.size;
+
+				address_entry* entry = find_address(addresses, mask, record->ptr);
+				entry->ptr = record->ptr;
+				entry->object = operation.object;
+
+				live_bytes += operation.size;
+				if(live_bytes > replay->peak_live_bytes) {
+					replay->peak_live_bytes = live_bytes;
+				}
+				break;
+			}
+			case TRACE_REALLOC_OLD: {
+				address_entry* entry = find_address(addresses, mask, record->ptr);
+
+				// the address may be reused by another thread, before the TRACE_REALLOC follows
+				if(entry->ptr != 0 && entry->object != NO_OBJECT) {
+					pending_threads[num_pending] = record->thread;
+					pending_objects[num_pending++] = entry->object;
+					entry->object = NO_OBJECT;
+				}
+				continue;
+			}
+			case TRACE_FREE: {
+				address_entry* entry = find_address(addresses, mask, record->ptr);
+
+				// allocated before the trace started
+				if(entry->ptr == 0 || entry->object == NO_OBJECT) {
+					continue;
+				}
+
+				operation.object = entry->object;
+				entry->object = NO_OBJECT;
+				live_bytes -= replay->object_sizes[operation.object];
+				break;
+			}
+			default: {
+				fprintf(stderr, "ERROR: Unknown operation %d in the trace!\n", record->operation);
+				exit(EXIT_FAILURE);
+			}
+		}
+
+		uint32_t thread = 0;
+		while(thread < replay->num_recorded_threads &&
+		      recorded_threads[thread] != record->thread) {
+			++thread;
+		}
+
+		if(thread == replay->num_recorded_threads) {
+			if(thread == recorded_threads_capacity) {
+				recorded_threads_capacity =
+				    recorded_threads_capacity == 0 ? 16 : recorded_threads_capacity * 2;
+				recorded_threads =
+				    realloc(recorded_threads, recorded_threads_capacity * sizeof(uint32_t));
+				if(recorded_threads == NULL) {
+					fprintf(stderr, "ERROR: Couldn't allocate memory for the trace replay!\n");
+					exit(EXIT_FAILURE);
+				}
+			}
+			recorded_threads[replay->num_recorded_threads++] = record->thread;
+		}
+
+		operation_threads[replay->num_operations] = thread;
+		replay->operations[replay->num_operations++] = operation;
+	}
+
+	const bool use_recorded_threads =
+	    num_threads == 0 || num_threads > replay->num_recorded_threads;
+	replay->num_threads = use_recorded_threads ? replay->num_recorded_threads : num_threads;
+
+	// the operations of every replay thread, in the global order
+	replay->thread_offsets = checked_calloc(replay->num_threads + 1, sizeof(uint64_t));
+	replay->thread_operations = checked_calloc(replay->num_operations + 1, sizeof(uint64_t));
+
+	for(uint64_t i = 0; i < replay->num_operations; ++i) {
+		operation_threads[i] %= replay->num_threads;
+		replay->thread_offsets[operation_threads[i] + 1]++;
+	}
+
+	for(uint32_t i = 0; i < replay->num_threads; ++i) {
+		replay->thread_offsets[i + 1] += replay->thread_offsets[i];
+	}
+
+	uint64_t* positions = checked_calloc(replay->num_threads + 1, sizeof(uint64_t));
+	memcpy(positions, replay->thread_offsets, replay->num_threads * sizeof(uint64_t));
+
+	for(uint64_t i = 0; i < replay->num_operations; ++i) {
+		replay->thread_operations[positions[operation_threads[i]]++] = i;
+	}
+
+	printf("Loaded %" PRIu64 " operations of %" PRIu32 " threads, replaying them on %" PRIu32
+	       " threads, peak live bytes %" PRIu64 "\n",
+	       replay->num_operations, replay->num_recorded_threads, replay->num_threads,
+	       replay->peak_live_bytes);
+
+	free(positions);
+	free(pending_threads);
+	free(pending_objects);
+	free(recorded_threads);
+	free(addresses);
+	free(operation_threads);
+	free(order);
+	munmap(mapped, file_size);
+
+	return replay;
+}
+
+void free_trace_replay(trace_replay* replay) {
+	free(replay->operations);
+	free(replay->object_sizes);
+	free(replay->thread_offsets);
+	free(replay->thread_operations);
+	free(replay);
+}
+
+static void* replay_thread_fn(void* arg) {
+	replay_context* ctx = arg;
+	const trace_replay* replay = ctx->replay;
+
+	pthread_barrier_wait(ctx->barrier);
+
+	for(uint64_t i = replay->thread_offsets[ctx->thread];
+	    i < replay->thread_offsets[ctx->thread + 1]; ++i) {
+		const uint64_t index = replay->thread_operations[i];
+		const replay_operation* operation = &replay->operations[index];
+
+		// a block of another thread may not be allocated yet, that isn't part of the latency
+		void* old = NULL;
+		const uint64_t old_object =
+		    operation->operation == TRACE_FREE ? operation->object : operation->old_object;
+
+		if(old_object != NO_OBJECT) {
+			while((old = atomic_load_explicit(&ctx->objects[old_object], memory_order_acquire)) ==
+			      NULL) {
+				sched_yield();
+			}
+			atomic_store_explicit(&ctx->objects[old_object], NULL, memory_order_relaxed);
+		}
+
+		void* result = NULL;
+
+		const uint64_t before = get_timestamp_ns();
+
+		if(operation->operation == TRACE_FREE) {
+			ctx->my_free(old);
+		} else if(operation->operation != TRACE_REALLOC || old == NULL) {
+			result = ctx->my_malloc(operation->size);
+		} else if(ctx->my_realloc != NULL) {
+			result = ctx->my_realloc(old, operation->size);
+		} else {
+			result = ctx->my_malloc(operation->size);
+			if(result != NULL) {
+				const uint64_t old_size = replay->object_sizes[old_object];
+				memcpy(result, old, old_size < operation->size ? old_size : operation->size);
+				ctx->my_free(old);
+			}
+		}
+
+		const uint64_t after = get_timestamp_ns();
+
+		const uint64_t latency = after - before;
+		ctx->latencies[index] = latency > UINT32_MAX ? UINT32_MAX : (uint32_t)latency;
+
+		if(operation->operation != TRACE_FREE) {
+			if(result == NULL) {
+				fprintf(stderr, "ERROR: The allocator ran out of memory in the trace replay!\n");
+				exit(EXIT_FAILURE);
+			}
+
+			// the memory is used, so that it counts to the RSS
+			memset(result, 0xAB, operation->size);
+			atomic_store_explicit(&ctx->objects[operation->object], result, memory_order_release);
+		}
+	}
+
+	return NULL;
+}
+
+static int compare_latencies(const void* first, const void* second) {
+	const uint32_t first_value = *(const uint32_t*)first;
+	const uint32_t second_value = *(const uint32_t*)second;
+	return first_value < second_value ? -1 : (first_value > second_value ? 1 : 0);
+}
+
+void run_trace_replay(const trace_replay* replay, const char* name, init_allocator_fn my_init,
+                      destroy_allocator_fn my_destroy, malloc_fn my_malloc, free_fn my_free,
+                      realloc_fn my_realloc) {
+	_Atomic(void*)* objects = checked_calloc(replay->num_objects + 1, sizeof(_Atomic(void*)));
+	uint32_t* latencies = checked_calloc(replay->num_operations + 1, sizeof(uint32_t));
+	pthread_t* thread_ids = checked_calloc(replay->num_threads, sizeof(pthread_t));
+	replay_context* contexts = checked_calloc(replay->num_threads, sizeof(replay_context));
+
+	pthread_barrier_t barrier;
+	pthread_barrier_init(&barrier, NULL, replay->num_threads + 1);
+
+	if(my_init != NULL) {
+		my_init(POOL_SIZE, false);
+	}
+
+	reset_peak_rss();
+	const uint64_t rss_before = read_status_kib("VmRSS:");
+
+	for(uint32_t i = 0; i < replay->num_threads; ++i) {
+		contexts[i] = (replay_context){ .replay = replay,
+			                            .thread = i,
+			                            .my_malloc = my_malloc,
+			                            .my_free = my_free,
+			                            .my_realloc = my_realloc,
+			                            .objects = objects,
+			                            .latencies = latencies,
+			                            .barrier = &barrier };
+		if(pthread_create(&thread_ids[i], NULL, replay_thread_fn, &contexts[i]) != 0) {
+			fprintf(stderr, "ERROR: Couldn't create the replay threads!\n");
+			exit(EXIT_FAILURE);
+		}
+	}
+
+	pthread_barrier_wait(&barrier);
+	const uint64_t before = get_timestamp_ns();
+
+	for(uint32_t i = 0; i < replay->num_threads; ++i) {
+		pthread_join(thread_ids[i], NULL);
+	}
+
+	const uint64_t after = get_timestamp_ns();
+	const uint64_t peak_rss = read_status_kib("VmHWM:");
+
+	// the blocks, that were never freed in the trace
+	for(uint64_t i = 0; i < replay->num_objects; ++i) {
+		void* ptr = atomic_load_explicit(&objects[i], memory_order_relaxed);
+		if(ptr != NULL) {
+			my_free(ptr);
+		}
+	}
+
+	if(my_destroy != NULL) {
+		my_destroy();
+	}
+
+	qsort(latencies, replay->num_operations, sizeof(uint32_t), compare_latencies);
+
+	const uint64_t last = replay->num_operations == 0 ? 0 : replay->num_operations - 1;
+	const double elapsed_ms = (double)(after - before) / 1000000.0;
+	const double rss_growth =
+	    peak_rss > rss_before ? (double)(peak_rss - rss_before) * 1024.0 : 0.0;
+	const double fragmentation =
+	    rss_growth <= (double)replay->peak_live_bytes
+	        ? 0.0
+	        : 1.0 - (double)replay->peak_live_bytes / rss_growth;
+
+	printf("%s: %" PRIu64 " operations in %.2lf ms, %.0lf ops/sec\n", name,
+	       replay->num_operations, elapsed_ms,
+	       elapsed_ms > 0.0 ? (double)replay->num_operations / elapsed_ms * 1000.0 : 0.0);
+	printf("\tlatency (ns): p50 %" PRIu32 ", p90 %" PRIu32 ", p99 %" PRIu32 ", p99.9 %" PRIu32
+	       ", max %" PRIu32 "\n",
+	       latencies[last * 50 / 100], latencies[last * 90 / 100], latencies[last * 99 / 100],
+	       latencies[last * 999 / 1000], latencies[last]);
+	printf("\tpeak RSS growth: %.2lf MiB, peak live: %.2lf MiB, fragmentation: %.3lf\n",
+	       rss_growth / (1024.0 * 1024.0), (double)replay->peak_live_bytes / (1024.0 * 1024.0),
+	       fragmentation);
+
+	pthread_barrier_destroy(&barrier);
+	free(contexts);
+	free(thread_ids);
+	free(latencies);
+	free(objects);
+}
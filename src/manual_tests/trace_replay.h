@@ -0,0 +1,37 @@
+#ifndef TRACE_REPLAY_H
+#define TRACE_REPLAY_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#include "membench.h"
+
+typedef struct trace_replay trace_replay;
+
+/**
+ * Loads an allocation trace, that was recorded with my_malloc_trace_start, and prepares it for
+ * replaying. Every recorded thread gets its own replay thread, unless num_threads is not 0, then
+ * the recorded threads are distributed over that many replay threads. Frees of allocations, that
+ * were made before the trace started, are skipped. Exits the program, if the trace can't be read.
+ */
+trace_replay* load_trace_replay(const char* path, uint32_t num_threads);
+
+void free_trace_replay(trace_replay* replay);
+
+/**
+ * Replays the trace with the provided functions and prints the ops/sec, the latency percentiles,
+ * the peak RSS and the fragmentation (1 - peak live bytes / peak RSS growth) to stdout.
+ *
+ * Every operation is executed on the thread, that recorded it, in the recorded order, a free of a
+ * block, that was allocated on another thread, waits until that allocation was replayed, so
+ * cross-thread frees are preserved. The waiting isn't part of the latencies.
+ *
+ * my_init and my_destroy are called once and may be NULL. If my_realloc is NULL, reallocations
+ * are replayed as malloc, memcpy and free. Aligned allocations are replayed with my_malloc.
+ */
+void run_trace_replay(const trace_replay* replay, const char* name, init_allocator_fn my_init,
+                      destroy_allocator_fn my_destroy, malloc_fn my_malloc, free_fn my_free,
+                      realloc_fn my_realloc);
+
+#endif
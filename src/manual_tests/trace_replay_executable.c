@@ -0,0 +1,47 @@
+/*
+Author: Totto16
+*/
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include <trace_replay.h>
+#include <utils.h>
+
+#include <main/my_malloc.h>
+
+// prints the usage, if argc is not the right amount!
+void printUsage(const char* programName) {
+	printf("usage: %s <trace> [threads]\n\t trace: recorded with my_malloc_trace_start or "
+	       "MY_MALLOC_TRACE\n\t threads: the number of replay threads, default: one per recorded "
+	       "thread\n",
+	       programName);
+}
+
+// this main replays an allocation trace with the system allocator and with the best fit list
+// allocator, that uses one mutex, so that blocks can be freed by other threads, than the ones, that
+// allocated them
+int main(int argc, char const* argv[]) {
+
+	if(argc != 2 && argc != 3) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	const long threads = argc == 3 ? parseLongSafely(argv[2], "threads") : 0;
+
+	if(threads < 0 || threads > 4096) {
+		printUsage(argv[0]);
+		exit(EXIT_FAILURE);
+	}
+
+	trace_replay* replay = load_trace_replay(argv[1], (uint32_t)threads);
+
+	run_trace_replay(replay, "System", NULL, NULL, malloc, free, realloc);
+	run_trace_replay(replay, "Custom", my_allocator_init, my_allocator_destroy, my_malloc, my_free,
+	                 my_realloc);
+
+	free_trace_replay(replay);
+
+	return EXIT_SUCCESS;
+}
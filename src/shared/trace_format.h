@@ -0,0 +1,56 @@
+// header guard
+#ifndef _MY_MALLOC_TRACE_FORMAT_H_
+#define _MY_MALLOC_TRACE_FORMAT_H_
+
+#include <stdint.h>
+
+// the binary format of the allocation traces, that my_malloc_trace_start records and trace_replay
+// reads. A trace file starts with a TraceFileHeader, the records start at dataOffset. Every thread
+// writes into its own segment of segmentRecords records, so the records of one thread are in order,
+// but the segments of different threads are interleaved, the global order is the one of the
+// timestamps. Records at the end of a segment, that weren't written, are zero, so their operation
+// is TRACE_NONE and they have to be skipped
+
+// "MYMTRACE" in little endian
+#define TRACE_MAGIC 0x45434152544D594DULL
+#define TRACE_VERSION 2
+
+typedef enum {
+	TRACE_NONE = 0,
+	TRACE_MALLOC = 1,
+	TRACE_FREE = 2,
+	TRACE_REALLOC = 3,
+	TRACE_MEMALIGN = 4,
+	// the old pointer of a realloc, that is recorded before it is freed, the TRACE_REALLOC of the
+	// same thread follows it, also if the realloc failed
+	TRACE_REALLOC_OLD = 5,
+} TraceOperation;
+
+typedef struct {
+	uint64_t magic;
+	uint32_t version;
+	uint32_t recordSize;
+	uint64_t dataOffset;
+	uint64_t segmentRecords;
+	// CLOCK_REALTIME at the start of the trace in ns, the timestamps of the records are relative to
+	// the start and come from CLOCK_MONOTONIC
+	uint64_t startTime;
+} TraceFileHeader;
+
+typedef struct {
+	uint64_t timestamp; // ns since the start of the trace
+	uint64_t ptr;       // the returned pointer, the freed one for TRACE_FREE and TRACE_REALLOC_OLD
+	uint64_t argument;  // the old pointer for TRACE_REALLOC, the alignment for TRACE_MEMALIGN
+	uint64_t size;      // the requested size, 0 for TRACE_FREE and TRACE_REALLOC_OLD
+	uint32_t thread;    // the kernel thread id
+	uint8_t operation;  // a TraceOperation
+	uint8_t reserved[3];
+} TraceRecord;
+
+#ifdef __cplusplus
+static_assert(sizeof(TraceRecord) == 40, "the size of a trace record is part of the format");
+#else
+_Static_assert(sizeof(TraceRecord) == 40, "the size of a trace record is part of the format");
+#endif
+
+#endif
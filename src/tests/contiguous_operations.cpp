@@ -0,0 +1,153 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U))
+
+// the second block doesn't fit into the memory block, the region, that is mapped for it, is
+// merged with that, if the kernel maps it directly before or after it, then the big block fits
+// into the free blocks of both, without mapping again
+TEST(MyMallocContiguous, freeBlockSpansMappings) {
+	my_allocator_init(POOL_SIZE, false);
+
+	unsigned char* ptr1 = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 2));
+	ASSERT_NE(ptr1, nullptr);
+	memset(ptr1, 1, POOL_SIZE / 2);
+
+	unsigned char* guard = static_cast<unsigned char*>(my_malloc(1024));
+	ASSERT_NE(guard, nullptr);
+
+	unsigned char* ptr2 = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 4 * 3));
+	ASSERT_NE(ptr2, nullptr);
+	memset(ptr2, 2, POOL_SIZE / 4 * 3);
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.mmap_calls, 2U);
+	EXPECT_EQ(stats.mapped_bytes, POOL_SIZE * 2);
+
+	if(stats.memory_blocks == 2) {
+		my_free(ptr1);
+		my_free(ptr2);
+		my_free(guard);
+		my_allocator_destroy();
+		GTEST_SKIP() << "the kernel didn't map the region next to the memory block";
+	}
+
+	EXPECT_EQ(stats.memory_blocks, 1U);
+	EXPECT_TRUE(my_allocator_owns(ptr2 + POOL_SIZE / 4 * 3 - 1));
+	EXPECT_EQ(ptr1[POOL_SIZE / 2 - 1], 1);
+	EXPECT_EQ(ptr2[0], 2);
+
+	my_free(ptr1);
+	my_free(ptr2);
+
+	unsigned char* big = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 4 * 5));
+	ASSERT_NE(big, nullptr);
+	memset(big, 3, POOL_SIZE / 4 * 5);
+
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.mmap_calls, 2U);
+	EXPECT_EQ(stats.memory_blocks, 1U);
+
+	my_free(big);
+	my_free(guard);
+
+	// the merged memory block is released and unmapped as a whole
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+	EXPECT_EQ(stats.mapped_bytes, 0U);
+	EXPECT_EQ(stats.munmap_calls, 1U);
+	EXPECT_FALSE(my_allocator_owns(ptr1));
+
+	my_allocator_destroy();
+}
+
+// the growth of the heap maps regions next to each other, the blocks in all of them stay valid
+TEST(MyMallocContiguous, growingHeap) {
+	my_allocator_init(POOL_SIZE, false);
+
+	const size_t count = 64;
+	unsigned char* pointers[count];
+
+	for(size_t i = 0; i < count; ++i) {
+		pointers[i] = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 3));
+		ASSERT_NE(pointers[i], nullptr);
+		memset(pointers[i], static_cast<int>(i), POOL_SIZE / 3);
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_LE(stats.memory_blocks, stats.mmap_calls);
+
+	// every other one, so that the free blocks are merged across the former borders afterwards
+	for(size_t i = 0; i < count; i += 2) {
+		EXPECT_EQ(pointers[i][POOL_SIZE / 3 - 1], static_cast<unsigned char>(i));
+		my_free(pointers[i]);
+	}
+
+	for(size_t i = 1; i < count; i += 2) {
+		EXPECT_EQ(pointers[i][0], static_cast<unsigned char>(i));
+		my_free(pointers[i]);
+	}
+
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+	EXPECT_EQ(stats.mapped_bytes, 0U);
+
+	my_allocator_destroy();
+}
+
+// the threads map regions without the mutex, they are merged with the mutex locked, while the
+// other threads free in the memory block, that grows
+TEST(MyMallocContiguous, concurrentGrowth) {
+	my_allocator_init(POOL_SIZE, false);
+
+	const size_t threadCount = 4;
+	const size_t blockCount = 32;
+
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < threadCount; ++i) {
+		threads.emplace_back([i]() {
+			std::vector<unsigned char*> pointers;
+
+			for(size_t j = 0; j < blockCount; ++j) {
+				unsigned char* ptr = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 4));
+				ASSERT_NE(ptr, nullptr);
+				memset(ptr, static_cast<int>(i + 1), POOL_SIZE / 4);
+				pointers.push_back(ptr);
+
+				// so that the memory blocks have free blocks at both ends
+				if(j % 4 == 3) {
+					my_free(pointers[j - 3]);
+					pointers[j - 3] = nullptr;
+				}
+			}
+
+			for(unsigned char* ptr : pointers) {
+				if(ptr != nullptr) {
+					ASSERT_EQ(ptr[POOL_SIZE / 4 - 1], static_cast<unsigned char>(i + 1));
+					my_free(ptr);
+				}
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 0U);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+	EXPECT_EQ(stats.mapped_bytes, 0U);
+
+	my_allocator_destroy();
+}
@@ -7,9 +7,6 @@
 
 #define POOL_SIZE ((uint64_t)(1024U * 1024U * 256U))
 
-// THIS IS hardcoded, since there's no better way of knowing this
-#define STATIC_MEMORYBLOCK_OVERHEAD (24UL)
-
 TEST(MyMalloc, doubleDestroy) {
 	my_allocator_init(POOL_SIZE, true);
 
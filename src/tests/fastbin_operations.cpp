@@ -0,0 +1,114 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+TEST(MyMallocFastbin, sameSizeIsReused) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr1 = my_malloc(64);
+	void* ptr2 = my_malloc(64);
+	void* guard = my_malloc(1024);
+
+	// the last freed block is returned first
+	my_free(ptr1);
+	my_free(ptr2);
+	EXPECT_EQ(my_malloc(64), ptr2);
+	EXPECT_EQ(my_malloc(64), ptr1);
+
+	my_free(ptr1);
+	my_free(ptr2);
+	my_free(guard);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFastbin, mergedOnTrim) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr1 = my_malloc(64);
+	void* ptr2 = my_malloc(64);
+	void* guard = my_malloc(1024);
+
+	my_free(ptr1);
+	my_free(ptr2);
+
+	// they are free, but not merged yet
+	std::vector<struct my_heap_block_info> blocks = walkBlocks();
+	ASSERT_GE(blocks.size(), 3U);
+	EXPECT_TRUE(blocks[0].free);
+	EXPECT_TRUE(blocks[1].free);
+	EXPECT_EQ(blocks[1].data, ptr2);
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 1U);
+
+	// the memory block still holds the guard
+	EXPECT_FALSE(my_allocator_trim());
+
+	blocks = walkBlocks();
+	ASSERT_GE(blocks.size(), 2U);
+	EXPECT_TRUE(blocks[0].free);
+	EXPECT_EQ(blocks[1].data, guard);
+
+	// the merged block isn't in a fastbin anymore, so it is split for a bigger size
+	void* ptr3 = my_malloc(128);
+	EXPECT_EQ(ptr3, ptr1);
+
+	my_free(ptr3);
+	my_free(guard);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFastbin, consolidatedForBiggerRequest) {
+	my_allocator_init(POOL_SIZE, true);
+
+	std::vector<void*> pointers;
+	for(size_t i = 0; i < 64; ++i) {
+		pointers.push_back(my_malloc(100));
+	}
+
+	// the rest of the memory block is used, so only the merged small blocks can hold the request,
+	// the size of the last block isn't aligned, the few bytes less are too small for another block
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	void* rest = my_malloc(stats.largest_free_block - 8);
+	ASSERT_NE(rest, nullptr);
+
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+
+	void* big = my_malloc(4096);
+	EXPECT_EQ(big, pointers[0]);
+
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.memory_blocks, 1U);
+	EXPECT_EQ(stats.used_blocks, 2U);
+
+	my_free(big);
+	my_free(rest);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFastbin, doubleFree) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr1 = my_malloc(64);
+	void* guard = my_malloc(1024);
+
+	my_free(ptr1);
+
+	EXPECT_EXIT({ my_free(ptr1); }, ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to free a already freed Block: 0x[0-9a-fA-F]{2,16}");
+
+	my_free(guard);
+	my_allocator_destroy();
+}
@@ -0,0 +1,174 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <random>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+static void initWithFit(enum my_malloc_fit fit, uint32_t goodEnoughPercent) {
+	struct my_allocator_options options = defaultOptions(POOL_SIZE, true);
+	options.fit = fit;
+	options.good_enough_percent = goodEnoughPercent;
+	// the tests expect, that the search wraps around to the first memory block
+	options.separate_memory_blocks = true;
+
+	my_allocator_init_ex(&options);
+}
+
+// holes of the given sizes, separated by small allocated blocks, the rest of the memory block is
+// free after them, the separators are returned, so that they can be freed
+static std::vector<void*> makeHoles(const std::vector<uint64_t>& sizes, std::vector<void*>& holes) {
+	std::vector<void*> separators;
+
+	for(uint64_t size : sizes) {
+		holes.push_back(my_malloc(size));
+		separators.push_back(my_malloc(64));
+	}
+
+	for(void* hole : holes) {
+		my_free(hole);
+	}
+
+	return separators;
+}
+
+static void freeAll(const std::vector<void*>& pointers) {
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+}
+
+TEST(MyMallocFit, bestFit) {
+	initWithFit(MY_MALLOC_FIT_BEST, 0);
+
+	std::vector<void*> holes;
+	std::vector<void*> separators = makeHoles({ 4096, 1100, 1024 }, holes);
+
+	// the hole, that fits exactly
+	void* ptr = my_malloc(1024);
+	EXPECT_EQ(ptr, holes[2]);
+
+	my_free(ptr);
+	freeAll(separators);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFit, firstFit) {
+	initWithFit(MY_MALLOC_FIT_FIRST, 0);
+
+	std::vector<void*> holes;
+	std::vector<void*> separators = makeHoles({ 4096, 1100, 1040 }, holes);
+
+	void* ptr = my_malloc(1024);
+	EXPECT_EQ(ptr, holes[0]);
+
+	// the rest of the first hole is still the first block, that fits
+	void* ptr2 = my_malloc(1024);
+	EXPECT_GT(ptr2, ptr);
+	EXPECT_LT(ptr2, holes[1]);
+
+	my_free(ptr);
+	my_free(ptr2);
+	freeAll(separators);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFit, nextFit) {
+	initWithFit(MY_MALLOC_FIT_NEXT, 0);
+
+	std::vector<void*> holes;
+	std::vector<void*> separators = makeHoles({ 4096, 1100, 1040 }, holes);
+
+	// the last allocation was the last separator, so the search starts there and the holes in
+	// front of it aren't used
+	void* ptr = my_malloc(1024);
+	EXPECT_GT(ptr, separators.back());
+
+	void* ptr2 = my_malloc(1024);
+	EXPECT_GT(ptr2, ptr);
+
+	// the rover is moved to the block, that absorbs it, so it stays valid
+	my_free(ptr2);
+	my_free(ptr);
+
+	// this gets its own memory block, the search after it wraps around to the first memory block
+	void* big = my_malloc(POOL_SIZE - 4096);
+	ASSERT_NE(big, nullptr);
+	void* ptr3 = my_malloc(4096);
+	EXPECT_EQ(ptr3, holes[0]);
+
+	my_free(big);
+	my_free(ptr3);
+	freeAll(separators);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocFit, goodEnoughFit) {
+	initWithFit(MY_MALLOC_FIT_GOOD_ENOUGH, 10);
+
+	std::vector<void*> holes;
+	std::vector<void*> separators = makeHoles({ 4096, 1100, 1024 }, holes);
+
+	// the second hole wastes less than 10%, so the search ends there, best fit would take the third
+	void* ptr = my_malloc(1024);
+	EXPECT_EQ(ptr, holes[1]);
+
+	my_free(ptr);
+	freeAll(separators);
+	my_allocator_destroy();
+}
+
+// random allocations, reallocations and frees with every policy, the content of every block is
+// checked, so blocks, that are handed out twice, are found
+TEST(MyMallocFit, randomOperations) {
+	for(enum my_malloc_fit fit : { MY_MALLOC_FIT_BEST, MY_MALLOC_FIT_FIRST, MY_MALLOC_FIT_NEXT,
+	                               MY_MALLOC_FIT_GOOD_ENOUGH }) {
+		initWithFit(fit, 25);
+
+		std::mt19937 generator(42);
+		std::vector<std::pair<unsigned char*, uint64_t>> blocks(512, { nullptr, 0 });
+
+		for(size_t i = 0; i < 20000; ++i) {
+			auto& [ptr, size] = blocks[generator() % blocks.size()];
+
+			if(ptr != nullptr) {
+				for(uint64_t j = 0; j < size; j += 61) {
+					ASSERT_EQ(ptr[j], static_cast<unsigned char>(size));
+				}
+			}
+
+			const uint64_t newSize = 1 + generator() % 8192;
+
+			if(ptr == nullptr) {
+				ptr = static_cast<unsigned char*>(my_malloc(newSize));
+			} else if(generator() % 2 == 0) {
+				ptr = static_cast<unsigned char*>(my_realloc(ptr, newSize));
+			} else {
+				my_free(ptr);
+				ptr = nullptr;
+				continue;
+			}
+
+			ASSERT_NE(ptr, nullptr);
+			size = newSize;
+			memset(ptr, static_cast<unsigned char>(size), size);
+		}
+
+		for(auto& [ptr, size] : blocks) {
+			my_free(ptr);
+		}
+
+		struct my_malloc_stats stats;
+		my_allocator_stats(&stats);
+		EXPECT_EQ(stats.used_blocks, 0U);
+
+		my_allocator_destroy();
+	}
+}
@@ -0,0 +1,124 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U))
+
+static void initWithGrowth(uint32_t growthPercent, uint64_t maxMemoryBlockSize) {
+	struct my_allocator_options options = defaultOptions(POOL_SIZE, false);
+	options.growth_percent = growthPercent;
+	options.max_memory_block_size = maxMemoryBlockSize;
+	// the sizes are only predictable, if the mapped regions don't become parts of each other
+	options.separate_memory_blocks = true;
+
+	my_allocator_init_ex(&options);
+}
+
+// allocates blocks, until count new memory blocks were mapped, and returns their sizes
+static std::vector<uint64_t> growMemoryBlocks(size_t count, std::vector<void*>& pointers) {
+	std::vector<uint64_t> sizes;
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+
+	while(sizes.size() < count) {
+		const uint64_t mappedBytes = stats.mapped_bytes;
+		const uint64_t memoryBlocks = stats.memory_blocks;
+
+		void* ptr = my_malloc(POOL_SIZE / 4);
+		EXPECT_NE(ptr, nullptr);
+		if(ptr == nullptr) {
+			break;
+		}
+		pointers.push_back(ptr);
+
+		my_allocator_stats(&stats);
+		if(stats.memory_blocks != memoryBlocks) {
+			sizes.push_back(stats.mapped_bytes - mappedBytes);
+		}
+	}
+
+	return sizes;
+}
+
+TEST(MyMallocGrowth, defaultSizeWithoutGrowth) {
+	initWithGrowth(0, 0);
+
+	std::vector<void*> pointers;
+	std::vector<uint64_t> sizes = growMemoryBlocks(4, pointers);
+
+	for(uint64_t size : sizes) {
+		EXPECT_EQ(size, POOL_SIZE);
+	}
+
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+	my_allocator_destroy();
+}
+
+TEST(MyMallocGrowth, geometricUpToCap) {
+	initWithGrowth(100, POOL_SIZE * 8);
+
+	std::vector<void*> pointers;
+	std::vector<uint64_t> sizes = growMemoryBlocks(6, pointers);
+
+	const std::vector<uint64_t> expected = { POOL_SIZE,     POOL_SIZE * 2, POOL_SIZE * 4,
+		                                     POOL_SIZE * 8, POOL_SIZE * 8, POOL_SIZE * 8 };
+	EXPECT_EQ(sizes, expected);
+
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+
+	// every released memory block shrinks the next one by one step
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+
+	void* ptr = my_malloc(64);
+	ASSERT_NE(ptr, nullptr);
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.mapped_bytes, POOL_SIZE);
+
+	my_free(ptr);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocGrowth, biggerRequestsKeepTheirSize) {
+	initWithGrowth(50, POOL_SIZE * 4);
+
+	unsigned char* big = static_cast<unsigned char*>(my_malloc(POOL_SIZE * 16));
+	ASSERT_NE(big, nullptr);
+	big[POOL_SIZE * 16 - 1] = 1;
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_GT(stats.mapped_bytes, POOL_SIZE * 16);
+
+	const uint64_t mappedBytes = stats.mapped_bytes;
+
+	// the big memory block counts as a step, so the next one is bigger than the default size
+	void* ptr = my_malloc(POOL_SIZE / 2);
+	ASSERT_NE(ptr, nullptr);
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.memory_blocks, 2U);
+	EXPECT_EQ(stats.mapped_bytes - mappedBytes, POOL_SIZE + POOL_SIZE / 2);
+
+	my_free(big);
+	my_free(ptr);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocGrowth, invalidOptions) {
+	EXPECT_EXIT({ initWithGrowth(100, POOL_SIZE / 2); }, ::testing::ExitedWithCode(1),
+	            "ERROR: Invalid allocator options: growth percent 100, max memory block size "
+	            "524288");
+}
@@ -0,0 +1,83 @@
+
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <fstream>
+#include <sstream>
+#include <string>
+
+#include <gtest/gtest.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+static std::string readFile(const std::string& path) {
+	std::ifstream file(path);
+	std::stringstream content;
+	content << file.rdbuf();
+	return content.str();
+}
+
+TEST(MyMalloc, heapProfileOperations) {
+	my_allocator_init(POOL_SIZE, false);
+
+	// a sample rate of one byte samples every allocation
+	my_heap_profile_start(1);
+
+	void* pointers[10];
+
+	// 1000 + the header is a multiple of the alignment, so the size isn't rounded
+	for(size_t i = 0; i < 10; ++i) {
+		pointers[i] = my_malloc(1000);
+		ASSERT_NE(pointers[i], nullptr);
+	}
+
+	for(size_t i = 0; i < 5; ++i) {
+		my_free(pointers[i]);
+	}
+
+	my_heap_profile_stop();
+
+	// this isn't sampled anymore
+	void* notSampled = my_malloc(1000);
+
+	char path[] = "/tmp/my_malloc_heap_profile_XXXXXX";
+	const int fd = mkstemp(path);
+	ASSERT_NE(fd, -1);
+	close(fd);
+
+	ASSERT_EQ(my_heap_profile_dump(path), 0);
+
+	const std::string profile = readFile(path);
+	unlink(path);
+
+	EXPECT_EQ(profile.rfind("heap profile: 5: 5000 [10: 10000] @ heap_v2/1\n", 0), 0U) << profile;
+
+	// all of them have the same backtrace
+	EXPECT_NE(profile.find("\n5: 5000 [10: 10000] @ 0x"), std::string::npos) << profile;
+
+	EXPECT_NE(profile.find("\nMAPPED_LIBRARIES:\n"), std::string::npos);
+
+	EXPECT_EQ(my_heap_profile_dump("/this/path/does/not/exist"), -1);
+
+	for(size_t i = 5; i < 10; ++i) {
+		my_free(pointers[i]);
+	}
+
+	my_free(notSampled);
+
+	// the header has the rate of the last run, after it was stopped
+	my_heap_profile_start(524288);
+	my_heap_profile_stop();
+
+	ASSERT_EQ(my_heap_profile_dump(path), 0);
+
+	const std::string stoppedProfile = readFile(path);
+	unlink(path);
+
+	EXPECT_EQ(stoppedProfile.rfind("heap profile: 0: 0 [10: 10000] @ heap_v2/524288\n", 0), 0U)
+	    << stoppedProfile;
+
+	my_allocator_destroy();
+}
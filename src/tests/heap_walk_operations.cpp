@@ -0,0 +1,116 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <unistd.h>
+
+#include <string>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+TEST(MyMalloc, heapWalk) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr1 = my_malloc(1024);
+	void* ptr2 = my_malloc(2048);
+	void* ptr3 = my_malloc(1024);
+	my_free(ptr2);
+
+	// bigger than the default memory block size, so it gets its own memory block
+	void* ptr4 = my_malloc(POOL_SIZE * 2);
+
+	std::vector<struct my_heap_block_info> blocks = walkBlocks();
+
+	// the hole, the rest of the first memory block and the big block, there is no rest there
+	ASSERT_GE(blocks.size(), 5U);
+
+	uint64_t usedBlocks = 0;
+	uint64_t freeBytes = 0;
+
+	for(size_t i = 0; i < blocks.size(); ++i) {
+		const struct my_heap_block_info& info = blocks[i];
+
+		EXPECT_GE(info.header, info.memory_block);
+		EXPECT_GT(info.data, info.header);
+		EXPECT_LE((unsigned char*)info.data + info.size,
+		          (unsigned char*)info.memory_block + info.memory_block_size);
+
+		// the blocks of one memory block are contiguous
+		if(i > 0 && blocks[i - 1].memory_block == info.memory_block) {
+			EXPECT_EQ((unsigned char*)blocks[i - 1].data + blocks[i - 1].size, info.header);
+		}
+
+		if(info.free) {
+			freeBytes += info.size;
+		} else {
+			usedBlocks++;
+		}
+	}
+
+	EXPECT_EQ(blocks[0].data, ptr1);
+	EXPECT_EQ(blocks[1].data, ptr2);
+	EXPECT_TRUE(blocks[1].free);
+	EXPECT_EQ(blocks[2].data, ptr3);
+	EXPECT_EQ(usedBlocks, 3U);
+
+	// the walk sees the same blocks as the stats
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.used_blocks, usedBlocks);
+	EXPECT_EQ(stats.free_bytes, freeBytes);
+
+	my_free(ptr1);
+	my_free(ptr3);
+	my_free(ptr4);
+
+	my_allocator_destroy();
+}
+
+TEST(MyMalloc, heapDumpMap) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr1 = my_malloc(POOL_SIZE / 2);
+
+	int pipeFds[2];
+	ASSERT_EQ(pipe(pipeFds), 0);
+
+	EXPECT_EQ(my_heap_dump_map(pipeFds[1]), 0);
+	close(pipeFds[1]);
+
+	std::string output;
+	char buffer[512];
+	ssize_t readBytes;
+	while((readBytes = read(pipeFds[0], buffer, sizeof(buffer))) > 0) {
+		output.append(buffer, static_cast<size_t>(readBytes));
+	}
+	close(pipeFds[0]);
+
+	// the legend and one line for the only memory block
+	const size_t firstNewline = output.find('\n');
+	ASSERT_NE(firstNewline, std::string::npos);
+	EXPECT_EQ(output[0], '#');
+
+	const std::string line = output.substr(firstNewline + 1);
+	EXPECT_EQ(line.find('\n'), line.size() - 1);
+
+	const size_t mapStart = line.find('|');
+	ASSERT_NE(mapStart, std::string::npos);
+	const std::string map = line.substr(mapStart + 1, 64);
+
+	// the first half is used, the second free, with one cell containing the boundary
+	EXPECT_EQ(map.substr(0, 31), std::string(31, '#'));
+	EXPECT_EQ(map.substr(33), std::string(31, '.'));
+	EXPECT_EQ(line[mapStart + 65], '|');
+
+	EXPECT_EQ(my_heap_dump_map(-1), -1);
+	EXPECT_EQ(errno, EBADF);
+
+	my_free(ptr1);
+
+	my_allocator_destroy();
+}
@@ -0,0 +1,126 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <chrono>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+#define INTERVAL_MS 5U
+
+static void initWithBackgroundThread(bool forceAlloc) {
+	struct my_allocator_options options = defaultOptions(POOL_SIZE, forceAlloc);
+	options.background_interval_ms = INTERVAL_MS;
+
+	my_allocator_init_ex(&options);
+}
+
+// the background thread works asynchronously, so the tests wait up to a second for it
+template <typename Predicate> static bool waitFor(Predicate predicate) {
+	for(size_t i = 0; i < 1000; ++i) {
+		if(predicate()) {
+			return true;
+		}
+		std::this_thread::sleep_for(std::chrono::milliseconds(1));
+	}
+
+	return predicate();
+}
+
+static uint64_t memoryBlocks() {
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	return stats.memory_blocks;
+}
+
+TEST(MyMallocMaintenance, releasesEmptyMemoryBlocks) {
+	initWithBackgroundThread(false);
+
+	std::vector<void*> pointers;
+	for(size_t i = 0; i < 4; ++i) {
+		void* ptr = my_malloc(POOL_SIZE * 2);
+		ASSERT_NE(ptr, nullptr);
+		memset(ptr, 0xAB, 64);
+		pointers.push_back(ptr);
+	}
+
+	EXPECT_EQ(memoryBlocks(), 4U);
+
+	// the frees only signal the background thread, it releases the memory blocks
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+
+	EXPECT_TRUE(waitFor([]() { return memoryBlocks() == 0; }));
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocMaintenance, mergesFastbins) {
+	initWithBackgroundThread(true);
+
+	void* ptr1 = my_malloc(64);
+	void* ptr2 = my_malloc(64);
+	void* guard = my_malloc(1024);
+
+	my_free(ptr1);
+	my_free(ptr2);
+
+	// the two small blocks are merged into one free block in front of the guard
+	EXPECT_TRUE(waitFor([guard]() {
+		std::vector<struct my_heap_block_info> blocks = walkBlocks();
+		return blocks.size() >= 2 && blocks[0].free && blocks[1].data == guard;
+	}));
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 1U);
+
+	my_free(guard);
+
+	// the memory block only held the guard and the merged blocks
+	EXPECT_TRUE(waitFor([]() { return memoryBlocks() == 0; }));
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocMaintenance, destroyStopsThread) {
+	for(size_t i = 0; i < 3; ++i) {
+		initWithBackgroundThread(i % 2 == 0);
+
+		std::vector<std::thread> threads;
+		for(size_t j = 0; j < 4; ++j) {
+			threads.emplace_back([]() {
+				for(size_t k = 0; k < 1000; ++k) {
+					unsigned char* ptr = static_cast<unsigned char*>(my_malloc(16 + k % 2048));
+					ASSERT_NE(ptr, nullptr);
+					ptr[0] = 1;
+					my_free(ptr);
+				}
+			});
+		}
+
+		for(auto& thread : threads) {
+			thread.join();
+		}
+
+		my_allocator_destroy();
+	}
+
+	// without a background thread, the frees release the memory blocks themselves again
+	my_allocator_init(POOL_SIZE, false);
+
+	void* big = my_malloc(POOL_SIZE * 2);
+	ASSERT_NE(big, nullptr);
+	my_free(big);
+	EXPECT_EQ(memoryBlocks(), 0U);
+
+	my_allocator_destroy();
+}
@@ -7,9 +7,6 @@
 
 #define POOL_SIZE ((uint64_t)(1024U * 1024U * 256U))
 
-// THIS IS hardcoded, since there's no better way of knowing this
-#define STATIC_MEMORYBLOCK_OVERHEAD (24UL)
-
 TEST(MyMalloc, normalOperations) {
 	my_allocator_init(POOL_SIZE, true);
 
@@ -22,7 +19,23 @@ TEST(MyMalloc, normalOperations) {
 	memset(ptr2, 0xFF, 1024);
 	const uint64_t overhead = (ptrdiff_t)ptr2 - (ptrdiff_t)ptr1 - 1024;
 
-	void* const startOfRegion = (unsigned char*)ptr1 - STATIC_MEMORYBLOCK_OVERHEAD - overhead;
+	// the layout of the memory block is taken from the heap walk, instead of hardcoding it
+	struct my_heap_block_info info = {};
+	info.data = ptr1;
+	my_heap_walk(
+	    [](const struct my_heap_block_info* block, void* ctx) {
+		    auto* result = static_cast<struct my_heap_block_info*>(ctx);
+		    if(block->data == result->data) {
+			    *result = *block;
+		    }
+	    },
+	    &info);
+	ASSERT_NE(info.memory_block, nullptr);
+
+	// the header of the memory block and of the first block
+	const uint64_t memoryBlockOverhead = (ptrdiff_t)info.data - (ptrdiff_t)info.memory_block;
+
+	void* const startOfRegion = info.memory_block;
 
 	my_free(ptr1);
 	my_free(nullptr);
@@ -63,7 +76,7 @@ TEST(MyMalloc, normalOperations) {
 	my_free(ptr3);
 
 	// Lastly, allocate all available memory
-	void* ptr10 = my_malloc(POOL_SIZE - overhead - STATIC_MEMORYBLOCK_OVERHEAD);
+	void* ptr10 = my_malloc(POOL_SIZE - memoryBlockOverhead);
 	EXPECT_NE(ptr10, nullptr);
 
 	// Check new mapped block, so that this memory is after the first allocation
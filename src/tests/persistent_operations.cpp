@@ -0,0 +1,281 @@
+#include <my_persistent_heap.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+
+#include <gtest/gtest.h>
+
+#define HEAP_SIZE ((uint64_t)(1024U * 1024U))
+
+// the data in the file refers to other blocks by their offset from the root
+struct Root {
+	uint64_t count;
+	uint64_t names[4];
+};
+
+static std::string temporaryFile() {
+	char path[] = "/tmp/my_malloc_persistent_XXXXXX";
+	int fd = mkstemp(path);
+	EXPECT_GE(fd, 0);
+	close(fd);
+	return path;
+}
+
+TEST(MyMallocPersistent, reopenRestoresBlocks) {
+	const std::string path = temporaryFile();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	EXPECT_EQ(my_allocator_get_root(), nullptr);
+
+	Root* root = static_cast<Root*>(my_malloc(sizeof(Root)));
+	ASSERT_NE(root, nullptr);
+	root->count = 0;
+
+	const char* names[] = { "first", "second", "third" };
+	for(const char* name : names) {
+		char* block = static_cast<char*>(my_malloc(strlen(name) + 1));
+		ASSERT_NE(block, nullptr);
+		strcpy(block, name);
+		root->names[root->count++] = static_cast<uint64_t>(block - (char*)root);
+	}
+
+	void* freed = my_malloc(4096);
+	ASSERT_NE(freed, nullptr);
+	my_free(freed);
+
+	my_allocator_set_root(root);
+	ASSERT_EQ(my_allocator_checkpoint(), 0);
+	my_allocator_destroy();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), 0), 0);
+
+	root = static_cast<Root*>(my_allocator_get_root());
+	ASSERT_NE(root, nullptr);
+	ASSERT_EQ(root->count, 3U);
+	for(uint64_t i = 0; i < root->count; ++i) {
+		EXPECT_STREQ((char*)root + root->names[i], names[i]);
+	}
+
+	// the blocks are still allocated, so new ones don't overlap them, and they can be freed
+	char* block = static_cast<char*>(my_malloc(64));
+	ASSERT_NE(block, nullptr);
+	memset(block, 0xFF, 64);
+	EXPECT_STREQ((char*)root + root->names[2], "third");
+
+	my_free(block);
+	for(uint64_t i = 0; i < root->count; ++i) {
+		my_free((char*)root + root->names[i]);
+	}
+	my_free(root);
+	my_allocator_set_root(nullptr);
+	my_allocator_destroy();
+
+	// everything was freed, so the whole pool is one block again
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	EXPECT_EQ(my_allocator_get_root(), nullptr);
+	void* big = my_malloc(HEAP_SIZE / 4 * 3);
+	EXPECT_NE(big, nullptr);
+	my_free(big);
+	my_allocator_destroy();
+
+	unlink(path.c_str());
+}
+
+TEST(MyMallocPersistent, invalidFiles) {
+	const std::string path = temporaryFile();
+
+	errno = 0;
+	EXPECT_EQ(my_allocator_open_file(path.c_str(), 16), -1);
+	EXPECT_EQ(errno, EINVAL);
+
+	// a file, that isn't a heap, isn't changed
+	int fd = open(path.c_str(), O_WRONLY | O_TRUNC);
+	ASSERT_GE(fd, 0);
+	std::string content(4096, 'x');
+	ASSERT_EQ(write(fd, content.data(), content.size()), static_cast<ssize_t>(content.size()));
+	close(fd);
+
+	errno = 0;
+	EXPECT_EQ(my_allocator_open_file(path.c_str(), 0), -1);
+	EXPECT_EQ(errno, EINVAL);
+
+	fd = open(path.c_str(), O_RDONLY);
+	ASSERT_GE(fd, 0);
+	std::string readContent(content.size(), '\0');
+	ASSERT_EQ(read(fd, readContent.data(), readContent.size()),
+	          static_cast<ssize_t>(readContent.size()));
+	close(fd);
+	EXPECT_EQ(readContent, content);
+
+	ASSERT_EQ(truncate(path.c_str(), 0), 0);
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	my_allocator_destroy();
+
+	errno = 0;
+	EXPECT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE * 2), -1);
+	EXPECT_EQ(errno, EINVAL);
+
+	// overwrites the first block header, that follows the 64 bytes of the file header, so the
+	// blocks don't end at the end of the file anymore
+	fd = open(path.c_str(), O_WRONLY);
+	ASSERT_GE(fd, 0);
+	const uint64_t garbage = UINT64_MAX;
+	ASSERT_EQ(pwrite(fd, &garbage, sizeof(garbage), 64), static_cast<ssize_t>(sizeof(garbage)));
+	close(fd);
+
+	errno = 0;
+	EXPECT_EQ(my_allocator_open_file(path.c_str(), 0), -1);
+	EXPECT_EQ(errno, EINVAL);
+
+	unlink(path.c_str());
+}
+
+// the blocks aren't locked between processes, so another process can't open the file, until it is
+// closed again
+TEST(MyMallocPersistent, otherProcess) {
+	const std::string path = temporaryFile();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+
+	if(pid == 0) {
+		errno = 0;
+		if(my_allocator_open_file(path.c_str(), 0) != -1) {
+			_exit(1);
+		}
+
+		_exit(errno == EWOULDBLOCK ? 0 : 2);
+	}
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+
+	my_allocator_destroy();
+
+	pid = fork();
+	ASSERT_NE(pid, -1);
+
+	if(pid == 0) {
+		if(my_allocator_open_file(path.c_str(), 0) != 0) {
+			_exit(1);
+		}
+
+		my_allocator_destroy();
+		_exit(0);
+	}
+
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	ASSERT_TRUE(WIFEXITED(status));
+	EXPECT_EQ(WEXITSTATUS(status), 0);
+
+	unlink(path.c_str());
+}
+
+TEST(MyMallocPersistent, rootNeedsFile) {
+	EXPECT_EXIT(
+	    {
+		    my_allocator_init(HEAP_SIZE, false);
+		    EXPECT_EQ(my_allocator_get_root(), nullptr);
+		    my_allocator_set_root(nullptr);
+	    },
+	    ::testing::ExitedWithCode(1),
+	    "ERROR: Only a heap, that was opened with my_allocator_open_file, has a root");
+}
+
+TEST(MyMallocPersistent, restTooSmallForABlock) {
+	const std::string path = temporaryFile();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	char* first = static_cast<char*>(my_malloc(256));
+	char* second = static_cast<char*>(my_malloc(256));
+	ASSERT_NE(first, nullptr);
+	ASSERT_NE(second, nullptr);
+	my_free(first);
+
+	// the rest of the first block can't hold a block header, so it is handed out whole, instead of
+	// writing a header over the one of the second block
+	char* smaller = static_cast<char*>(my_malloc(256 - 4));
+	EXPECT_EQ(smaller, first);
+	memset(second, 0xFF, 256);
+	my_free(second);
+	my_free(smaller);
+	my_allocator_destroy();
+
+	// the blocks still end at the end of the file, so it is opened again and is one block
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	void* big = my_malloc(HEAP_SIZE / 4 * 3);
+	EXPECT_NE(big, nullptr);
+	my_free(big);
+	my_allocator_destroy();
+
+	unlink(path.c_str());
+}
+
+TEST(MyMallocPersistent, freedRoot) {
+	const std::string path = temporaryFile();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+	void* root = my_malloc(sizeof(Root));
+	ASSERT_NE(root, nullptr);
+	my_allocator_set_root(root);
+	EXPECT_EQ(my_allocator_get_root(), root);
+
+	// freeing the root resets it, so the file is still opened
+	my_free(root);
+	EXPECT_EQ(my_allocator_get_root(), nullptr);
+	my_allocator_destroy();
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), 0), 0);
+	EXPECT_EQ(my_allocator_get_root(), nullptr);
+	root = my_malloc(sizeof(Root));
+	ASSERT_NE(root, nullptr);
+	my_allocator_set_root(root);
+	my_allocator_destroy();
+
+	// the root is the fourth field of the file header, one, that isn't a block, is reset on open,
+	// since the blocks are still valid
+	int fd = open(path.c_str(), O_WRONLY);
+	ASSERT_GE(fd, 0);
+	const uint64_t garbage = 12345;
+	ASSERT_EQ(pwrite(fd, &garbage, sizeof(garbage), 24), static_cast<ssize_t>(sizeof(garbage)));
+	close(fd);
+
+	ASSERT_EQ(my_allocator_open_file(path.c_str(), 0), 0);
+	EXPECT_EQ(my_allocator_get_root(), nullptr);
+	my_allocator_destroy();
+
+	unlink(path.c_str());
+}
+
+TEST(MyMallocPersistent, rootHasToBeABlock) {
+	const std::string path = temporaryFile();
+
+	EXPECT_EXIT(
+	    {
+		    ASSERT_EQ(my_allocator_open_file(path.c_str(), HEAP_SIZE), 0);
+		    char* block = static_cast<char*>(my_malloc(64));
+		    my_allocator_set_root(block + 8);
+	    },
+	    ::testing::ExitedWithCode(1), "ERROR: The root has to be an allocated block of the heap");
+
+	EXPECT_EXIT(
+	    {
+		    ASSERT_EQ(my_allocator_open_file(path.c_str(), 0), 0);
+		    void* block = my_malloc(64);
+		    my_free(block);
+		    my_allocator_set_root(block);
+	    },
+	    ::testing::ExitedWithCode(1), "ERROR: The root has to be an allocated block of the heap");
+
+	unlink(path.c_str());
+}
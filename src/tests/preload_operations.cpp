@@ -0,0 +1,125 @@
+
+#include <my_malloc.h>
+
+#include <malloc.h>
+#include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+// this test is linked against the preload library, so every allocation in this process (including
+// the ones of gtest and the c++ standard library) uses my_malloc
+
+TEST(MyMallocPreload, alignedAllocations) {
+
+	for(size_t size = 1; size < 4096; size += 7) {
+		void* ptr = malloc(size);
+		ASSERT_NE(ptr, nullptr);
+		EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % alignof(max_align_t), 0U);
+		EXPECT_GE(malloc_usable_size(ptr), size);
+		memset(ptr, 0xAB, size);
+		free(ptr);
+	}
+
+	void* ptr1 = nullptr;
+	EXPECT_EQ(posix_memalign(&ptr1, 4096, 100), 0);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr1) % 4096, 0U);
+	memset(ptr1, 0xCD, 100);
+
+	void* ptr2 = aligned_alloc(256, 512);
+	EXPECT_NE(ptr2, nullptr);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr2) % 256, 0U);
+
+	void* ptr3 = nullptr;
+	EXPECT_EQ(posix_memalign(&ptr3, 3, 100), EINVAL);
+
+	free(ptr1);
+	free(ptr2);
+}
+
+TEST(MyMallocPreload, callocAndRealloc) {
+
+	unsigned char* ptr1 = static_cast<unsigned char*>(malloc(1024));
+	memset(ptr1, 0xFF, 1024);
+	free(ptr1);
+
+	// the same block may be reused, but it has to be zeroed nevertheless
+	unsigned char* ptr2 = static_cast<unsigned char*>(calloc(256, 4));
+	ASSERT_NE(ptr2, nullptr);
+	for(size_t i = 0; i < 1024; ++i) {
+		EXPECT_EQ(ptr2[i], 0);
+	}
+
+	// volatile, so that the compiler doesn't detect the overflow at compile time
+	volatile size_t hugeCount = SIZE_MAX / 2;
+	EXPECT_EQ(calloc(hugeCount, 4), nullptr);
+
+	memset(ptr2, 0xEE, 1024);
+	unsigned char* ptr3 = static_cast<unsigned char*>(realloc(ptr2, 1024 * 1024));
+	ASSERT_NE(ptr3, nullptr);
+	for(size_t i = 0; i < 1024; ++i) {
+		EXPECT_EQ(ptr3[i], 0xEE);
+	}
+
+	// bigger than the default memory block size
+	unsigned char* ptr4 = static_cast<unsigned char*>(realloc(ptr3, 128UL * 1024 * 1024));
+	ASSERT_NE(ptr4, nullptr);
+	for(size_t i = 0; i < 1024; ++i) {
+		EXPECT_EQ(ptr4[i], 0xEE);
+	}
+
+	free(ptr4);
+}
+
+TEST(MyMallocPreload, multiThreaded) {
+
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < 8; ++i) {
+		threads.emplace_back([i]() {
+			std::vector<std::string> strings;
+			for(size_t j = 0; j < 2000; ++j) {
+				strings.emplace_back(std::string(16 + ((i * j) % 500), 'a'));
+				if(j % 3 == 0) {
+					strings.erase(strings.begin() + (j % strings.size()));
+				}
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+}
+
+TEST(MyMallocPreload, forkWhileAllocating) {
+
+	std::thread allocatingThread([]() {
+		for(size_t i = 0; i < 20000; ++i) {
+			free(malloc(64 + (i % 1024)));
+		}
+	});
+
+	for(size_t i = 0; i < 10; ++i) {
+		pid_t pid = fork();
+		ASSERT_NE(pid, -1);
+
+		if(pid == 0) {
+			// the allocator has to be usable in the child, even if the parent was allocating
+			std::vector<int> values(1000, 1);
+			_exit(values.size() == 1000 ? 0 : 1);
+		}
+
+		int status = 0;
+		ASSERT_EQ(waitpid(pid, &status, 0), pid);
+		EXPECT_TRUE(WIFEXITED(status));
+		EXPECT_EQ(WEXITSTATUS(status), 0);
+	}
+
+	allocatingThread.join();
+}
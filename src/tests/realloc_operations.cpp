@@ -7,9 +7,6 @@
 
 #define POOL_SIZE ((uint64_t)(1024U * 1024U * 256U))
 
-// THIS IS hardcoded, since there's no better way of knowing this
-#define STATIC_MEMORYBLOCK_OVERHEAD (24UL)
-
 TEST(MyMalloc, reallocOperations) {
 	my_allocator_init(POOL_SIZE, true);
 
@@ -30,9 +27,27 @@ TEST(MyMalloc, reallocOperations) {
 	EXPECT_NE(ptr3, nullptr);
 	memset(ptr3, 0xDD, 353534);
 
-	const uint64_t overhead = (ptrdiff_t)ptr3 - (ptrdiff_t)ptr2 - 3072;
+	// the layout of the memory block is taken from the heap walk, instead of hardcoding it
+	struct my_heap_block_info info = {};
+	info.data = ptr1;
+	my_heap_walk(
+	    [](const struct my_heap_block_info* block, void* ctx) {
+		    auto* result = static_cast<struct my_heap_block_info*>(ctx);
+		    if(block->data == result->data) {
+			    *result = *block;
+		    }
+	    },
+	    &info);
+	ASSERT_NE(info.memory_block, nullptr);
+
+	// the grown block is followed directly by the next one
+	const uint64_t blockOverhead = (ptrdiff_t)info.data - (ptrdiff_t)info.header;
+	EXPECT_EQ((unsigned char*)ptr2 + info.size + blockOverhead, ptr3);
+
+	// the header of the memory block and of the first block
+	const uint64_t memoryBlockOverhead = (ptrdiff_t)info.data - (ptrdiff_t)info.memory_block;
 
-	void* const startOfRegion = (unsigned char*)ptr1 - STATIC_MEMORYBLOCK_OVERHEAD - overhead;
+	void* const startOfRegion = info.memory_block;
 
 	void* ptr4 = my_realloc(ptr1, 1024 * 1024);
 	EXPECT_NE(ptr2, ptr4);
@@ -48,7 +63,7 @@ TEST(MyMalloc, reallocOperations) {
 	my_realloc(ptr4, 0);
 
 	// Lastly, allocate all available memory
-	void* ptr5 = my_malloc(POOL_SIZE - overhead - STATIC_MEMORYBLOCK_OVERHEAD);
+	void* ptr5 = my_malloc(POOL_SIZE - memoryBlockOverhead);
 	EXPECT_NE(ptr5, nullptr);
 
 	// Check new mapped block, so that this memory is after the first allocation
@@ -0,0 +1,101 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+TEST(MyMallocRegistry, owns) {
+	my_allocator_init(POOL_SIZE, true);
+
+	int local = 0;
+	unsigned char* ptr = static_cast<unsigned char*>(my_malloc(1024));
+	unsigned char* big = static_cast<unsigned char*>(my_malloc(POOL_SIZE * 2));
+
+	EXPECT_TRUE(my_allocator_owns(ptr));
+	EXPECT_TRUE(my_allocator_owns(ptr + 100));
+	EXPECT_TRUE(my_allocator_owns(big + POOL_SIZE));
+	EXPECT_FALSE(my_allocator_owns(&local));
+	EXPECT_FALSE(my_allocator_owns(nullptr));
+
+	// the memory block of the big block is unmapped
+	my_free(big);
+	EXPECT_FALSE(my_allocator_owns(big + POOL_SIZE));
+
+	my_free(ptr);
+	my_allocator_destroy();
+	EXPECT_FALSE(my_allocator_owns(ptr));
+}
+
+TEST(MyMallocRegistry, freeForeignPointer) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr = my_malloc(1024);
+	int local = 0;
+
+	EXPECT_EXIT({ my_free(&local); }, ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to free a pointer, that isn't a block of the allocator: "
+	            "0x[0-9a-fA-F]{2,16}");
+
+	my_free(ptr);
+	my_allocator_destroy();
+}
+
+TEST(MyMallocRegistry, freeInteriorPointer) {
+	my_allocator_init(POOL_SIZE, true);
+
+	unsigned char* ptr = static_cast<unsigned char*>(my_malloc(1024));
+	memset(ptr, 0xAB, 1024);
+
+	EXPECT_EXIT({ my_free(ptr + 64); }, ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to free a pointer, that isn't a block of the allocator: "
+	            "0x[0-9a-fA-F]{2,16}");
+
+	// the header of a zeroed interior pointer looks like a free first block
+	memset(ptr, 0, 1024);
+
+	EXPECT_EXIT({ my_realloc(ptr + 512, 2048); }, ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to realloc a pointer, that isn't a block of the allocator: "
+	            "0x[0-9a-fA-F]{2,16}");
+
+	my_free(ptr);
+	my_allocator_destroy();
+}
+
+// memory blocks are mapped and unmapped, while other threads read the registry
+TEST(MyMallocRegistry, concurrentReaders) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* ptr = my_malloc(1024);
+	std::atomic<bool> done{ false };
+	std::vector<std::thread> readers;
+
+	for(size_t i = 0; i < 4; ++i) {
+		readers.emplace_back([ptr, &done]() {
+			while(!done.load()) {
+				ASSERT_TRUE(my_allocator_owns(ptr));
+			}
+		});
+	}
+
+	for(size_t i = 0; i < 200; ++i) {
+		void* big = my_malloc(POOL_SIZE * 2);
+		ASSERT_NE(big, nullptr);
+		EXPECT_TRUE(my_allocator_owns(big));
+		my_free(big);
+	}
+
+	done.store(true);
+	for(auto& thread : readers) {
+		thread.join();
+	}
+
+	my_free(ptr);
+	my_allocator_destroy();
+}
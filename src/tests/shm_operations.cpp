@@ -0,0 +1,178 @@
+#include <my_shm_heap.h>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+
+#include <gtest/gtest.h>
+
+#define HEAP_SIZE ((uint64_t)(1024U * 1024U))
+
+TEST(MyShmHeap, offsetsAndPointers) {
+	struct my_shm_heap* heap = my_shm_create(nullptr, HEAP_SIZE);
+	ASSERT_NE(heap, nullptr);
+
+	my_shm_offset_t offset1 = my_shm_malloc(heap, 100);
+	my_shm_offset_t offset2 = my_shm_malloc(heap, 13);
+	ASSERT_NE(offset1, 0U);
+	ASSERT_NE(offset2, 0U);
+	EXPECT_NE(offset1, offset2);
+
+	char* ptr1 = static_cast<char*>(my_shm_pointer(heap, offset1));
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr1) % 8, 0U);
+	EXPECT_EQ(reinterpret_cast<uintptr_t>(my_shm_pointer(heap, offset2)) % 8, 0U);
+	EXPECT_EQ(my_shm_offset(heap, ptr1), offset1);
+	memset(ptr1, 0xAB, 100);
+
+	EXPECT_EQ(my_shm_pointer(heap, 0), nullptr);
+	EXPECT_EQ(my_shm_offset(heap, nullptr), 0U);
+
+	// a pool can't grow
+	EXPECT_EQ(my_shm_malloc(heap, HEAP_SIZE), 0U);
+
+	my_shm_free(heap, offset1);
+	my_shm_free(heap, offset2);
+	my_shm_free(heap, 0);
+
+	// everything was merged again, so nearly the whole heap fits into one block
+	my_shm_offset_t big = my_shm_malloc(heap, HEAP_SIZE / 4 * 3);
+	EXPECT_NE(big, 0U);
+	my_shm_free(heap, big);
+
+	my_shm_detach(heap);
+}
+
+// the child maps the heap again, at another address, so only the offsets are the same in both
+TEST(MyShmHeap, otherProcess) {
+	struct my_shm_heap* heap = my_shm_create(nullptr, HEAP_SIZE);
+	ASSERT_NE(heap, nullptr);
+
+	my_shm_offset_t slot = my_shm_malloc(heap, sizeof(my_shm_offset_t));
+	ASSERT_NE(slot, 0U);
+	*static_cast<my_shm_offset_t*>(my_shm_pointer(heap, slot)) = 0;
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+
+	if(pid == 0) {
+		struct my_shm_heap* other = my_shm_attach_fd(my_shm_fd(heap));
+		if(other == nullptr) {
+			_exit(1);
+		}
+
+		if(my_shm_pointer(other, slot) == my_shm_pointer(heap, slot)) {
+			_exit(2);
+		}
+
+		my_shm_offset_t payload = my_shm_malloc(other, 64);
+		if(payload == 0) {
+			_exit(3);
+		}
+
+		strcpy(static_cast<char*>(my_shm_pointer(other, payload)), "from the child");
+		*static_cast<my_shm_offset_t*>(my_shm_pointer(other, slot)) = payload;
+
+		my_shm_detach(other);
+		_exit(0);
+	}
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	ASSERT_TRUE(WIFEXITED(status));
+	ASSERT_EQ(WEXITSTATUS(status), 0);
+
+	my_shm_offset_t payload = *static_cast<my_shm_offset_t*>(my_shm_pointer(heap, slot));
+	ASSERT_NE(payload, 0U);
+	EXPECT_STREQ(static_cast<char*>(my_shm_pointer(heap, payload)), "from the child");
+
+	my_shm_free(heap, payload);
+	my_shm_free(heap, slot);
+	my_shm_detach(heap);
+}
+
+TEST(MyShmHeap, namedObject) {
+	const std::string name = "/my_malloc_shm_test_" + std::to_string(getpid());
+
+	struct my_shm_heap* heap = my_shm_create(name.c_str(), HEAP_SIZE);
+	ASSERT_NE(heap, nullptr);
+
+	errno = 0;
+	EXPECT_EQ(my_shm_create(name.c_str(), HEAP_SIZE), nullptr);
+	EXPECT_EQ(errno, EEXIST);
+
+	struct my_shm_heap* other = my_shm_attach(name.c_str());
+	ASSERT_NE(other, nullptr);
+
+	my_shm_offset_t offset = my_shm_malloc(other, 32);
+	ASSERT_NE(offset, 0U);
+	strcpy(static_cast<char*>(my_shm_pointer(other, offset)), "shared");
+	EXPECT_STREQ(static_cast<char*>(my_shm_pointer(heap, offset)), "shared");
+
+	my_shm_free(heap, offset);
+	my_shm_detach(other);
+	my_shm_detach(heap);
+
+	ASSERT_EQ(shm_unlink(name.c_str()), 0);
+
+	errno = 0;
+	EXPECT_EQ(my_shm_attach(name.c_str()), nullptr);
+	EXPECT_EQ(errno, ENOENT);
+}
+
+TEST(MyShmHeap, invalidObjects) {
+	errno = 0;
+	EXPECT_EQ(my_shm_create(nullptr, 16), nullptr);
+	EXPECT_EQ(errno, EINVAL);
+
+	int fd = memfd_create("not_a_heap", MFD_CLOEXEC);
+	ASSERT_GE(fd, 0);
+	ASSERT_EQ(ftruncate(fd, HEAP_SIZE), 0);
+
+	errno = 0;
+	EXPECT_EQ(my_shm_attach_fd(fd), nullptr);
+	EXPECT_EQ(errno, EINVAL);
+
+	close(fd);
+}
+
+// the child is killed at some point while it allocates, if it held the mutex then, the next lock
+// recovers it, either way the heap stays usable
+TEST(MyShmHeap, deadProcess) {
+	struct my_shm_heap* heap = my_shm_create(nullptr, HEAP_SIZE);
+	ASSERT_NE(heap, nullptr);
+
+	pid_t pid = fork();
+	ASSERT_NE(pid, -1);
+
+	if(pid == 0) {
+		while(true) {
+			my_shm_offset_t offset = my_shm_malloc(heap, 128);
+			my_shm_free(heap, offset);
+		}
+	}
+
+	std::this_thread::sleep_for(std::chrono::milliseconds(20));
+	ASSERT_EQ(kill(pid, SIGKILL), 0);
+
+	int status = 0;
+	ASSERT_EQ(waitpid(pid, &status, 0), pid);
+	EXPECT_TRUE(WIFSIGNALED(status));
+
+	for(size_t i = 0; i < 100; ++i) {
+		my_shm_offset_t offset = my_shm_malloc(heap, 256);
+		ASSERT_NE(offset, 0U);
+		memset(my_shm_pointer(heap, offset), 1, 256);
+		my_shm_free(heap, offset);
+	}
+
+	my_shm_detach(heap);
+}
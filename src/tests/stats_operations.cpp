@@ -0,0 +1,139 @@
+
+#include <my_malloc.h>
+
+#include <stdlib.h>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+TEST(MyMalloc, statsOperations) {
+	my_allocator_init(POOL_SIZE, true);
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.mapped_bytes, POOL_SIZE);
+	EXPECT_EQ(stats.memory_blocks, 1U);
+	EXPECT_EQ(stats.mmap_calls, 1U);
+	EXPECT_EQ(stats.munmap_calls, 0U);
+	EXPECT_EQ(stats.used_blocks, 0U);
+	EXPECT_EQ(stats.free_blocks, 1U);
+	EXPECT_EQ(stats.largest_free_block, stats.free_bytes);
+	EXPECT_EQ(stats.fragmentation, 0.0);
+
+	void* ptr1 = my_malloc(1024);
+	void* ptr2 = my_malloc(1024);
+	void* ptr3 = my_malloc(1024);
+
+	// create a hole in front of the free rest of the memory block
+	my_free(ptr2);
+
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.used_blocks, 2U);
+	EXPECT_GE(stats.used_bytes, 2048U);
+	EXPECT_EQ(stats.free_blocks, 2U);
+	EXPECT_LT(stats.largest_free_block, stats.free_bytes);
+	EXPECT_GT(stats.fragmentation, 0.0);
+	EXPECT_LT(stats.fragmentation, 1.0);
+	EXPECT_EQ(stats.mmap_calls, 1U);
+
+	// bigger than the default memory block size, so it gets its own memory block
+	void* ptr4 = my_malloc(POOL_SIZE * 2);
+
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.memory_blocks, 2U);
+	EXPECT_EQ(stats.mmap_calls, 2U);
+	EXPECT_GT(stats.mapped_bytes, POOL_SIZE * 3);
+
+	my_free(ptr4);
+
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.memory_blocks, 1U);
+	EXPECT_EQ(stats.munmap_calls, 1U);
+	EXPECT_EQ(stats.mapped_bytes, POOL_SIZE);
+
+	my_free(ptr1);
+	my_free(ptr3);
+
+	// the empty memory block is unmapped
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.memory_blocks, 0U);
+	EXPECT_EQ(stats.mapped_bytes, 0U);
+	EXPECT_EQ(stats.used_bytes, 0U);
+	EXPECT_EQ(stats.free_bytes, 0U);
+
+	my_allocator_destroy();
+}
+
+// the used bytes and blocks are counted, they have to stay the same as the ones of the walk
+static void expectCountersMatchTheWalk() {
+	uint64_t usedBytes = 0;
+	uint64_t usedBlocks = 0;
+
+	for(const struct my_heap_block_info& info : walkBlocks()) {
+		if(!info.free) {
+			usedBytes += info.size;
+			usedBlocks++;
+		}
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+
+	EXPECT_EQ(stats.used_bytes, usedBytes);
+	EXPECT_EQ(stats.used_blocks, usedBlocks);
+}
+
+TEST(MyMalloc, statsCounters) {
+	my_allocator_init(POOL_SIZE, true);
+
+	// a small block goes into a fastbin and is taken out of it again
+	void* small = my_malloc(32);
+	void* big = my_malloc(4096);
+	my_free(small);
+	expectCountersMatchTheWalk();
+	small = my_malloc(32);
+	expectCountersMatchTheWalk();
+
+	// resized in place, into the free rest after it, and split again
+	big = my_realloc(big, 8192);
+	expectCountersMatchTheWalk();
+	big = my_realloc(big, 6000);
+	expectCountersMatchTheWalk();
+
+	void* aligned = my_memalign(4096, 1000);
+	ASSERT_NE(aligned, nullptr);
+	expectCountersMatchTheWalk();
+
+	// the last block of its own memory block
+	void* huge = my_malloc(POOL_SIZE * 2);
+	expectCountersMatchTheWalk();
+	my_free(huge);
+	expectCountersMatchTheWalk();
+
+	my_free(aligned);
+	my_free(big);
+	my_free(small);
+	expectCountersMatchTheWalk();
+
+	// blocks, that are still allocated, are gone after destroy
+	my_allocator_destroy();
+	my_allocator_init(POOL_SIZE, true);
+	my_malloc(64);
+	my_allocator_destroy();
+	my_allocator_init(POOL_SIZE, true);
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 0U);
+	EXPECT_EQ(stats.used_bytes, 0U);
+
+	my_allocator_destroy();
+}
@@ -0,0 +1,215 @@
+#include <my_malloc.h>
+
+#include <stdlib.h>
+#include <string.h>
+
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#include "test_helpers.hpp"
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+#define THREAD_COUNT 4U
+
+// the memory blocks aren't merged, so that the blocks are in different ones
+static void initSeparate(bool forceAlloc) {
+	struct my_allocator_options options = defaultOptions(POOL_SIZE, forceAlloc);
+	options.separate_memory_blocks = true;
+
+	my_allocator_init_ex(&options);
+}
+
+// the blocks of every thread fill more than one memory block, so the threads free in different
+// memory blocks, and in the same one at the borders, while the main thread allocates and frees
+TEST(MyMallocStripes, parallelFrees) {
+	initSeparate(true);
+
+	const size_t blockCount = 512;
+	const uint64_t blockSize = 16384;
+
+	std::vector<std::vector<unsigned char*>> pointers(THREAD_COUNT);
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		for(size_t j = 0; j < blockCount; ++j) {
+			unsigned char* ptr = static_cast<unsigned char*>(my_malloc(blockSize));
+			ASSERT_NE(ptr, nullptr);
+			memset(ptr, static_cast<int>(i + 1), blockSize);
+			pointers[i].push_back(ptr);
+		}
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_GT(stats.memory_blocks, THREAD_COUNT);
+
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		threads.emplace_back([i, &pointers]() {
+			for(unsigned char* ptr : pointers[i]) {
+				ASSERT_EQ(ptr[0], static_cast<unsigned char>(i + 1));
+				ASSERT_EQ(ptr[blockSize - 1], static_cast<unsigned char>(i + 1));
+				my_free(ptr);
+			}
+		});
+	}
+
+	for(size_t i = 0; i < 10000; ++i) {
+		unsigned char* ptr = static_cast<unsigned char*>(my_malloc(16 + i % 512));
+		ASSERT_NE(ptr, nullptr);
+		memset(ptr, 0xFF, 16);
+		my_free(ptr);
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	// every memory block was emptied, so all of them are released, after the small blocks of the
+	// main thread are merged
+	my_allocator_trim();
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 0U);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+
+	my_allocator_destroy();
+}
+
+// every big block gets its own memory block, so every free releases one, with the mutex, while the
+// other threads free in their stripes
+TEST(MyMallocStripes, releaseWhileFreeing) {
+	my_allocator_init(POOL_SIZE, true);
+
+	void* guard = my_malloc(1024);
+
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		threads.emplace_back([]() {
+			for(size_t j = 0; j < 200; ++j) {
+				unsigned char* big = static_cast<unsigned char*>(my_malloc(POOL_SIZE * 2));
+				ASSERT_NE(big, nullptr);
+				big[POOL_SIZE] = 1;
+
+				unsigned char* small = static_cast<unsigned char*>(my_malloc(2048));
+				ASSERT_NE(small, nullptr);
+
+				my_free(big);
+				my_free(small);
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, 1U);
+	EXPECT_EQ(stats.memory_blocks, 1U);
+
+	my_free(guard);
+	my_allocator_destroy();
+}
+
+// the threads map new memory blocks at the same time, without the mutex, a memory block, that was
+// mapped, but wasn't needed anymore, is unmapped again, so the counters stay exact, realloc and
+// memalign map them the same way, like malloc
+TEST(MyMallocStripes, concurrentGrowth) {
+	initSeparate(false);
+
+	const size_t blockCount = 16;
+
+	std::vector<std::vector<unsigned char*>> pointers(THREAD_COUNT);
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		threads.emplace_back([i, &pointers]() {
+			for(size_t j = 0; j < blockCount; ++j) {
+				unsigned char* ptr = nullptr;
+
+				if(j % 3 == 0) {
+					ptr = static_cast<unsigned char*>(my_malloc(POOL_SIZE / 4));
+				} else if(j % 3 == 1) {
+					ptr = static_cast<unsigned char*>(my_memalign(4096, POOL_SIZE / 4));
+					EXPECT_EQ(reinterpret_cast<uintptr_t>(ptr) % 4096, 0U);
+				} else {
+					ptr = static_cast<unsigned char*>(my_malloc(64));
+					ASSERT_NE(ptr, nullptr);
+					memset(ptr, static_cast<int>(i + 1), 64);
+					ptr = static_cast<unsigned char*>(my_realloc(ptr, POOL_SIZE / 4));
+					ASSERT_NE(ptr, nullptr);
+					EXPECT_EQ(ptr[63], static_cast<unsigned char>(i + 1));
+				}
+
+				ASSERT_NE(ptr, nullptr);
+				memset(ptr, static_cast<int>(i + 1), POOL_SIZE / 4);
+				pointers[i].push_back(ptr);
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	struct my_malloc_stats stats;
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.used_blocks, THREAD_COUNT * blockCount);
+	EXPECT_EQ(stats.mapped_bytes, stats.memory_blocks * POOL_SIZE);
+
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		for(unsigned char* ptr : pointers[i]) {
+			EXPECT_EQ(ptr[POOL_SIZE / 4 - 1], static_cast<unsigned char>(i + 1));
+			my_free(ptr);
+		}
+	}
+
+	my_allocator_stats(&stats);
+	EXPECT_EQ(stats.mapped_bytes, 0U);
+	EXPECT_EQ(stats.memory_blocks, 0U);
+
+	my_allocator_destroy();
+}
+
+// the usable size only locks the stripe of the block, so the other threads free at the same time,
+// the size of the last block of a memory block comes from the end of the memory block
+TEST(MyMallocStripes, usableSize) {
+	initSeparate(true);
+
+	void* small = my_malloc(100);
+	void* big = my_malloc(POOL_SIZE * 2);
+	ASSERT_NE(small, nullptr);
+	ASSERT_NE(big, nullptr);
+
+	const uint64_t smallSize = my_malloc_usable_size(small);
+	EXPECT_GE(smallSize, 100U);
+	EXPECT_LT(smallSize, 200U);
+
+	const uint64_t bigSize = my_malloc_usable_size(big);
+	EXPECT_GE(bigSize, POOL_SIZE * 2);
+	EXPECT_LT(bigSize, POOL_SIZE * 2 + 4096);
+
+	std::vector<std::thread> threads;
+	for(size_t i = 0; i < THREAD_COUNT; ++i) {
+		threads.emplace_back([]() {
+			for(size_t j = 0; j < 1000; ++j) {
+				my_free(my_malloc(64 + (j % 512)));
+			}
+		});
+	}
+
+	for(size_t j = 0; j < 1000; ++j) {
+		EXPECT_EQ(my_malloc_usable_size(small), smallSize);
+		EXPECT_EQ(my_malloc_usable_size(big), bigSize);
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	my_free(small);
+	my_free(big);
+
+	my_allocator_destroy();
+}
@@ -0,0 +1,32 @@
+// header include guard
+#ifndef _MY_MALLOC_TEST_HELPERS_HPP_
+#define _MY_MALLOC_TEST_HELPERS_HPP_
+
+#include <my_malloc.h>
+
+#include <vector>
+
+// the options of my_allocator_init, the tests change the ones, that they need, and pass them to
+// my_allocator_init_ex
+static inline struct my_allocator_options defaultOptions(uint64_t memoryBlockSize,
+                                                         bool forceAlloc) {
+	struct my_allocator_options options = {};
+	options.memory_block_size = memoryBlockSize;
+	options.force_alloc = forceAlloc;
+	options.fit = MY_MALLOC_FIT_BEST;
+
+	return options;
+}
+
+// every block of the heap, in the order of my_heap_walk
+static inline std::vector<struct my_heap_block_info> walkBlocks() {
+	std::vector<struct my_heap_block_info> blocks;
+	my_heap_walk(
+	    [](const struct my_heap_block_info* info, void* ctx) {
+		    static_cast<std::vector<struct my_heap_block_info>*>(ctx)->push_back(*info);
+	    },
+	    &blocks);
+	return blocks;
+}
+
+#endif
@@ -0,0 +1,299 @@
+
+#include <my_malloc.h>
+
+#include <stdlib.h>
+
+#include <atomic>
+#include <functional>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+// the allocator is initialized once in the main thread, every other thread has to initialize its
+// own heap lazily on the first allocation
+
+TEST(MyMallocThreadLocal, lazyInitializationInThreads) {
+	my_allocator_init(POOL_SIZE, false);
+
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < 8; ++i) {
+		threads.emplace_back([i]() {
+			std::vector<void*> pointers;
+
+			for(size_t j = 0; j < 500; ++j) {
+				void* ptr = my_malloc(16 + ((i * j) % 1000));
+				ASSERT_NE(ptr, nullptr);
+				memset(ptr, 0xAB, 16 + ((i * j) % 1000));
+				pointers.push_back(ptr);
+			}
+
+			for(void* ptr : pointers) {
+				my_free(ptr);
+			}
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocThreadLocal, blocksOfExitedThreads) {
+	my_allocator_init(POOL_SIZE, false);
+
+	std::vector<unsigned char*> pointers(4, nullptr);
+
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < pointers.size(); ++i) {
+		threads.emplace_back([i, &pointers]() {
+			// one bigger than the default memory block size, so that it gets its own
+			pointers[i] = static_cast<unsigned char*>(my_malloc(i == 0 ? POOL_SIZE * 2 : 1024));
+			memset(pointers[i], static_cast<int>(i + 1), 1024);
+
+			// this is freed at the exit of the thread, since it isn't used anymore
+			my_free(my_malloc(512));
+		});
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	// the memory blocks of the threads are still valid after they exited
+	for(size_t i = 0; i < pointers.size(); ++i) {
+		for(size_t j = 0; j < 1024; ++j) {
+			EXPECT_EQ(pointers[i][j], i + 1);
+		}
+
+		EXPECT_GE(my_malloc_usable_size(pointers[i]), 1024U);
+	}
+
+	// an orphaned block is moved into this thread on realloc
+	unsigned char* moved = static_cast<unsigned char*>(my_realloc(pointers[1], 4096));
+	ASSERT_NE(moved, nullptr);
+	for(size_t j = 0; j < 1024; ++j) {
+		EXPECT_EQ(moved[j], 2);
+	}
+
+	my_free(moved);
+	my_free(pointers[0]);
+	my_free(pointers[2]);
+	my_free(pointers[3]);
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocThreadLocal, freeInOtherThreadAfterExit) {
+	my_allocator_init(POOL_SIZE, false);
+
+	void* ptr = nullptr;
+
+	std::thread([&ptr]() { ptr = my_malloc(2048); }).join();
+
+	ASSERT_NE(ptr, nullptr);
+
+	// freeing in another thread, than the main thread
+	std::thread([ptr]() { my_free(ptr); }).join();
+
+	// the memory block was unmapped with the free, so this is a double free now
+	EXPECT_EXIT({ my_free(ptr); }, ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to free a already freed Block: 0x[0-9a-fA-F]{2,16}");
+
+	my_allocator_destroy();
+}
+
+// passes a block of another thread, that is still running, to use, the thread frees it, after use
+// returned
+static void withBlockOfRunningThread(const std::function<void(void*)>& use) {
+	my_allocator_init(POOL_SIZE, false);
+
+	std::atomic<void*> ptr{ nullptr };
+	std::atomic<bool> done{ false };
+
+	std::thread thread([&ptr, &done]() {
+		ptr = my_malloc(64);
+
+		while(!done) {
+			std::this_thread::yield();
+		}
+
+		my_free(ptr);
+	});
+
+	while(ptr == nullptr) {
+		std::this_thread::yield();
+	}
+
+	// this thread has its own blocks of the same size, so the pointer could be put into its free
+	// lists
+	void* own = my_malloc(64);
+
+	use(ptr);
+
+	my_free(own);
+
+	done = true;
+	thread.join();
+
+	my_allocator_destroy();
+}
+
+// every thread has its own free lists, so the block would be given out by both threads afterwards
+TEST(MyMallocThreadLocal, blocksOfRunningThreads) {
+	EXPECT_EXIT(withBlockOfRunningThread([](void* ptr) { my_free(ptr); }),
+	            ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to free a pointer, that isn't a block of the allocator: "
+	            "0x[0-9a-fA-F]{2,16}");
+
+	EXPECT_EXIT(withBlockOfRunningThread([](void* ptr) { my_realloc(ptr, 128); }),
+	            ::testing::ExitedWithCode(1),
+	            "ERROR: You tried to realloc a pointer, that isn't a block of the allocator: "
+	            "0x[0-9a-fA-F]{2,16}");
+}
+
+TEST(MyMallocThreadLocal, emptyMemoryBlocksAreShared) {
+	// another size, than in the other tests, so that no memory block of them is reused here
+	my_allocator_init(POOL_SIZE * 2, false);
+
+	void* firstPtr = nullptr;
+	void* secondPtr = nullptr;
+
+	// the thread keeps its last empty memory block until it exits, then it is given to the pool
+	std::thread([&firstPtr]() {
+		firstPtr = my_malloc(1024);
+		my_free(firstPtr);
+	}).join();
+
+	std::thread([&secondPtr]() {
+		secondPtr = my_malloc(1024);
+		my_free(secondPtr);
+	}).join();
+
+	EXPECT_NE(firstPtr, nullptr);
+	EXPECT_EQ(firstPtr, secondPtr);
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocThreadLocal, destroyUnmapsThePool) {
+	// another size, than in the other tests, so that no pooled memory block is reused here
+	my_allocator_init(POOL_SIZE * 5, false);
+
+	// the empty memory blocks of both threads are given to the pool, when they exit, the main
+	// thread may take one of them in my_allocator_init
+	std::thread([]() {
+		void* ptr = my_malloc(1024);
+		std::thread([]() { my_free(my_malloc(1024)); }).join();
+		my_free(ptr);
+	}).join();
+
+	my_allocator_destroy();
+
+	my_allocator_init(POOL_SIZE * 5, false);
+
+	struct my_malloc_stats before;
+	my_allocator_stats(&before);
+
+	// the pool was unmapped, so the thread maps a new memory block
+	std::thread([]() { my_free(my_malloc(1024)); }).join();
+
+	struct my_malloc_stats after;
+	my_allocator_stats(&after);
+
+	EXPECT_EQ(after.mmap_calls - before.mmap_calls, 1U);
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocThreadLocal, statsOfAllThreads) {
+	// another size, than in the other tests, so that no pooled memory block is reused here
+	my_allocator_init(POOL_SIZE * 3, false);
+
+	struct my_malloc_stats before;
+	my_allocator_stats(&before);
+
+	std::vector<void*> pointers(4, nullptr);
+
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < pointers.size(); ++i) {
+		threads.emplace_back([i, &pointers]() { pointers[i] = my_malloc(1024); });
+	}
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	struct my_malloc_stats after;
+	my_allocator_stats(&after);
+
+	// the counters of exited threads are still counted, and their blocks are visible
+	EXPECT_EQ(after.mmap_calls - before.mmap_calls, pointers.size());
+	EXPECT_EQ(after.memory_blocks - before.memory_blocks, pointers.size());
+	EXPECT_EQ(after.mapped_bytes - before.mapped_bytes, pointers.size() * POOL_SIZE * 3);
+	EXPECT_EQ(after.used_blocks - before.used_blocks, pointers.size());
+
+	for(void* ptr : pointers) {
+		my_free(ptr);
+	}
+
+	my_allocator_destroy();
+}
+
+TEST(MyMallocThreadLocal, statsOfRunningThreads) {
+	my_allocator_init(POOL_SIZE, false);
+
+	struct my_malloc_stats before;
+	my_allocator_stats(&before);
+
+	const size_t numThreads = 4;
+	std::atomic<size_t> allocated = 0;
+	std::atomic<bool> done = false;
+
+	std::vector<std::thread> threads;
+
+	for(size_t i = 0; i < numThreads; ++i) {
+		threads.emplace_back([&allocated, &done]() {
+			void* ptr = my_malloc(1024);
+			allocated++;
+
+			while(!done) {
+				std::this_thread::yield();
+			}
+
+			my_free(ptr);
+		});
+	}
+
+	while(allocated != numThreads) {
+		std::this_thread::yield();
+	}
+
+	// the block lists of the other threads aren't walked, but their used blocks are counted
+	struct my_malloc_stats during;
+	my_allocator_stats(&during);
+
+	EXPECT_EQ(during.used_blocks - before.used_blocks, numThreads);
+	EXPECT_GE(during.used_bytes - before.used_bytes, numThreads * 1024);
+
+	done = true;
+
+	for(auto& thread : threads) {
+		thread.join();
+	}
+
+	struct my_malloc_stats after;
+	my_allocator_stats(&after);
+
+	EXPECT_EQ(after.used_blocks, before.used_blocks);
+	EXPECT_EQ(after.used_bytes, before.used_bytes);
+
+	my_allocator_destroy();
+}
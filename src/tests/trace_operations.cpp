@@ -0,0 +1,121 @@
+#include <my_malloc.h>
+#include <trace_format.h>
+
+#include <fcntl.h>
+#include <stdlib.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include <algorithm>
+#include <thread>
+#include <vector>
+
+#include <gtest/gtest.h>
+
+#define POOL_SIZE ((uint64_t)(1024U * 1024U * 4U))
+
+// reads the records of the trace, without the unused ones, in the global order
+static std::vector<TraceRecord> readTrace(const char* path, TraceFileHeader* header) {
+	std::vector<TraceRecord> records;
+
+	int fd = open(path, O_RDONLY);
+	EXPECT_GE(fd, 0);
+
+	EXPECT_EQ(pread(fd, header, sizeof(*header), 0), (ssize_t)sizeof(*header));
+
+	struct stat fileStat;
+	EXPECT_EQ(fstat(fd, &fileStat), 0);
+
+	const uint64_t fileSize = (uint64_t)fileStat.st_size;
+
+	for(uint64_t offset = header->dataOffset; offset + sizeof(TraceRecord) <= fileSize;
+	    offset += sizeof(TraceRecord)) {
+		TraceRecord record;
+		EXPECT_EQ(pread(fd, &record, sizeof(record), (off_t)offset), (ssize_t)sizeof(record));
+
+		if(record.operation != TRACE_NONE) {
+			records.push_back(record);
+		}
+	}
+
+	close(fd);
+
+	std::stable_sort(records.begin(), records.end(),
+	                 [](const TraceRecord& first, const TraceRecord& second) {
+		                 return first.timestamp < second.timestamp;
+	                 });
+
+	return records;
+}
+
+TEST(MyMalloc, traceOperations) {
+	my_allocator_init(POOL_SIZE, true);
+
+	char path[] = "/tmp/my_malloc_trace_XXXXXX";
+	int tempFd = mkstemp(path);
+	ASSERT_GE(tempFd, 0);
+	close(tempFd);
+
+	// not recorded
+	my_free(my_malloc(64));
+
+	ASSERT_EQ(my_malloc_trace_start(path), 0);
+
+	void* ptr1 = my_malloc(100);
+	void* ptr2 = my_realloc(ptr1, 5000);
+	void* ptr3 = my_memalign(4096, 300);
+
+	void* ptr4 = nullptr;
+	std::thread([&ptr4]() { ptr4 = my_malloc(200); }).join();
+
+	my_free(ptr4);
+	my_free(ptr2);
+	my_free(ptr3);
+
+	my_malloc_trace_stop();
+
+	// not recorded
+	my_free(my_malloc(64));
+
+	TraceFileHeader header;
+	std::vector<TraceRecord> records = readTrace(path, &header);
+	unlink(path);
+
+	EXPECT_EQ(header.magic, TRACE_MAGIC);
+	EXPECT_EQ(header.version, (uint32_t)TRACE_VERSION);
+	EXPECT_EQ(header.recordSize, sizeof(TraceRecord));
+
+	ASSERT_EQ(records.size(), 8U);
+
+	EXPECT_EQ(records[0].operation, TRACE_MALLOC);
+	EXPECT_EQ(records[0].ptr, (uint64_t)ptr1);
+	EXPECT_EQ(records[0].size, 100U);
+
+	// the old block is recorded before it is freed, the new one after it was allocated
+	EXPECT_EQ(records[1].operation, TRACE_REALLOC_OLD);
+	EXPECT_EQ(records[1].ptr, (uint64_t)ptr1);
+
+	EXPECT_EQ(records[2].operation, TRACE_REALLOC);
+	EXPECT_EQ(records[2].ptr, (uint64_t)ptr2);
+	EXPECT_EQ(records[2].argument, (uint64_t)ptr1);
+	EXPECT_EQ(records[2].size, 5000U);
+
+	EXPECT_EQ(records[3].operation, TRACE_MEMALIGN);
+	EXPECT_EQ(records[3].ptr, (uint64_t)ptr3);
+	EXPECT_EQ(records[3].argument, 4096U);
+	EXPECT_EQ(records[3].size, 300U);
+
+	// the allocation of the other thread and its free in this thread
+	EXPECT_EQ(records[4].operation, TRACE_MALLOC);
+	EXPECT_EQ(records[4].ptr, (uint64_t)ptr4);
+	EXPECT_NE(records[4].thread, records[0].thread);
+
+	EXPECT_EQ(records[5].operation, TRACE_FREE);
+	EXPECT_EQ(records[5].ptr, (uint64_t)ptr4);
+	EXPECT_EQ(records[5].thread, records[0].thread);
+
+	EXPECT_EQ(records[6].operation, TRACE_FREE);
+	EXPECT_EQ(records[7].operation, TRACE_FREE);
+
+	my_allocator_destroy();
+}